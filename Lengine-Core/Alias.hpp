@@ -1,11 +1,145 @@
 #pragma once
+#include <unordered_map>
+#include <vector>
+
 #include "Component.hpp"
 #include "Name.hpp"
 
+// GameObjects found through an index. Views point into the index itself, so they are only valid until
+// the next GameObject is named, tagged, moved between layers, created or destroyed.
+class AliasView
+{
+public:
+
+	AliasView() = default;
+
+	AliasView( const GameObjectID* a_Begin, const GameObjectID* a_End )
+		: m_Begin( a_Begin )
+		, m_End( a_End )
+	{ }
+
+	inline const GameObjectID* begin() const { return m_Begin; }
+	inline const GameObjectID* end() const { return m_End; }
+	inline size_t size() const { return m_End - m_Begin; }
+	inline bool empty() const { return m_Begin == m_End; }
+	inline GameObjectID operator []( size_t a_Index ) const { return m_Begin[ a_Index ]; }
+
+private:
+
+	const GameObjectID* m_Begin = nullptr;
+	const GameObjectID* m_End = nullptr;
+};
+
+// Set of GameObjects kept contiguous for viewing. Adding, removing and checking are constant time,
+// removing swaps the last GameObject into the gap.
+class AliasIndex
+{
+public:
+
+	inline void Add( GameObjectID a_ID )
+	{
+		if ( m_Slots.emplace( a_ID, static_cast< uint32_t >( m_Objects.size() ) ).second )
+		{
+			m_Objects.push_back( a_ID );
+		}
+	}
+
+	inline void Remove( GameObjectID a_ID )
+	{
+		auto Found = m_Slots.find( a_ID );
+
+		if ( Found == m_Slots.end() )
+		{
+			return;
+		}
+
+		GameObjectID Last = m_Objects.back();
+		m_Objects[ Found->second ] = Last;
+		m_Slots[ Last ] = Found->second;
+		m_Objects.pop_back();
+		m_Slots.erase( a_ID );
+	}
+
+	inline bool Contains( GameObjectID a_ID ) const
+	{
+		return m_Slots.find( a_ID ) != m_Slots.end();
+	}
+
+	inline bool Empty() const
+	{
+		return m_Objects.empty();
+	}
+
+	inline AliasView View() const
+	{
+		return AliasView( m_Objects.data(), m_Objects.data() + m_Objects.size() );
+	}
+
+private:
+
+	std::vector< GameObjectID >                  m_Objects;
+	std::unordered_map< GameObjectID, uint32_t > m_Slots;
+};
+
+// Names, tags and layer of a GameObject. Every live Alias is indexed by each of them, so finding
+// GameObjects by any of them costs the same however large the scene is.
 DefineComponent( Alias, Component )
 {
 public:
 
+	static constexpr uint8_t LayerCount = 32;
+
+	IAlias() = default;
+
+	// Copies, such as prototypes and clones, are not indexed until they are added to a GameObject.
+	IAlias( const IAlias& a_Other )
+		: IComponent< IAlias< T > >( a_Other )
+		, m_Name( a_Other.m_Name )
+		, m_Tags( a_Other.m_Tags )
+		, m_Layer( a_Other.m_Layer )
+	{ }
+
+	IAlias( IAlias&& ) = default;
+	IAlias& operator=( IAlias&& ) = default;
+
+	// Keeps the GameObject this Alias belongs to, and whether it is indexed, moving it to the copied
+	// name, tags and layer.
+	IAlias& operator=( const IAlias& a_Other )
+	{
+		if ( this == &a_Other )
+		{
+			return *this;
+		}
+
+		bool Indexed = m_Indexed;
+
+		if ( Indexed )
+		{
+			UnindexAll();
+		}
+
+		m_Name = a_Other.m_Name;
+		m_Tags = a_Other.m_Tags;
+		m_Layer = a_Other.m_Layer;
+
+		if ( Indexed )
+		{
+			IndexAll();
+		}
+
+		return *this;
+	}
+
+	void OnCreate()
+	{
+		IndexAll();
+	}
+
+	void OnDestroy()
+	{
+		UnindexAll();
+	}
+
 	const Name& GetName() const
 	{
 		return m_Name;
@@ -13,15 +147,150 @@ public:
 
 	void SetName( const Name& a_Name )
 	{
+		if ( m_Indexed )
+		{
+			Unindex( s_Names, m_Name.HashCode() );
+			s_Names[ a_Name.HashCode() ].Add( this->GetOwnerID() );
+		}
+
 		m_Name = a_Name;
 	}
 
+	inline bool HasTag( Hash a_Tag ) const
+	{
+		return std::find( m_Tags.begin(), m_Tags.end(), a_Tag ) != m_Tags.end();
+	}
+
+	void AddTag( Hash a_Tag )
+	{
+		if ( HasTag( a_Tag ) )
+		{
+			return;
+		}
+
+		m_Tags.push_back( a_Tag );
+
+		if ( m_Indexed )
+		{
+			s_Tags[ a_Tag ].Add( this->GetOwnerID() );
+		}
+	}
+
+	void RemoveTag( Hash a_Tag )
+	{
+		auto Found = std::find( m_Tags.begin(), m_Tags.end(), a_Tag );
+
+		if ( Found == m_Tags.end() )
+		{
+			return;
+		}
+
+		m_Tags.erase( Found );
+
+		if ( m_Indexed )
+		{
+			Unindex( s_Tags, a_Tag );
+		}
+	}
+
+	inline uint8_t GetLayer() const
+	{
+		return m_Layer;
+	}
+
+	void SetLayer( uint8_t a_Layer )
+	{
+		a_Layer %= LayerCount;
+
+		if ( m_Indexed )
+		{
+			s_Layers[ m_Layer ].Remove( this->GetOwnerID() );
+			s_Layers[ a_Layer ].Add( this->GetOwnerID() );
+		}
+
+		m_Layer = a_Layer;
+	}
+
+	// Whether the layer is one of those set in a_Layers, with bit n standing for layer n.
+	inline bool IsInLayers( uint32_t a_Layers ) const
+	{
+		return ( a_Layers >> m_Layer ) & 1u;
+	}
+
+	// Checks the index rather than the component, so it can be asked about any GameObject.
+	inline static bool HasTag( GameObjectID a_ID, Hash a_Tag )
+	{
+		auto Found = s_Tags.find( a_Tag );
+		return Found != s_Tags.end() && Found->second.Contains( a_ID );
+	}
+
+	static AliasView FindAllByName( Hash a_Name )
+	{
+		auto Found = s_Names.find( a_Name );
+		return Found == s_Names.end() ? AliasView() : Found->second.View();
+	}
+
+	static AliasView FindByTag( Hash a_Tag )
+	{
+		auto Found = s_Tags.find( a_Tag );
+		return Found == s_Tags.end() ? AliasView() : Found->second.View();
+	}
+
+	static AliasView FindByLayer( uint8_t a_Layer )
+	{
+		return s_Layers[ a_Layer % LayerCount ].View();
+	}
+
 private:
 
+	// Any GameObject with the name, when there are several.
 	static GameObjectID FindByName( Hash a_Name )
 	{
-		// Implementation required
-		return GameObjectID( -1 );
+		AliasView Found = FindAllByName( a_Name );
+		return Found.empty() ? GameObjectID( -1 ) : Found[ 0 ];
+	}
+
+	void IndexAll()
+	{
+		m_Indexed = true;
+		s_Names[ m_Name.HashCode() ].Add( this->GetOwnerID() );
+		s_Layers[ m_Layer ].Add( this->GetOwnerID() );
+
+		for ( Hash Tag : m_Tags )
+		{
+			s_Tags[ Tag ].Add( this->GetOwnerID() );
+		}
+	}
+
+	void UnindexAll()
+	{
+		Unindex( s_Names, m_Name.HashCode() );
+		s_Layers[ m_Layer ].Remove( this->GetOwnerID() );
+
+		for ( Hash Tag : m_Tags )
+		{
+			Unindex( s_Tags, Tag );
+		}
+
+		m_Indexed = false;
+	}
+
+	// Empty entries are dropped, so renamed and untagged GameObjects don't leave them behind.
+	inline void Unindex( std::unordered_map< Hash, AliasIndex >& a_Map, Hash a_Key )
+	{
+		auto Found = a_Map.find( a_Key );
+
+		if ( Found == a_Map.end() )
+		{
+			return;
+		}
+
+		Found->second.Remove( this->GetOwnerID() );
+
+		if ( Found->second.Empty() )
+		{
+			a_Map.erase( Found );
+		}
 	}
 
 	friend class GameObject;
@@ -38,7 +307,9 @@ private:
 	template < typename _Deserializer >
 	void Deserialize( _Deserializer& a_Deserializer )
 	{
-		a_Deserializer >> m_Name;
+		Name Loaded;
+		a_Deserializer >> Loaded;
+		SetName( Loaded );
 	}
 
 	template < typename _Sizer >
@@ -47,7 +318,13 @@ private:
 		a_Sizer & m_Name;
 	}
 
+	inline static std::unordered_map< Hash, AliasIndex > s_Names;
+	inline static std::unordered_map< Hash, AliasIndex > s_Tags;
+	inline static AliasIndex                             s_Layers[ LayerCount ];
 
-	Name m_Name;
-	bool m_ToDestroy;
-};
\ No newline at end of file
+	Name                m_Name;
+	std::vector< Hash > m_Tags;
+	uint8_t             m_Layer = 0;
+	bool                m_Indexed = false;
+	bool                m_ToDestroy = false;
+};
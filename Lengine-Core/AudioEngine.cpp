@@ -13,11 +13,11 @@ void AudioEngine::Init()
 
 void AudioEngine::Tick()
 {
-    auto audioSources = Component::GetExactComponents<AudioSource>();
-    for (auto& audioSource : audioSources)
+    // Sources and their transforms are walked together rather than looked up one by one.
+    Component::GetGroup<AudioSource, Transform>().each([](AudioSource& audioSource, const Transform& transform)
     {
-        UpdateAudioSourcePosition(audioSource->GetHandle(), *audioSource->GetTransform());
-    }
+        UpdateAudioSourcePosition(audioSource.GetHandle(), transform);
+    });
 
     auto audioListeners = Component::GetExactComponents<AudioListener>();
     _STL_ASSERT(audioListeners.size() <= 1, "Only one audio listener allowed!");
@@ -1,10 +1,14 @@
 #include "../../Rendering.hpp"
 #include "../../ConsoleGL.hpp"
 #include "../../Shader.hpp"
+#include "../../RenderingState.hpp"
+#include "../../Residency.hpp"
 
 uint32_t            ActiveModelTransformLocation = 0;
 uint32_t            ActivePVMTransformLocation   = 0;
 ShaderProgramHandle ActiveShaderProgram          = 0;
+ArrayHandle         ActiveArrayHandle            = 0;
+BufferHandle        InstanceBufferHandle         = 0;
 
 
 void Rendering::Init()
@@ -15,6 +19,19 @@ void Rendering::Init()
 	ConsoleGL::CullFace( ConsoleGL::CullFaceMode::BACK );
 	ConsoleGL::ClearDepth( 1000.0f );
 	ConsoleGL::ClearColour( 0.0, 0.0, 0.0, 1.0f );
+
+	Residency::Init( []( ResidencyEntry& a_Entry )
+	{
+		if ( a_Entry.ResourceType == ResidencyEntry::Type::MESH )
+		{
+			ConsoleGL::DeleteVertexArrays( 1, &a_Entry.Handles[ 0 ] );
+			ConsoleGL::DeleteBuffers( 6, &a_Entry.Handles[ 1 ] );
+		}
+		else
+		{
+			ConsoleGL::DeleteTextures( 1, &a_Entry.Handles[ 0 ] );
+		}
+	} );
 }
 
 void Rendering::Clear()
@@ -94,38 +111,44 @@ void Rendering::CompileProgram( const std::string& a_Source, ShaderProgramHandle
 
 void Rendering::DeleteProgram( ShaderProgramHandle a_ShaderProgramHandle )
 {
+	RenderingState::ForgetProgram( a_ShaderProgramHandle );
 	ConsoleGL::DeleteProgram( a_ShaderProgramHandle );
 }
 
 void Rendering::ApplyMesh( const Mesh& a_Mesh )
 {
-	static ArrayHandle ActiveArrayHandle = 0;
-
-	// First check if an array exists.
-	if ( !ActiveArrayHandle )
+	if ( !RenderingState::ShouldBindMesh( &a_Mesh ) )
 	{
-		ConsoleGL::GenVertexArrays( 1, &ActiveArrayHandle );
+		return;
 	}
 
-	static BufferHandle ActiveBufferHandles[ 6 ] { 0 };
+	bool Upload;
+	ResidencyEntry& Entry = Residency::Acquire( ResidencyEntry::Type::MESH, a_Mesh, Residency::GetSize( a_Mesh ), Upload );
+	BufferHandle* BufferHandles = Entry.Handles + 1;
 
-	// First check that there's at least 6 buffer handles available for all mesh attributes.
-	for ( uint32_t i = 0; i < 6; ++i )
+	// First use of this mesh, create an array and a buffer for all mesh attributes.
+	if ( !Entry.Handles[ 0 ] )
 	{
-		if ( !ActiveBufferHandles[ i ] )
-		{
-			ConsoleGL::GenBuffers( 1, &ActiveBufferHandles[ i ] );
-		}
+		ConsoleGL::GenVertexArrays( 1, &Entry.Handles[ 0 ] );
+		ConsoleGL::GenBuffers( 6, BufferHandles );
 	}
 
-	// Bind the active array handle so all subsequent operations operate on it.
+	// The array remembers its attribute setup, so binding it is enough unless the mesh changed.
+	ActiveArrayHandle = Entry.Handles[ 0 ];
 	ConsoleGL::BindVertexArray( ActiveArrayHandle );
+	Rendering::ActiveMesh = &a_Mesh;
+
+	if ( !Upload )
+	{
+		return;
+	}
+
 	uint32_t VertexCount = a_Mesh.GetVertexCount();
 
 	// Setup all of the attributes.
 	if ( a_Mesh.HasPositions() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 0 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 0 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector3 ), a_Mesh.GetPositions(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 0, 3, ConsoleGL::DataType::FLOAT, false, sizeof( Vector3 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 0 );
@@ -133,7 +156,7 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	if ( a_Mesh.HasTexels() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 1 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 1 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector2 ), a_Mesh.GetTexels(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 1, 2, ConsoleGL::DataType::FLOAT, false, sizeof( Vector2 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 1 );
@@ -141,7 +164,7 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	if ( a_Mesh.HasColours() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 2 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 2 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector4 ), a_Mesh.GetColours(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 2, 4, ConsoleGL::DataType::FLOAT, false, sizeof( Vector4 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 2 );
@@ -149,7 +172,7 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	if ( a_Mesh.HasNormals() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 3 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 3 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector3 ), a_Mesh.GetNormals(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 3, 3, ConsoleGL::DataType::FLOAT, false, sizeof( Vector3 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 3 );
@@ -157,7 +180,7 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	if ( a_Mesh.HasTangents() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 4 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 4 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector3 ), a_Mesh.GetTangents(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 4, 3, ConsoleGL::DataType::FLOAT, false, sizeof( Vector3 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 4 );
@@ -165,7 +188,7 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	if ( a_Mesh.HasBitangents() )
 	{
-		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, ActiveBufferHandles[ 5 ] );
+		ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, BufferHandles[ 5 ] );
 		ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, VertexCount * sizeof( Vector3 ), a_Mesh.GetBitangents(), ConsoleGL::DataUsage::DRAW );
 		ConsoleGL::VertexAttribPointer( 5, 3, ConsoleGL::DataType::FLOAT, false, sizeof( Vector3 ), ( void* )0 );
 		ConsoleGL::EnableVertexAttribArray( 5 );
@@ -173,11 +196,15 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 
 	ConsoleGL::BindVertexArray( 0 );
 	ConsoleGL::BindVertexArray( ActiveArrayHandle );
-	Rendering::ActiveMesh = &a_Mesh;
 }
 
 void Rendering::ApplyMaterial( const Material& a_Material )
 {
+	if ( !RenderingState::ShouldBindMaterial( &a_Material ) )
+	{
+		return;
+	}
+
 	ApplyShader( a_Material.GetShader() );
 
 	for ( auto Begin = a_Material.GetPropertyBegin(), End = a_Material.GetPropertyEnd(); Begin != End; ++Begin )
@@ -202,20 +229,31 @@ void Rendering::ApplyMaterial( const Material& a_Material )
 		}
 	}
 
-	static TextureHandle ActiveTextureHandles[ 6 ];
-
 	int CurrentTextureUnit = 0;
 
 	for ( auto Begin = a_Material.GetTextureBegin(), End = a_Material.GetTextureEnd(); Begin != End; ++Begin )
 	{
-		if ( !ActiveTextureHandles[ CurrentTextureUnit ] )
+		const Texture2D* Texture = Begin->second.GetTexture();
+
+		if ( RenderingState::ShouldBindTexture( CurrentTextureUnit, Texture ) )
 		{
-			ConsoleGL::GenTextures( 1, &ActiveTextureHandles[ CurrentTextureUnit ] );
+			bool Upload;
+			ResidencyEntry& Entry = Residency::Acquire( ResidencyEntry::Type::TEXTURE, *Texture, Residency::GetSize( *Texture ), Upload );
+
+			if ( !Entry.Handles[ 0 ] )
+			{
+				ConsoleGL::GenTextures( 1, &Entry.Handles[ 0 ] );
+			}
+
+			ConsoleGL::ActiveTexture( CurrentTextureUnit );
+			ConsoleGL::BindTexture( ConsoleGL::TextureTarget::TEXTURE_2D, Entry.Handles[ 0 ] );
+
+			if ( Upload )
+			{
+				ConsoleGL::TexImage2D( ConsoleGL::TextureTarget::TEXTURE_2D, 0, ConsoleGL::TextureFormat( 0 ), Texture->GetWidth(), Texture->GetHeight(), 0, ConsoleGL::TextureFormat( 0 ), ConsoleGL::TextureSetting( 0 ), Texture->GetData() );
+			}
 		}
 
-		ConsoleGL::ActiveTexture( CurrentTextureUnit );
-		ConsoleGL::BindTexture( ConsoleGL::TextureTarget::TEXTURE_2D, ActiveTextureHandles[ CurrentTextureUnit ] );
-		ConsoleGL::TexImage2D( ConsoleGL::TextureTarget::TEXTURE_2D, 0, ConsoleGL::TextureFormat( 0 ), Begin->second.GetTexture()->GetWidth(), Begin->second.GetTexture()->GetHeight(), 0, ConsoleGL::TextureFormat( 0 ), ConsoleGL::TextureSetting( 0 ), Begin->second.GetTexture()->GetData() );
 		Rendering::ApplyUniform( Begin->second.GetName().Data(), 1, &CurrentTextureUnit );
 		++CurrentTextureUnit;
 	}
@@ -228,13 +266,17 @@ void Rendering::ApplyShader( const Shader& a_Shader )
 		CompileProgram( a_Shader.GetSource(), const_cast< Shader& >( a_Shader ).GetHandle() );
 	}
 
-	ConsoleGL::UseProgram( a_Shader.GetHandle() );
+	if ( RenderingState::ShouldBindProgram( a_Shader.GetHandle() ) )
+	{
+		ConsoleGL::UseProgram( a_Shader.GetHandle() );
+	}
+
 	ActiveShaderProgram = a_Shader.GetHandle();
 }
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const float* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( float ) ) )
 	{
 		return;
 	}
@@ -249,7 +291,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const float*
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const int32_t* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( int32_t ) ) )
 	{
 		return;
 	}
@@ -264,7 +306,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const int32_
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const uint32_t* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( uint32_t ) ) )
 	{
 		return;
 	}
@@ -279,7 +321,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const uint32
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const Matrix4* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( Matrix4 ) ) )
 	{
 		return;
 	}
@@ -295,4 +337,32 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const Matrix
 void Rendering::Draw()
 {
 	ConsoleGL::DrawElements( ConsoleGL::RenderMode::TRIANGLE, Rendering::ActiveMesh->GetIndexCount(), ConsoleGL::DataType::UNSIGNED_INT, Rendering::ActiveMesh->GetIndices() );
+}
+
+void Rendering::DrawInstanced( const Matrix4* a_Models, uint32_t a_Count )
+{
+	if ( !InstanceBufferHandle )
+	{
+		ConsoleGL::GenBuffers( 1, &InstanceBufferHandle );
+	}
+
+	// Point the model matrix columns of the bound array at the instance data, advancing once per instance.
+	ConsoleGL::BindBuffer( ConsoleGL::BufferTarget::ARRAY_BUFFER, InstanceBufferHandle );
+	ConsoleGL::BufferData( ConsoleGL::BufferTarget::ARRAY_BUFFER, a_Count * sizeof( Matrix4 ), a_Models, ConsoleGL::DataUsage::DRAW );
+
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		ConsoleGL::VertexAttribPointer( InstanceModelLocation + i, 4, ConsoleGL::DataType::FLOAT, false, sizeof( Matrix4 ), ( void* )( i * sizeof( Vector4 ) ) );
+		ConsoleGL::EnableVertexAttribArray( InstanceModelLocation + i );
+		ConsoleGL::VertexAttribDivisor( InstanceModelLocation + i, 1 );
+	}
+
+	ConsoleGL::BindVertexArray( 0 );
+	ConsoleGL::BindVertexArray( ActiveArrayHandle );
+	ConsoleGL::DrawElementsInstanced( ConsoleGL::RenderMode::TRIANGLE, Rendering::ActiveMesh->GetIndexCount(), ConsoleGL::DataType::UNSIGNED_INT, Rendering::ActiveMesh->GetIndices(), a_Count );
+}
+
+void Rendering::Resolve( const Matrix4& a_ProjectionView )
+{
+	ConsoleGL::Resolve( &a_ProjectionView );
 }
\ No newline at end of file
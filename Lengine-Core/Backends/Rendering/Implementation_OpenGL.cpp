@@ -4,12 +4,15 @@
 
 #include "../../Rendering.hpp"
 #include "../../Shader.hpp"
+#include "../../RenderingState.hpp"
+#include "../../Residency.hpp"
 
 uint32_t            ActiveModelTransformLocation = 0;
 uint32_t            ActivePVMTransformLocation   = 0;
 ShaderProgramHandle ActiveShaderProgram          = 0;
 const Mesh*         ActiveMesh                   = nullptr;
 ArrayHandle         ActiveArrayHandle = 0;
+BufferHandle        InstanceBufferHandle = 0;
 
 GLFWwindow* Window;
 
@@ -36,6 +39,19 @@ void Rendering::Init()
 	//glCullFace( GL_BACK );
 	//glClearDepth( 0000.0f );
 	glClearColor( 0.0, 0.0, 0.0, 1.0f );
+
+	Residency::Init( []( ResidencyEntry& a_Entry )
+	{
+		if ( a_Entry.ResourceType == ResidencyEntry::Type::MESH )
+		{
+			glDeleteVertexArrays( 1, &a_Entry.Handles[ 0 ] );
+			glDeleteBuffers( 6, &a_Entry.Handles[ 1 ] );
+		}
+		else
+		{
+			glDeleteTextures( 1, &a_Entry.Handles[ 0 ] );
+		}
+	} );
 }
 
 void Rendering::Clear()
@@ -144,26 +160,35 @@ void Rendering::CompileProgram( const std::string& a_Source, ShaderProgramHandle
 
 void Rendering::DeleteProgram( ShaderProgramHandle a_ShaderProgramHandle )
 {
+	RenderingState::ForgetProgram( a_ShaderProgramHandle );
 	glDeleteProgram( a_ShaderProgramHandle );
 }
 
 void Rendering::ApplyMesh( const Mesh& a_Mesh )
 {
-	// First check if an array exists.
-	if ( !ActiveArrayHandle )
+	if ( !RenderingState::ShouldBindMesh( &a_Mesh ) )
 	{
-		glGenVertexArrays( 1, &ActiveArrayHandle );
+		return;
 	}
 
-	static BufferHandle ActiveBufferHandles[ 6 ] { 0 };
+	bool Upload;
+	ResidencyEntry& Entry = Residency::Acquire( ResidencyEntry::Type::MESH, a_Mesh, Residency::GetSize( a_Mesh ), Upload );
+	BufferHandle* ActiveBufferHandles = Entry.Handles + 1;
 
-	// First check that there's at least 6 buffer handles available for all mesh attributes.
-	for ( uint32_t i = 0; i < 6; ++i )
+	// First use of this mesh, create an array and a buffer for all mesh attributes.
+	if ( !Entry.Handles[ 0 ] )
 	{
-		if ( !ActiveBufferHandles[ i ] )
-		{
-			glGenBuffers( 1, &ActiveBufferHandles[ i ] );
-		}
+		glGenVertexArrays( 1, &Entry.Handles[ 0 ] );
+		glGenBuffers( 6, ActiveBufferHandles );
+	}
+
+	ActiveArrayHandle = Entry.Handles[ 0 ];
+	ActiveMesh = &a_Mesh;
+
+	// The array and its buffers stay on the GPU, nothing to do unless the mesh changed.
+	if ( !Upload )
+	{
+		return;
 	}
 
 	// Bind the active array handle so all subsequent operations operate on it.
@@ -226,11 +251,15 @@ void Rendering::ApplyMesh( const Mesh& a_Mesh )
 	}*/
 
 	glBindVertexArray( 0 );
-	ActiveMesh = &a_Mesh;
 }
 
 void Rendering::ApplyMaterial( const Material& a_Material )
 {
+	if ( !RenderingState::ShouldBindMaterial( &a_Material ) )
+	{
+		return;
+	}
+
 	ApplyShader( a_Material.GetShader() );
 
 	for ( auto Begin = a_Material.GetPropertyBegin(), End = a_Material.GetPropertyEnd(); Begin != End; ++Begin )
@@ -255,22 +284,33 @@ void Rendering::ApplyMaterial( const Material& a_Material )
 		}
 	}
 
-	static TextureHandle ActiveTextureHandles[ 6 ];
-
 	int CurrentTextureUnit = 0;
 
 	for ( auto Begin = a_Material.GetTextureBegin(), End = a_Material.GetTextureEnd(); Begin != End; ++Begin )
 	{
-		if ( !ActiveTextureHandles[ CurrentTextureUnit ] )
+		const Texture2D* Texture = Begin->second.GetTexture();
+
+		if ( RenderingState::ShouldBindTexture( CurrentTextureUnit, Texture ) )
 		{
-			glGenTextures( 1, &ActiveTextureHandles[ CurrentTextureUnit ] );
+			bool Upload;
+			ResidencyEntry& Entry = Residency::Acquire( ResidencyEntry::Type::TEXTURE, *Texture, Residency::GetSize( *Texture ), Upload );
+
+			if ( !Entry.Handles[ 0 ] )
+			{
+				glGenTextures( 1, &Entry.Handles[ 0 ] );
+			}
+
+			glActiveTexture( GL_TEXTURE0 + CurrentTextureUnit );
+			glBindTexture( GL_TEXTURE_2D, Entry.Handles[ 0 ] );
+
+			if ( Upload )
+			{
+				//glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, Texture->GetWidth(), Texture->GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, Texture->GetData() );
+			}
 		}
 
-		glActiveTexture( GL_TEXTURE0 + CurrentTextureUnit );
-		glBindTexture( GL_TEXTURE_2D, ActiveTextureHandles[ CurrentTextureUnit ] );
-		//glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, Begin->second.GetTexture()->GetWidth(), Begin->second.GetTexture()->GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, Begin->second.GetTexture()->GetData() );
-		Rendering::ApplyUniform( Begin->second.GetName().Data(), 1, &ActiveTextureHandles[ CurrentTextureUnit ] );
+		Rendering::ApplyUniform( Begin->second.GetName().Data(), 1, &CurrentTextureUnit );
 		++CurrentTextureUnit;
 	}
 
@@ -417,7 +457,12 @@ GLuint LoadShadersImpl( const char* vertex_file_path, const char* fragment_file_
 void Rendering::ApplyShader( const Shader& a_Shader )
 {
 	static GLuint shader = LoadShadersImpl( "shader.vert", "shader.frag" );
-	glUseProgram( shader );
+
+	if ( RenderingState::ShouldBindProgram( shader ) )
+	{
+		glUseProgram( shader );
+	}
+
 	ActiveShaderProgram = shader;
 	return;
 
@@ -426,13 +471,17 @@ void Rendering::ApplyShader( const Shader& a_Shader )
 		CompileProgram( a_Shader.GetSource(), const_cast< Shader& >( a_Shader ).GetHandle() );
 	}
 
-	glUseProgram( a_Shader.GetHandle() );
+	if ( RenderingState::ShouldBindProgram( a_Shader.GetHandle() ) )
+	{
+		glUseProgram( a_Shader.GetHandle() );
+	}
+
 	ActiveShaderProgram = a_Shader.GetHandle();
 }
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const float* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( float ) ) )
 	{
 		return;
 	}
@@ -447,7 +496,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const float*
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const int32_t* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( int32_t ) ) )
 	{
 		return;
 	}
@@ -462,7 +511,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const int32_
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const uint32_t* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( uint32_t ) ) )
 	{
 		return;
 	}
@@ -477,7 +526,7 @@ void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const uint32
 
 void Rendering::ApplyUniform( const char* a_Name, uint32_t a_Count, const Matrix4* a_Value )
 {
-	if ( !ActiveShaderProgram )
+	if ( !ActiveShaderProgram || !RenderingState::ShouldUploadUniform( a_Name, a_Value, a_Count * sizeof( Matrix4 ) ) )
 	{
 		return;
 	}
@@ -496,7 +545,34 @@ void Rendering::Draw()
 	glBindVertexArray( ActiveArrayHandle );
 	glDrawElements( GL_TRIANGLES, ActiveMesh->GetIndexCount(), GL_UNSIGNED_INT, ActiveMesh->GetIndices() );
 	glBindVertexArray( 0 );
+}
+
+void Rendering::DrawInstanced( const Matrix4* a_Models, uint32_t a_Count )
+{
+	if ( !InstanceBufferHandle )
+	{
+		glGenBuffers( 1, &InstanceBufferHandle );
+	}
+
+	glBindVertexArray( ActiveArrayHandle );
+	glBindBuffer( GL_ARRAY_BUFFER, InstanceBufferHandle );
+	glBufferData( GL_ARRAY_BUFFER, a_Count * sizeof( Matrix4 ), a_Models, GL_STREAM_DRAW );
+
+	// One model matrix column per attribute, advancing once per instance.
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		glVertexAttribPointer( InstanceModelLocation + i, 4, GL_FLOAT, false, sizeof( Matrix4 ), ( void* )( i * sizeof( Vector4 ) ) );
+		glEnableVertexAttribArray( InstanceModelLocation + i );
+		glVertexAttribDivisor( InstanceModelLocation + i, 1 );
+	}
+
+	glDrawElementsInstanced( GL_TRIANGLES, ActiveMesh->GetIndexCount(), GL_UNSIGNED_INT, ActiveMesh->GetIndices(), a_Count );
+	glBindVertexArray( 0 );
+}
+
+void Rendering::Resolve( const Matrix4& a_ProjectionView )
+{
+	// Rendering goes straight to the default framebuffer, it only has to be presented once per frame.
 	glfwSwapBuffers( Window );
-	glfwWindowShouldClose( Window );
 	glfwPollEvents();
 }
\ No newline at end of file
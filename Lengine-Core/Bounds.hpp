@@ -0,0 +1,92 @@
+#pragma once
+#include "Math.hpp"
+
+struct Sphere
+{
+	Sphere()
+		: Centre( Vector3::Zero )
+		, Radius( 0.0f )
+	{ }
+
+	Sphere( const Vector3& a_Centre, float a_Radius )
+		: Centre( a_Centre )
+		, Radius( a_Radius )
+	{ }
+
+	Vector3 Centre;
+	float   Radius;
+};
+
+struct AABB
+{
+	AABB()
+		: Min( Vector3::Zero )
+		, Max( Vector3::Zero )
+	{ }
+
+	AABB( const Vector3& a_Min, const Vector3& a_Max )
+		: Min( a_Min )
+		, Max( a_Max )
+	{ }
+
+	inline Vector3 GetCentre() const
+	{
+		return ( Min + Max ) * 0.5f;
+	}
+
+	inline Vector3 GetExtents() const
+	{
+		return ( Max - Min ) * 0.5f;
+	}
+
+	inline float GetSurfaceArea() const
+	{
+		Vector3 Size = Max - Min;
+		return 2.0f * ( Size.x * Size.y + Size.y * Size.z + Size.z * Size.x );
+	}
+
+	inline bool Contains( const AABB& a_Bounds ) const
+	{
+		return
+			Min.x <= a_Bounds.Min.x && Min.y <= a_Bounds.Min.y && Min.z <= a_Bounds.Min.z &&
+			Max.x >= a_Bounds.Max.x && Max.y >= a_Bounds.Max.y && Max.z >= a_Bounds.Max.z;
+	}
+
+	inline bool Overlaps( const AABB& a_Bounds ) const
+	{
+		return
+			Min.x <= a_Bounds.Max.x && Min.y <= a_Bounds.Max.y && Min.z <= a_Bounds.Max.z &&
+			Max.x >= a_Bounds.Min.x && Max.y >= a_Bounds.Min.y && Max.z >= a_Bounds.Min.z;
+	}
+
+	inline AABB Expanded( const Vector3& a_Margin ) const
+	{
+		return AABB( Min - a_Margin, Max + a_Margin );
+	}
+
+	// Bounds of this box after it has been transformed by a_Matrix.
+	AABB Transformed( const Matrix4& a_Matrix ) const
+	{
+		Vector3 Centre = GetCentre();
+		Vector3 Extents = GetExtents();
+		Vector3 NewCentre;
+		Vector3 NewExtents;
+
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			const auto& Row = a_Matrix.GetRow( i );
+			NewCentre[ i ] = Row[ 0 ] * Centre.x + Row[ 1 ] * Centre.y + Row[ 2 ] * Centre.z + Row[ 3 ];
+			NewExtents[ i ] = Math::Abs( Row[ 0 ] ) * Extents.x + Math::Abs( Row[ 1 ] ) * Extents.y + Math::Abs( Row[ 2 ] ) * Extents.z;
+		}
+
+		return AABB( NewCentre - NewExtents, NewCentre + NewExtents );
+	}
+
+	inline static AABB Merge( const AABB& a_BoundsA, const AABB& a_BoundsB )
+	{
+		return AABB( Math::Min( a_BoundsA.Min, a_BoundsB.Min ), Math::Max( a_BoundsA.Max, a_BoundsB.Max ) );
+	}
+
+	Vector3 Min;
+	Vector3 Max;
+};
@@ -3,4 +3,6 @@
 bool  CGE::s_Running = false;
 bool  CGE::s_ShowFPS = false;
 float CGE::s_TargetFPS = 0.0f;
-float CGE::s_TargetDeltaTime = 0.0f;
\ No newline at end of file
+float CGE::s_TargetDeltaTime = 0.0f;
+bool  CGE::s_FrameSkipping = false;
+uint32_t CGE::s_SkippedFrames = 0;
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "Scene.hpp"
 #include "RenderingPipeline.hpp"
 #include "AudioEngine.hpp"
+#include "WorkerPool.hpp"
+#include "SystemScheduler.hpp"
 
 class CGE
 {
@@ -19,9 +21,20 @@ public:
     {
         PixelColourMap::Init();
         Resource::Init();
+        WorkerPool::Init();
         Input::Init();
         RenderingPipeline::Init();
         AudioEngine::Init();
+
+        // Fixed steps write the components stepped and the Transforms they move. Systems using
+        // neither, and any that only touch other state, run alongside them.
+        SystemScheduler::AddSystem( "Fixed update", FixedTick ).Write( ComponentBase::GetFixedUpdateTypes() ).Write< Transform >().Read< Time >();
+
+        // Destroying components may take any of them, so it waits on every system using components
+        // and is waited on in turn. It stays on the main thread, as that is where OnDestroy hooks
+        // are documented to run.
+        SystemScheduler::AddSystem( "Destroy components", ComponentBase::TickAllComponents ).Write( ComponentBase::GetComponentTypes() ).MainThread();
+        SystemScheduler::AddSystem( "Transforms", Scene::Tick ).Write< Transform >();
     }
 
     // Begin ticking.
@@ -36,18 +49,34 @@ public:
 
             a_Action.Invoke();
 
+            // Fixed steps cover the time the last frame took, so the simulation runs the same at any
+            // frame rate. Interpolated transforms are drawn the leftover fraction of a step between
+            // the last two simulated states.
+            Time::BeginFixedSteps();
+            TransformStorage::SetInterpolationAlpha( Time::GetFixedAlpha() );
+
             // Update calls.
-            ComponentBase::TickAllComponents();
-            Scene::Tick();
+            SystemScheduler::Tick();
             Time::Tick();
-            RenderingPipeline::Tick();
-            //RenderingPipeline::Draw();
+
+            // A frame that fell behind can leave drawing out, giving the next frame's steps the time.
+            // The last drawn frame is still presented, so the window keeps responding.
+            if ( s_FrameSkipping && Time::IsFallingBehind() && s_SkippedFrames < MaxSkippedFrames )
+            {
+                ++s_SkippedFrames;
+            }
+            else
+            {
+                s_SkippedFrames = 0;
+                RenderingPipeline::Tick();
+            }
             
             ConsoleWindow::SwapBuffers( ConsoleWindow::GetCurrentContext() );
         }
 
         AudioEngine::Deinitialize();
         Input::Deinitialize();
+        WorkerPool::Deinitialize();
     }
 
     static bool Quit()
@@ -66,10 +95,35 @@ public:
         return s_Running;
     }
 
+    // Lets frames that fall behind on fixed steps skip drawing, at most MaxSkippedFrames in a row.
+    inline static void SetFrameSkipping( bool a_FrameSkipping )
+    {
+        s_FrameSkipping = a_FrameSkipping;
+    }
+
+    inline static bool GetFrameSkipping()
+    {
+        return s_FrameSkipping;
+    }
+
+    static constexpr uint32_t MaxSkippedFrames = 2;
+
 private:
 
+    // Runs the fixed steps counted at the start of the frame.
+    static void FixedTick()
+    {
+        for ( uint32_t Steps = Time::GetFixedSteps(); Steps > 0; --Steps )
+        {
+            TransformStorage::BeginFixedStep();
+            ComponentBase::FixedTickAllComponents();
+        }
+    }
+
     static bool  s_Running;
     static bool  s_ShowFPS;
     static float s_TargetFPS;
     static float s_TargetDeltaTime;
+    static bool  s_FrameSkipping;
+    static uint32_t s_SkippedFrames;
 };
\ No newline at end of file
@@ -55,7 +55,7 @@ public:
 
 	inline float GetNearZ() const
 	{
-		return m_FarZ;
+		return m_NearZ;
 	}
 
 	inline void SetNearZ( float a_NearZ )
@@ -72,7 +72,7 @@ public:
 	inline void SetFarZ( float a_FarZ )
 	{
 		m_FarZ = a_FarZ;
-		m_Dirty;
+		m_Dirty = true;
 	}
 
 	inline static void SetMainCamera( const Camera* a_Camera )
@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <typeinfo>
+#include <vector>
 
 #include <entt/entt.hpp>
 
@@ -19,6 +22,51 @@ class IAlias;
 
 typedef IAlias< void > Alias;
 
+// Components returned by a query, pointing into the query's cache. While any view of a query is
+// alive the cache is left as it is, so queries made while walking one see the same components and
+// the walk is never invalidated. Components added or removed in the meantime show up in the first
+// query made once every view is gone.
+template < typename T >
+class ComponentView
+{
+public:
+
+	ComponentView( const std::vector< T* >& a_Components, uint32_t& a_Views )
+		: m_Begin( a_Components.data() )
+		, m_End( a_Components.data() + a_Components.size() )
+		, m_Views( &a_Views )
+	{
+		++*m_Views;
+	}
+
+	ComponentView( const ComponentView& a_Other )
+		: m_Begin( a_Other.m_Begin )
+		, m_End( a_Other.m_End )
+		, m_Views( a_Other.m_Views )
+	{
+		++*m_Views;
+	}
+
+	ComponentView& operator=( const ComponentView& ) = delete;
+
+	~ComponentView()
+	{
+		--*m_Views;
+	}
+
+	inline T* const* begin() const { return m_Begin; }
+	inline T* const* end() const { return m_End; }
+	inline size_t size() const { return m_End - m_Begin; }
+	inline bool empty() const { return m_Begin == m_End; }
+	inline T* operator []( size_t a_Index ) const { return m_Begin[ a_Index ]; }
+
+private:
+
+	T* const* m_Begin;
+	T* const* m_End;
+	uint32_t* m_Views;
+};
+
 class ComponentBase
 {
 private:
@@ -40,10 +88,76 @@ private:
 		return Registry;
 	}
 
+	// Baked prefabs keep their components here, apart from the scene, so no hooks run for them and no
+	// query finds them.
+	static entt::registry& GetPrototypeRegistry()
+	{
+		static entt::registry Registry;
+		return Registry;
+	}
+
+	typedef void( *CloneFunction )( entt::entity, const entt::entity*, const entt::entity* );
+
+	// Copies a prototype's component onto every GameObject in [ a_Begin, a_End ) at once.
+	template < typename _Component >
+	static void CloneComponent( entt::entity a_Prototype, const entt::entity* a_Begin, const entt::entity* a_End )
+	{
+		entt::registry& Registry = GetRegistry();
+		Registry.insert< _Component >( a_Begin, a_End, GetPrototypeRegistry().get< _Component >( a_Prototype ) );
+
+		// The prototype's owner came along with the copy, only components with OnCreate have been fixed up.
+		for ( ; a_Begin != a_End; ++a_Begin )
+		{
+			Registry.get< _Component >( *a_Begin ).m_ID = static_cast< GameObjectID >( *a_Begin );
+		}
+	}
+
+	// Deserializes onto a prototype's component, adding it first if need be, and hands back how to copy it.
+	template < typename _Deserializer, typename _Component >
+	static CloneFunction BakeComponent( _Deserializer& a_Deserializer, entt::entity a_Prototype )
+	{
+		a_Deserializer >> GetPrototypeRegistry().get_or_emplace< _Component >( a_Prototype );
+		return CloneComponent< _Component >;
+	}
+
+	template < typename T >
+	struct DerivedType
+	{
+		T*       ( *Get     )( GameObjectID );
+		void     ( *Collect )( std::vector< T* >& );
+		uint32_t Depth;
+	};
+
+	// Every registered component type that is T or derives from it, ordered from T down the hierarchy.
+	// Filled in as types register, so queries never have to walk the hierarchy.
+	template < typename T >
+	static std::vector< DerivedType< T > >& GetDerivedTypes()
+	{
+		static std::vector< DerivedType< T > > DerivedTypes;
+		return DerivedTypes;
+	}
+
+	template < typename T >
+	struct QueryCache
+	{
+		std::vector< T* > Components;
+		bool              Dirty = true;
+		uint32_t          Views = 0;
+	};
+
+	template < typename T, bool _Exact >
+	static QueryCache< T >& GetQueryCache()
+	{
+		static QueryCache< T > Cache;
+		return Cache;
+	}
+
+	// Marked components are destroyed together on the next tick. The vectors are kept between frames,
+	// so marking only allocates while they grow past their largest size yet.
 	template < typename _Component >
-	static std::list< GameObjectID >& GetGraveyard()
+	static std::vector< entt::entity >& GetGraveyard()
 	{
-		static std::list< GameObjectID > Graveyard;
+		static std::vector< entt::entity > Graveyard;
 		return Graveyard;
 	}
 
@@ -60,9 +174,56 @@ private:
 		s_TickList.push_back( a_TickFunction );
 	}
 
+	// Calls FixedUpdate on every component that has one, once per fixed step. The "Fixed update" system
+	// only declares those components and Transform, so FixedUpdate should leave other components alone
+	// and mark components for destruction rather than adding them.
+	static void FixedTickAllComponents()
+	{
+		for ( auto FixedTickFunction : s_FixedTickList )
+		{
+			FixedTickFunction();
+		}
+	}
+
+	inline static void RegisterFixedTickFunction( void( *a_FixedTickFunction )( ) )
+	{
+		s_FixedTickList.push_back( a_FixedTickFunction );
+	}
+
+	// Every registered component type and those it derives from, apart from Component itself, by their
+	// typeid hash as systems declare them. For the engine's own systems, which touch components of any
+	// type.
+	inline static const std::vector< size_t >& GetComponentTypes()
+	{
+		return s_ComponentTypes;
+	}
+
+	// Same as GetComponentTypes, for the types with a FixedUpdate only.
+	inline static const std::vector< size_t >& GetFixedUpdateTypes()
+	{
+		return s_FixedUpdateTypes;
+	}
+
+	template < typename _Root, typename... _Types >
+	static void RegisterTypes( std::vector< size_t >& o_Types, std::tuple< _Root, _Types... >* )
+	{
+		auto Register = [ &o_Types ]( size_t a_Type )
+		{
+			if ( std::find( o_Types.begin(), o_Types.end(), a_Type ) == o_Types.end() )
+			{
+				o_Types.push_back( a_Type );
+			}
+		};
+
+		( Register( typeid( _Types ).hash_code() ), ... );
+	}
+
 	inline static std::vector< void( * )( ) > s_TickList;
+	inline static std::vector< void( * )( ) > s_FixedTickList;
+	inline static std::vector< size_t >       s_ComponentTypes;
+	inline static std::vector< size_t >       s_FixedUpdateTypes;
 
-	GameObjectID m_ID;
+	GameObjectID m_ID = GameObjectID( -1 );
 };
 
 namespace Internal
@@ -146,16 +307,9 @@ public:
 			return Found;
 		}
 
-		auto Begin = ComponentBase::GetTypeMap().GetBFBegin< std::remove_const_t< T > >();
-		auto End = ComponentBase::GetTypeMap().GetBFEnd();
-		++Begin;
-
-		for ( ; Begin != End; ++Begin )
+		for ( const auto& Derived : ComponentBase::GetDerivedTypes< std::remove_const_t< T > >() )
 		{
-			T* Found = nullptr;
-			ComponentBase::GetTypeMap().InvokeFunction( Begin->hash_code(), "GetComponent"_H, Found, a_ID );
-
-			if ( Found )
+			if ( T* Found = Derived.Get( a_ID ) )
 			{
 				return Found;
 			}
@@ -178,7 +332,9 @@ public:
 	template < typename T >
 	static bool Destroy( GameObjectID a_ID )
 	{
-		static std::list< GameObjectID >& Graveyard = ComponentBase::GetGraveyard< T >();
+		// The Alias takes the whole GameObject with it, which the Transform already does along with its children.
+		using Marked = std::conditional_t< std::is_same_v< T, Alias >, Transform, T >;
+		static std::vector< entt::entity >& Graveyard = ComponentBase::GetGraveyard< Marked >();
 
 		if ( a_ID == GameObjectID( -1 ) || !ComponentBase::GetRegistry().valid( entt::entity( a_ID ) ) )
 		{
@@ -187,7 +343,7 @@ public:
 
 		if ( T* ThisComponent = Component::GetExactComponent< T >( a_ID ) )
 		{
-			Graveyard.push_back( a_ID );
+			Graveyard.push_back( entt::entity( a_ID ) );
 			return true;
 		}
 
@@ -214,39 +370,111 @@ public:
 		return GetExactComponent< Alias >( m_ID );
 	}
 
+	// Components of type T and of every type deriving from it. The pointers are cached and only collected
+	// again after components of those types are added or removed, and not while a view is still alive.
 	template < typename T >
-	static std::list< T* > GetComponents()
+	static ComponentView< T > GetComponents()
 	{
-		std::list< T* > Collated;
+		auto& Cache = ComponentBase::GetQueryCache< T, false >();
 
-		for ( auto Begin = ComponentBase::GetTypeMap().GetBFBegin< T >(), End = ComponentBase::GetTypeMap().GetBFEnd(); Begin != End; ++Begin )
+		if ( Cache.Dirty && !Cache.Views )
 		{
-			size_t HashCode = Begin->hash_code();
-			std::list< T* > Components;
-			ComponentBase::GetTypeMap().InvokeFunction( HashCode, "GetComponents"_H, Components );
-			Collated.splice( Collated.end(), Components );
+			Cache.Components.clear();
+
+			for ( const auto& Derived : ComponentBase::GetDerivedTypes< T >() )
+			{
+				Derived.Collect( Cache.Components );
+			}
+
+			Cache.Dirty = false;
 		}
 
-		return Collated;
+		return ComponentView< T >( Cache.Components, Cache.Views );
 	}
 
 	template < typename T >
-	static std::list< T* > GetExactComponents()
+	static ComponentView< T > GetExactComponents()
 	{
-		auto View = ComponentBase::GetRegistry().view< T >();
-		std::list< T* > Collated;
+		auto& Cache = ComponentBase::GetQueryCache< T, true >();
 
-		for ( auto Begin = View.rbegin(), End = View.rend(); Begin != End; ++Begin )
+		if ( Cache.Dirty && !Cache.Views )
 		{
-			Collated.push_back( &View.get< T >( *Begin ) );
+			Cache.Components.clear();
+			CollectComponents< T, T >( Cache.Components );
+			Cache.Dirty = false;
 		}
 
-		return Collated;
+		return ComponentView< T >( Cache.Components, Cache.Views );
+	}
+
+	// GameObjects holding an _Owned and every one of _Get. The group owns _Owned, keeping the matching
+	// components packed at the front of its pool, so each() walks them contiguously without testing
+	// the others. _Get types are still looked up per GameObject, and for Transform that only finds the
+	// slot, its data lives in TransformStorage. A type can only be owned by one group, _Get types can
+	// be shared between them.
+	template < typename _Owned, typename... _Get >
+	static auto& GetGroup()
+	{
+		static auto Group = CreateGroup< _Owned, _Get... >();
+		return Group;
+	}
+
+	// GameObjects holding every one of _Owned. The group owns all of them, so their components are
+	// packed at the front of each pool in the same order and walked in lockstep, see GetOwned. Owning
+	// Transform packs the slots, their data still lives in TransformStorage.
+	template < typename... _Owned >
+	static auto& GetOwningGroup()
+	{
+		static auto Group = CreateOwningGroup< _Owned... >();
+		return Group;
+	}
+
+	// Random access to the _Type components of a group that owns it. Index i is the same GameObject
+	// for every type the group owns, and stays valid until components are added or removed.
+	template < typename _Type, typename _Group >
+	static auto GetOwned( const _Group& a_Group )
+	{
+		return ComponentBase::GetRegistry().storage< _Type >().end() - static_cast< std::ptrdiff_t >( a_Group.size() );
 	}
 
 private:
 
 	friend class GameObject;
+	friend class SystemScheduler;
+	template < typename > friend class IComponent;
+
+	template < typename _Owned, typename... _Get >
+	static auto CreateGroup()
+	{
+		entt::registry& Registry = ComponentBase::GetRegistry();
+		auto Group = Registry.group< _Owned >( entt::get< _Get... > );
+
+		// Owned components move as GameObjects join and leave the group, so queries holding them are
+		// collected again whenever that can happen.
+		( Registry.on_construct< _Get >().template connect< &_Owned::OnComponentsChanged >(), ... );
+		( Registry.on_destroy< _Get >().template connect< &_Owned::OnComponentsChanged >(), ... );
+		_Owned::OnComponentsChanged( Registry, entt::null );
+		return Group;
+	}
+
+	template < typename... _Owned >
+	static auto CreateOwningGroup()
+	{
+		entt::registry& Registry = ComponentBase::GetRegistry();
+		auto Group = Registry.group< _Owned... >();
+
+		// Every owned type moves whenever any of them is added or removed.
+		( ConnectOwned< _Owned, _Owned... >( Registry ), ... );
+		( _Owned::OnComponentsChanged( Registry, entt::null ), ... );
+		return Group;
+	}
+
+	template < typename _Owner, typename... _Types >
+	static void ConnectOwned( entt::registry& a_Registry )
+	{
+		( a_Registry.on_construct< _Types >().template connect< &_Owner::OnComponentsChanged >(), ... );
+		( a_Registry.on_destroy< _Types >().template connect< &_Owner::OnComponentsChanged >(), ... );
+	}
 
 	using InheritanceTrace = typename unwrap< IComponent< T > >::Tuple;
 	using LeadingType = std::tuple_element_t< std::tuple_size_v< InheritanceTrace > -1, InheritanceTrace >;
@@ -273,6 +501,8 @@ private:
 		return true;
 	}
 
+	// OnCreate runs on the thread adding the component, before AddComponent returns. OnDestroy runs on
+	// the main thread, from the "Destroy components" system that flushes the graveyards each tick.
 	template < typename _Component >
 	struct HasOnCreate
 	{
@@ -299,6 +529,19 @@ private:
 		static constexpr bool Value = sizeof( test< _Component >( 0 ) ) == sizeof( char );
 	};
 
+	template < typename _Component >
+	struct HasFixedUpdate
+	{
+	private:
+
+		template < typename U > static char test( decltype( &U::FixedUpdate ) );
+		template < typename U > static long test( ... );
+
+	public:
+
+		static constexpr bool Value = sizeof( test< _Component >( 0 ) ) == sizeof( char );
+	};
+
 	template < typename _Component >
 	static void OnCreateImpl( _Component& a_Component )
 	{
@@ -314,7 +557,10 @@ private:
 	template < typename _Component >
 	static void InvokeOnCreate( entt::registry& a_Registry, entt::entity a_Entity )
 	{
-		OnCreateImpl< _Component >( a_Registry.get< _Component >( a_Entity ) );
+		// Construction signals fire before AddComponent gets to set the owner.
+		_Component& Created = a_Registry.get< _Component >( a_Entity );
+		Created.m_ID = static_cast< GameObjectID >( a_Entity );
+		OnCreateImpl< _Component >( Created );
 	}
 
 	template < typename _Component >
@@ -323,38 +569,147 @@ private:
 		OnDestroyImpl< _Component >( a_Registry.get< _Component >( a_Entity ) );
 	}
 
+	// A component's base in the hierarchy is the base template instantiated for the type below it,
+	// IRenderer< IMeshRenderer< void > > rather than Renderer. The upcast to it is left to the compiler,
+	// so any base offset is applied, and the instantiations only differ by their CRTP parameter, sharing
+	// their layout.
+	template < typename _Base >
+	struct BaseOf;
+
+	template < template < typename > class _Template >
+	struct BaseOf< _Template< void > >
+	{
+		template < typename _Below >
+		static _Template< _Below >* Find( _Template< _Below >* a_Component )
+		{
+			return a_Component;
+		}
+	};
+
+	template < typename _Base, typename _Component >
+	static _Base* AsBase( _Component* a_Component )
+	{
+		return static_cast< _Base* >( static_cast< void* >( BaseOf< _Base >::Find( a_Component ) ) );
+	}
+
+	template < typename _Base, typename _Component >
+	static _Base* GetDerived( GameObjectID a_ID )
+	{
+		_Component* Found = ComponentBase::GetRegistry().try_get< _Component >( entt::entity( a_ID ) );
+		return Found ? AsBase< _Base >( Found ) : nullptr;
+	}
+
+	template < typename _Base, typename _Component >
+	static void CollectComponents( std::vector< _Base* >& o_Components )
+	{
+		auto View = ComponentBase::GetRegistry().view< _Component >();
+
+		for ( auto Begin = View.rbegin(), End = View.rend(); Begin != End; ++Begin )
+		{
+			o_Components.push_back( AsBase< _Base >( &View.get< _Component >( *Begin ) ) );
+		}
+	}
+
+	// The trace runs from Component down to the leading type, which lies a_Depth below _Base.
+	template < typename _Base >
+	static void RegisterDerivedType( uint32_t a_Depth )
+	{
+		auto& DerivedTypes = ComponentBase::GetDerivedTypes< _Base >();
+		auto Where = std::find_if( DerivedTypes.begin(), DerivedTypes.end(), [ a_Depth ]( const auto& a_Derived ){ return a_Derived.Depth > a_Depth; } );
+		DerivedTypes.insert( Where, { GetDerived< _Base, LeadingType >, CollectComponents< _Base, LeadingType >, a_Depth } );
+	}
+
+	template < typename... _Bases >
+	static void RegisterDerivedTypes( std::tuple< _Bases... >* )
+	{
+		uint32_t Depth = sizeof...( _Bases );
+		( RegisterDerivedType< _Bases >( --Depth ), ... );
+	}
+
+	template < typename... _Bases >
+	static void InvalidateQueries( std::tuple< _Bases... >* )
+	{
+		( ( ComponentBase::GetQueryCache< _Bases, false >().Dirty = true ), ... );
+		ComponentBase::GetQueryCache< LeadingType, true >().Dirty = true;
+	}
+
+	static void OnComponentsChanged( entt::registry& a_Registry, entt::entity a_Entity )
+	{
+		InvalidateQueries( static_cast< InheritanceTrace* >( nullptr ) );
+	}
+
 	static void Tick()
 	{
-		static std::list< GameObjectID >& Graveyard = ComponentBase::GetGraveyard< LeadingType >();
+		static std::vector< entt::entity >& Graveyard = ComponentBase::GetGraveyard< LeadingType >();
+		static std::vector< entt::entity > Flushing;
+		entt::registry& Registry = ComponentBase::GetRegistry();
 
-		// Destroy all marked for destruction.
+		// Destroy all marked for destruction. OnDestroy may mark more, those are swapped in on the next pass.
 		while ( !Graveyard.empty() )
 		{
+			std::swap( Graveyard, Flushing );
+
+			// Components may have gone along with their GameObject since they were marked.
+			Flushing.erase( std::remove_if( Flushing.begin(), Flushing.end(), [ &Registry ]( entt::entity a_Entity )
+			{
+				return !Registry.valid( a_Entity ) || !Registry.all_of< LeadingType >( a_Entity );
+			} ), Flushing.end() );
+
+			// Children go along with their parents, gathered here rather than marked one by one from OnDestroy.
+			if constexpr ( std::is_same_v< LeadingType, Transform > )
+			{
+				LeadingType::CollectDescendants( Flushing );
+			}
+
+			// The same component may have been marked twice, the range functions expect each only once.
+			std::sort( Flushing.begin(), Flushing.end() );
+			Flushing.erase( std::unique( Flushing.begin(), Flushing.end() ), Flushing.end() );
+
 			// If component type is Transform or Alias (no GameObject can live without either), then destroy
 			// entire GameObject.
 			if constexpr ( std::is_same_v< LeadingType, Alias > || std::is_same_v< LeadingType, Transform > )
 			{
-				ComponentBase::GetRegistry().destroy( entt::entity( Graveyard.front() ) );
+				Registry.destroy( Flushing.begin(), Flushing.end() );
 			}
 			else
 			{
-				ComponentBase::GetRegistry().erase< LeadingType >( entt::entity( Graveyard.front() ) );
+				Registry.erase< LeadingType >( Flushing.begin(), Flushing.end() );
 			}
 
-			Graveyard.pop_front();
+			Flushing.clear();
+		}
+	}
+
+	// Views are exact, so a derived type inheriting FixedUpdate is stepped by its own registration and
+	// never twice.
+	static void FixedTick()
+	{
+		auto View = ComponentBase::GetRegistry().view< LeadingType >();
+
+		for ( auto Entity : View )
+		{
+			View.get< LeadingType >( Entity ).FixedUpdate();
 		}
 	}
 
 	static void Setup()
 	{
 		ComponentBase::RegisterTickFunction( Tick );
+		ComponentBase::RegisterTypes( ComponentBase::s_ComponentTypes, static_cast< InheritanceTrace* >( nullptr ) );
+
+		if constexpr ( HasFixedUpdate< LeadingType >::Value )
+		{
+			ComponentBase::RegisterFixedTickFunction( FixedTick );
+			ComponentBase::RegisterTypes( ComponentBase::s_FixedUpdateTypes, static_cast< InheritanceTrace* >( nullptr ) );
+		}
+
 		ComponentBase::GetTypeMap().RegisterTypes< InheritanceTrace >();
 		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "AddComponent"_H, AddComponent< LeadingType > );
 		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "BufferSerializeComponent"_H,   SerializeComponent  < BufferSerializer,   LeadingType > );
 		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "BufferDeserializeComponent"_H, DeserializeComponent< BufferDeserializer, LeadingType > );
-		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "GetComponent"_H,  GetExactComponent < LeadingType > );
-		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "GetComponents"_H, GetExactComponents< LeadingType > );
-		
+		ComponentBase::GetTypeMap().RegisterFunction< LeadingType >( "BufferBakeComponent"_H,        ComponentBase::BakeComponent< BufferDeserializer, LeadingType > );
+		RegisterDerivedTypes( static_cast< InheritanceTrace* >( nullptr ) );
+
 		if constexpr ( HasOnCreate< LeadingType >::Value )
 		{
 			ComponentBase::GetRegistry().on_construct< LeadingType >().connect< InvokeOnCreate< LeadingType > >();
@@ -364,6 +719,10 @@ private:
 		{
 			ComponentBase::GetRegistry().on_destroy< LeadingType >().connect< InvokeOnDestroy< LeadingType > >();
 		}
+
+		// Connected last, so queries made from OnCreate and OnDestroy are collected again afterwards.
+		ComponentBase::GetRegistry().on_construct< LeadingType >().connect< OnComponentsChanged >();
+		ComponentBase::GetRegistry().on_destroy< LeadingType >().connect< OnComponentsChanged >();
 	}
 
 private:
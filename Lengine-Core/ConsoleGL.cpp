@@ -5,7 +5,7 @@
 
 void ConsoleGL::Init()
 {
-	s_DepthBuffer.Init( ConsoleWindow::GetCurrentContext()->GetSize() );
+	s_DepthBuffer.Init( GetRenderSize() );
 }
 
 void ConsoleGL::GenBuffers( uint32_t a_Count, BufferHandle* a_Handles )
@@ -51,7 +51,14 @@ void ConsoleGL::Clear( uint8_t a_Flags )
 {
 	if ( a_Flags & static_cast< uint8_t >( BufferFlag::COLOUR_BUFFER_BIT ) )
 	{
-		ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetBuffer( s_ClearColour );
+		if ( s_RenderState.Offscreen )
+		{
+			s_ColourTarget.Reset( s_ClearTargetColour );
+		}
+		else
+		{
+			ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetBuffer( s_ClearColour );
+		}
 	}
 
 	if ( a_Flags & static_cast< uint8_t >( BufferFlag::DEPTH_BUFFER_BIT ) )
@@ -72,11 +79,12 @@ void ConsoleGL::Clear( uint8_t a_Flags )
 
 void ConsoleGL::ClearColour( float a_R, float a_G, float a_B, float a_A )
 {
-	s_ClearColour = PixelColourMap::Get().ConvertColour( {
+	s_ClearTargetColour = {
 		static_cast< unsigned char >( 255u * a_R ),
 		static_cast< unsigned char >( 255u * a_G ),
 		static_cast< unsigned char >( 255u * a_B ),
-		static_cast< unsigned char >( 255u * a_A ) } );
+		static_cast< unsigned char >( 255u * a_A ) };
+	s_ClearColour = PixelColourMap::Get().ConvertColour( s_ClearTargetColour );
 }
 
 void ConsoleGL::ClearDepth( float a_ClearDepth )
@@ -145,12 +153,14 @@ void ConsoleGL::BindVertexArray( ArrayHandle a_Handle )
 	s_ActiveArray = a_Handle;
 	auto& ActiveArray = s_ArrayRegistry[ a_Handle ];
 	
-	for ( uint8_t i = 0; i < 8; ++i )
+	for ( uint8_t i = 0; i < MaxVertexAttributes; ++i )
 	{
 		if ( ActiveArray[ i ].Enabled )
 		{
 			s_AttributeRegistry[ i ] = ActiveArray[ i ];
 		}
+
+		s_AttributeRegistry.SetDivisor( i, ActiveArray[ i ].Enabled ? ActiveArray[ i ].Divisor : 0 );
 	}
 }
 
@@ -189,6 +199,12 @@ void ConsoleGL::VertexAttribPointer( uint32_t a_Index, uint32_t a_Size, DataType
 	Attributes.Stride = a_Stride;
 	Attributes.Enabled = false;
 	Attributes.Offset = ( uint32_t )a_Offset;
+	Attributes.Divisor = 0;
+}
+
+void ConsoleGL::VertexAttribDivisor( uint32_t a_Index, uint32_t a_Divisor )
+{
+	s_ArrayRegistry[ s_ActiveArray ][ a_Index ].Divisor = a_Divisor;
 }
 
 void ConsoleGL::DrawElements( RenderMode a_Mode, uint32_t a_Count, DataType a_DataType, const void* a_Indices )
@@ -207,9 +223,40 @@ void ConsoleGL::DrawElements( RenderMode a_Mode, uint32_t a_Count, DataType a_Da
 
 	UpdateDrawProcessor();
 
+	InstanceID = 0;
+	s_AttributeRegistry.SetInstance( 0 );
 	s_DrawProcessorFunc( 0, a_Count );
 }
 
+void ConsoleGL::DrawElementsInstanced( RenderMode a_Mode, uint32_t a_Count, DataType a_DataType, const void* a_Indices, uint32_t a_InstanceCount )
+{
+	const void* Indices = nullptr;
+	auto Handle = s_BufferTargets[ ( uint32_t )BufferTarget::ELEMENT_ARRAY_BUFFER ];
+	Indices = s_BufferRegistry.Valid( Handle ) ? ( s_BufferRegistry[ Handle ] + ( uint32_t )a_Indices ) : a_Indices;
+
+	switch ( a_DataType )
+	{
+		case DataType::UNSIGNED_BYTE:  s_AttributeRegistry.SetIndices( reinterpret_cast< const uint8_t*  >( Indices ) ); break;
+		case DataType::UNSIGNED_SHORT: s_AttributeRegistry.SetIndices( reinterpret_cast< const uint16_t* >( Indices ) ); break;
+		case DataType::UNSIGNED_INT:   s_AttributeRegistry.SetIndices( reinterpret_cast< const uint32_t* >( Indices ) ); break;
+		default: break;
+	}
+
+	// State and the draw processor are resolved once, then every instance runs through it with its
+	// own per instance attributes.
+	UpdateDrawProcessor();
+
+	for ( uint32_t i = 0; i < a_InstanceCount; ++i )
+	{
+		InstanceID = i;
+		s_AttributeRegistry.SetInstance( i );
+		s_DrawProcessorFunc( 0, a_Count );
+	}
+
+	InstanceID = 0;
+	s_AttributeRegistry.SetInstance( 0 );
+}
+
 void ConsoleGL::Enable( RenderSetting a_RenderSetting )
 {
 	switch ( a_RenderSetting )
@@ -224,6 +271,12 @@ void ConsoleGL::Enable( RenderSetting a_RenderSetting )
 			s_RenderState.CullFace = true;
 			break;
 		}
+		case RenderSetting::TEMPORAL_ACCUMULATION:
+		{
+			s_RenderState.Temporal = true;
+			UpdateRenderTargets();
+			break;
+		}
 		default:
 			break;
 	}
@@ -243,6 +296,12 @@ void ConsoleGL::Disable( RenderSetting a_RenderSetting )
 			s_RenderState.CullFace = false;
 			break;
 		}
+		case RenderSetting::TEMPORAL_ACCUMULATION:
+		{
+			s_RenderState.Temporal = false;
+			UpdateRenderTargets();
+			break;
+		}
 		default:
 			break;
 	}
@@ -300,6 +359,258 @@ void ConsoleGL::GetBooleanv( RenderSetting a_RenderSetting, bool* a_Value )
 	}
 }
 
+void ConsoleGL::SubCell( SubCellMode a_SubCellMode )
+{
+	s_SubCellMode = a_SubCellMode;
+
+	if ( a_SubCellMode != SubCellMode::NONE )
+	{
+		SubCellMap::Init();
+	}
+
+	UpdateRenderTargets();
+}
+
+void ConsoleGL::RenderScale( float a_Scale )
+{
+	s_RenderScale = Math::Clamp( a_Scale, 0.25f, 1.0f );
+	UpdateRenderTargets();
+}
+
+void ConsoleGL::Resolve( const Matrix4* a_ProjectionView )
+{
+	if ( !s_RenderState.Offscreen )
+	{
+		return;
+	}
+
+	const ColourTarget* Samples = &s_ColourTarget;
+
+	if ( s_RenderScale < 1.0f || s_RenderState.Temporal )
+	{
+		Upsample( a_ProjectionView );
+		Samples = &s_OutputTarget;
+	}
+
+	ScreenBuffer& Target = ConsoleWindow::GetCurrentContext()->GetScreenBuffer();
+	const SubCellMap& Map = SubCellMap::Get();
+
+	for ( short y = 0; y < Target.GetHeight(); ++y )
+	{
+		switch ( s_SubCellMode )
+		{
+			case SubCellMode::NONE:
+			{
+				const Colour* Row = Samples->GetRow( y );
+
+				for ( short x = 0; x < Target.GetWidth(); ++x )
+				{
+					Target.SetColour( { x, y }, Row[ x ] );
+				}
+
+				break;
+			}
+			case SubCellMode::HALF:
+			{
+				const Colour* Top = Samples->GetRow( y * 2 );
+				const Colour* Bottom = Samples->GetRow( y * 2 + 1 );
+
+				for ( short x = 0; x < Target.GetWidth(); ++x )
+				{
+					Target.SetPixel( { x, y }, Map.ResolveHalf( Top[ x ], Bottom[ x ] ), Math::Lerp( 0.5f, Vector4( Top[ x ] ), Vector4( Bottom[ x ] ) ) );
+				}
+
+				break;
+			}
+			case SubCellMode::QUADRANT:
+			{
+				const Colour* Top = Samples->GetRow( y * 2 );
+				const Colour* Bottom = Samples->GetRow( y * 2 + 1 );
+
+				for ( short x = 0; x < Target.GetWidth(); ++x, Top += 2, Bottom += 2 )
+				{
+					Vector4 Average = 0.25f * ( Vector4( Top[ 0 ] ) + Vector4( Top[ 1 ] ) + Vector4( Bottom[ 0 ] ) + Vector4( Bottom[ 1 ] ) );
+					Target.SetPixel( { x, y }, Map.ResolveQuadrant( Top, Bottom ), Average );
+				}
+
+				break;
+			}
+		}
+	}
+
+	if ( s_RenderState.Temporal )
+	{
+		// This frame becomes the history of the next one.
+		s_OutputTarget.Swap( s_HistoryTarget );
+		s_HasHistory = a_ProjectionView;
+		s_PreviousProjectionView = a_ProjectionView ? *a_ProjectionView : Matrix4::Identity;
+
+		// Sub-pixel jitter from a Halton( 2, 3 ) sequence so accumulated frames cover different samples.
+		auto Halton = []( uint32_t a_Index, uint32_t a_Base )
+		{
+			float Result = 0.0f, Fraction = 1.0f;
+
+			for ( ; a_Index > 0; a_Index /= a_Base )
+			{
+				Fraction /= a_Base;
+				Result += Fraction * ( a_Index % a_Base );
+			}
+
+			return Result;
+		};
+
+		s_JitterIndex = s_JitterIndex % 8 + 1;
+		s_Jitter = Vector2( Halton( s_JitterIndex, 2 ) - 0.5f, Halton( s_JitterIndex, 3 ) - 0.5f );
+	}
+}
+
+Vector2Int ConsoleGL::GetRenderSize()
+{
+	Vector2Int Size = GetOutputSize();
+
+	if ( s_RenderScale < 1.0f )
+	{
+		Size.x = Math::Max( 1, static_cast< int32_t >( Size.x * s_RenderScale ) );
+		Size.y = Math::Max( 1, static_cast< int32_t >( Size.y * s_RenderScale ) );
+	}
+
+	return Size;
+}
+
+Vector2Int ConsoleGL::GetOutputSize()
+{
+	Vector2Int Size = ConsoleWindow::GetCurrentContext()->GetSize();
+
+	switch ( s_SubCellMode )
+	{
+		case SubCellMode::HALF:     Size.y *= 2; break;
+		case SubCellMode::QUADRANT: Size *= 2; break;
+		default: break;
+	}
+
+	return Size;
+}
+
+uint64_t ConsoleGL::GetShadedFragments()
+{
+	return s_ShadedFragments;
+}
+
+void ConsoleGL::ResetShadedFragments()
+{
+	s_ShadedFragments = 0;
+}
+
+void ConsoleGL::UpdateRenderTargets()
+{
+	s_RenderState.Offscreen = s_SubCellMode != SubCellMode::NONE || s_RenderScale < 1.0f || s_RenderState.Temporal;
+	s_HasHistory = false;
+	s_Jitter = Vector2::Zero;
+
+	if ( s_RenderState.Offscreen )
+	{
+		s_ColourTarget.Init( GetRenderSize() );
+		s_OutputTarget.Init( GetOutputSize() );
+
+		if ( s_RenderState.Temporal )
+		{
+			s_HistoryTarget.Init( GetOutputSize() );
+		}
+	}
+
+	s_DepthBuffer.Init( GetRenderSize() );
+}
+
+void ConsoleGL::Upsample( const Matrix4* a_ProjectionView )
+{
+	Vector2Int Input = s_ColourTarget.GetSize();
+	Vector2Int Output = s_OutputTarget.GetSize();
+	Vector2 Ratio( static_cast< float >( Input.x ) / Output.x, static_cast< float >( Input.y ) / Output.y );
+	bool Accumulate = s_RenderState.Temporal && s_HasHistory;
+	bool Reproject = Accumulate && a_ProjectionView;
+	Matrix4 Inverse;
+	Vector4 InverseDepthAxis;
+
+	if ( Reproject )
+	{
+		Inverse = Math::Inverse( *a_ProjectionView );
+		InverseDepthAxis = Math::Multiply( Inverse, Vector4( 0.0f, 0.0f, 1.0f, 0.0f ) );
+	}
+
+	// Bilinear taps of a target at a pixel position, clamped to its edges.
+	auto Gather = []( const ColourTarget& a_Target, float a_X, float a_Y, Vector4* o_Taps, Vector2& o_Fraction )
+	{
+		Vector2Int Size = a_Target.GetSize();
+		a_X = Math::Clamp( a_X, 0.0f, static_cast< float >( Size.x - 1 ) );
+		a_Y = Math::Clamp( a_Y, 0.0f, static_cast< float >( Size.y - 1 ) );
+		int32_t X0 = static_cast< int32_t >( a_X ), X1 = Math::Min( X0 + 1, Size.x - 1 );
+		int32_t Y0 = static_cast< int32_t >( a_Y ), Y1 = Math::Min( Y0 + 1, Size.y - 1 );
+		o_Taps[ 0 ] = a_Target.GetRow( Y0 )[ X0 ];
+		o_Taps[ 1 ] = a_Target.GetRow( Y0 )[ X1 ];
+		o_Taps[ 2 ] = a_Target.GetRow( Y1 )[ X0 ];
+		o_Taps[ 3 ] = a_Target.GetRow( Y1 )[ X1 ];
+		o_Fraction = Vector2( a_X - X0, a_Y - Y0 );
+	};
+
+	auto Filter = []( const Vector4* a_Taps, const Vector2& a_Fraction )
+	{
+		return Math::Lerp( a_Fraction.y,
+			Math::Lerp( a_Fraction.x, a_Taps[ 0 ], a_Taps[ 1 ] ),
+			Math::Lerp( a_Fraction.x, a_Taps[ 2 ], a_Taps[ 3 ] ) );
+	};
+
+	Vector4 Taps[ 4 ];
+	Vector2 Fraction;
+
+	for ( int32_t y = 0; y < Output.y; ++y )
+	{
+		for ( int32_t x = 0; x < Output.x; ++x )
+		{
+			float SourceX = ( x + 0.5f ) * Ratio.x - 0.5f;
+			float SourceY = ( y + 0.5f ) * Ratio.y - 0.5f;
+			Gather( s_ColourTarget, SourceX, SourceY, Taps, Fraction );
+			Vector4 Current = Filter( Taps, Fraction );
+
+			if ( !Accumulate )
+			{
+				s_OutputTarget.Write( x, y, Current );
+				continue;
+			}
+
+			// Find where this pixel was last frame. Background keeps its screen position.
+			float HistoryX = static_cast< float >( x );
+			float HistoryY = static_cast< float >( y );
+			float Depth = s_DepthBuffer.Get( 
+				Math::Min( static_cast< int32_t >( x * Ratio.x ), Input.x - 1 ), 
+				Math::Min( static_cast< int32_t >( y * Ratio.y ), Input.y - 1 ) );
+
+			if ( Reproject && Depth != s_ClearDepth )
+			{
+				// Depth holds clip space z, solve for clip space w so that the unprojected point has w of 1.
+				Vector2 NDC( ( x + 0.5f ) / Output.x * 2.0f - 1.0f, 1.0f - ( y + 0.5f ) / Output.y * 2.0f );
+				Vector4 Ray = Math::Multiply( Inverse, Vector4( NDC.x, NDC.y, 0.0f, 1.0f ) );
+				float W = ( 1.0f - Depth * InverseDepthAxis.w ) / Ray.w;
+				Vector4 Previous = Math::Multiply( s_PreviousProjectionView, W * Ray + Depth * InverseDepthAxis );
+				HistoryX = ( Previous.x / Previous.w + 1.0f ) * 0.5f * Output.x - 0.5f;
+				HistoryY = ( 1.0f - Previous.y / Previous.w ) * 0.5f * Output.y - 0.5f;
+			}
+
+			if ( HistoryX < 0.0f || HistoryY < 0.0f || HistoryX > Output.x - 1 || HistoryY > Output.y - 1 )
+			{
+				s_OutputTarget.Write( x, y, Current );
+				continue;
+			}
+
+			// Clamp history to the current neighbourhood to limit ghosting.
+			Vector4 Low = Math::Min( Math::Min( Taps[ 0 ], Taps[ 1 ] ), Math::Min( Taps[ 2 ], Taps[ 3 ] ) );
+			Vector4 High = Math::Max( Math::Max( Taps[ 0 ], Taps[ 1 ] ), Math::Max( Taps[ 2 ], Taps[ 3 ] ) );
+			Gather( s_HistoryTarget, HistoryX, HistoryY, Taps, Fraction );
+			Vector4 History = Math::Clamp( Filter( Taps, Fraction ), Low, High );
+			s_OutputTarget.Write( x, y, Math::Lerp( s_TemporalBlend, History, Current ) );
+		}
+	}
+}
+
 int32_t ConsoleGL::GetUniformLocation( ShaderProgramHandle a_ShaderProgramHandle, const char* a_Name )
 {
 	auto& ShaderProgram = s_ShaderProgramRegistry[ a_ShaderProgramHandle ];
@@ -871,6 +1182,26 @@ void ConsoleGL::GenTextures( size_t a_Count, TextureHandle* a_Handles )
 	while ( a_Count-- > 0 ) a_Handles[ a_Count ] = s_TextureRegistry.Create();
 }
 
+void ConsoleGL::DeleteTextures( size_t a_Count, TextureHandle* a_Handles )
+{
+	while ( a_Count-- > 0 )
+	{
+		// Unbind from any texture unit it is bound to.
+		for ( auto& Unit : s_TextureUnits )
+		{
+			for ( auto& Handle : Unit )
+			{
+				if ( Handle == a_Handles[ a_Count ] )
+				{
+					Handle = 0;
+				}
+			}
+		}
+
+		s_TextureRegistry.Destroy( a_Handles[ a_Count ] );
+	}
+}
+
 void ConsoleGL::BindTexture( TextureTarget a_TextureTarget, TextureHandle a_Handle )
 {
 	if ( s_TextureRegistry.Bind( a_TextureTarget, a_Handle ) )
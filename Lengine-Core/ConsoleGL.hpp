@@ -12,6 +12,7 @@
 #include "Utilities.hpp"
 #include "Rect.hpp"
 #include "Rendering.hpp"
+#include "SubCellMap.hpp"
 
 // broad phase filtering: remove OBJECTS that will definitely not show up on screen by using encompassing regions and frustum planes
 // vertex shader transform vertices into clip space
@@ -257,6 +258,7 @@ enum class RenderSetting
 {
 	DEPTH_TEST,
 	CULL_FACE,
+	TEMPORAL_ACCUMULATION,
 	// Incomplete
 };
 
@@ -294,6 +296,13 @@ enum class ClipPlane : uint8_t
 	CLIP_PLANE15
 };
 
+enum class SubCellMode : uint8_t
+{
+	NONE,     // One sample per cell.
+	HALF,     // 1x2 samples per cell.
+	QUADRANT  // 2x2 samples per cell.
+};
+
 struct Sampler2D
 {
 	typedef Vector4 Output;
@@ -356,8 +365,11 @@ public:
 	std::vector< void* >        m_Uniforms;
 };
 
-inline static Vector4 Position;
-inline static Vector4 FragColour;
+inline static Vector4  Position;
+inline static Vector4  FragColour;
+inline static uint32_t InstanceID;
+
+static constexpr uint32_t MaxVertexAttributes = 16;
 
 static ShaderHandle CreateShader( ShaderType a_ShaderType );
 static void ShaderSource( ShaderHandle a_ShaderHandle, uint32_t a_Count, const void** a_Sources, uint32_t* a_Lengths );
@@ -391,15 +403,25 @@ static void DeleteVertexArrays( uint32_t a_Count, ArrayHandle* a_Handles );
 static void EnableVertexAttribArray( uint32_t a_Position );
 static void DisableVertexAttribArray( uint32_t a_Position );
 static void VertexAttribPointer( uint32_t a_Index, uint32_t a_Size, DataType a_DataType, bool a_Normalized, size_t a_Stride, void* a_Offset );
+static void VertexAttribDivisor( uint32_t a_Index, uint32_t a_Divisor );
 static void DrawElements( RenderMode a_Mode, uint32_t a_Count, DataType a_DataType, const void* a_Indices );
+static void DrawElementsInstanced( RenderMode a_Mode, uint32_t a_Count, DataType a_DataType, const void* a_Indices, uint32_t a_InstanceCount );
 static void Enable( RenderSetting a_RenderSetting );
 static void Disable( RenderSetting a_RenderSetting );
 static void CullFace( CullFaceMode a_CullFace );
 static void DepthFunc( TextureSetting a_TextureSetting );
 static void GetBooleanv( RenderSetting a_RenderSetting, bool* a_Value );
 static void ClipPlane( const double* a_Equation );
+static void SubCell( SubCellMode a_SubCellMode );
+static void RenderScale( float a_Scale );
+static void Resolve( const Matrix4* a_ProjectionView );
+static Vector2Int GetRenderSize();
+static Vector2Int GetOutputSize();
+static uint64_t GetShadedFragments();
+static void ResetShadedFragments();
 static void ActiveTexture( uint32_t a_ActiveTexture );
 static void GenTextures( size_t a_Count, TextureHandle* a_Handles );
+static void DeleteTextures( size_t a_Count, TextureHandle* a_Handles );
 static void BindTexture( TextureTarget a_TextureTarget, TextureHandle a_Handle );
 static void TexParameterf( TextureTarget a_TextureTarget, TextureParameter a_TextureParameter, float a_Value );
 static void TexParameterfv( TextureTarget a_TextureTarget, TextureParameter a_TextureParameter, const float* a_Value );
@@ -675,6 +697,7 @@ public:
 	BufferHandle Buffer;
 	uint32_t     Offset;
 	uint32_t     Stride;
+	uint32_t     Divisor;
 	uint8_t      Normalized : 1;
 	uint8_t      Size : 4;
 	uint8_t      Type : 3;
@@ -686,10 +709,18 @@ class BufferRegistry
 {
 public:
 
+	static constexpr size_t Capacity = 1024;
+
 	BufferHandle Create()
 	{
 		size_t Index = 0;
-		while ( m_Availability[ Index++ ] );
+		while ( Index < Capacity && m_Availability[ Index++ ] );
+
+		if ( Index == Capacity && m_Availability[ Index - 1 ] )
+		{
+			return 0;
+		}
+
 		m_Availability[ Index - 1 ] = true;
 		return Index;
 	}
@@ -713,8 +744,8 @@ public:
 
 private:
 
-	std::bitset< 32 >        m_Availability;
-	std::array< Buffer, 32 > m_Buffers;
+	std::bitset< Capacity >        m_Availability;
+	std::array< Buffer, Capacity > m_Buffers;
 };
 
 inline static BufferRegistry                  s_BufferRegistry;
@@ -921,7 +952,7 @@ public:
 };
 
 //typedef std::vector< uint8_t >           Buffer;
-typedef std::array< VertexAttribute, 8 > Array;
+typedef std::array< VertexAttribute, MaxVertexAttributes > Array;
 typedef std::map< void*, uint32_t >      StrideRegistry;
 typedef std::array< TextureHandle, 10  > TextureUnit;
 typedef bool( *DepthCompareFunc )( float, float );
@@ -932,10 +963,18 @@ class ArrayRegistry
 {
 public:
 
+	static constexpr size_t Capacity = 256;
+
 	ArrayHandle Create()
 	{
 		uint32_t Index = 0;
-		while ( m_Availability[ Index++ ] );
+		while ( Index < Capacity && m_Availability[ Index++ ] );
+
+		if ( Index == Capacity && m_Availability[ Index - 1 ] )
+		{
+			return 0;
+		}
+
 		m_Availability[ Index - 1 ] = true;
 		return Index;
 	}
@@ -957,17 +996,25 @@ public:
 
 private:
 
-	std::bitset< 32 >       m_Availability;
-	std::array< Array, 32 > m_Arrays;
+	std::bitset< Capacity >       m_Availability;
+	std::array< Array, Capacity > m_Arrays;
 };
 class TextureRegistry
 {
 public:
 
+	static constexpr size_t Capacity = 256;
+
 	TextureHandle Create()
 	{
 		size_t Index = 0;
-		while ( m_Availability[ Index++ ] );
+		while ( Index < Capacity && m_Availability[ Index++ ] );
+
+		if ( Index == Capacity && m_Availability[ Index - 1 ] )
+		{
+			return 0;
+		}
+
 		m_Availability[ Index - 1 ] = true;
 		m_Targets[ Index - 1 ] = uint8_t( -1 );
 		return Index;
@@ -1003,9 +1050,9 @@ public:
 
 private:
 
-	std::array< int8_t, 32 >  m_Targets;
-	std::bitset< 32 >         m_Availability;
-	std::array< Texture, 32 > m_Textures;
+	std::array< int8_t, Capacity >  m_Targets;
+	std::bitset< Capacity >         m_Availability;
+	std::array< Texture, Capacity > m_Textures;
 };
 class AttributeRegistry
 {
@@ -1042,6 +1089,17 @@ public:
 		m_SeekFunction = Seek< void >;
 	}
 
+	// Attributes with a divisor advance once every divisor instances instead of every vertex.
+	inline void SetDivisor( uint32_t a_Location, uint32_t a_Divisor )
+	{
+		m_Divisors[ a_Location ] = a_Divisor;
+	}
+
+	inline void SetInstance( uint32_t a_Instance )
+	{
+		m_Instance = a_Instance;
+	}
+
 	inline void Reset()
 	{
 		*this = 0u;
@@ -1071,20 +1129,20 @@ private:
 		}
 
 		a_AttributeRegistry->m_Position = a_Index;
-		a_AttributeRegistry->m_VertexAttributes[ 0 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 1 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 2 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 3 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 4 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 5 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 6 ] = Index;
-		a_AttributeRegistry->m_VertexAttributes[ 7 ] = Index;
+
+		for ( uint32_t i = 0; i < MaxVertexAttributes; ++i )
+		{
+			uint32_t Divisor = a_AttributeRegistry->m_Divisors[ i ];
+			a_AttributeRegistry->m_VertexAttributes[ i ] = Divisor ? a_AttributeRegistry->m_Instance / Divisor : Index;
+		}
 	}
 
-	const void* m_Indices;
+	const void*       m_Indices;
 	uint32_t          m_Position;
+	uint32_t          m_Instance = 0;
 	SeekFunction      m_SeekFunction;
-	AttributeIterator m_VertexAttributes[ 8 ];
+	AttributeIterator m_VertexAttributes[ MaxVertexAttributes ];
+	uint32_t          m_Divisors[ MaxVertexAttributes ] = { 0 };
 };
 class ClipPlaneRegistry
 {
@@ -1503,6 +1561,8 @@ class RenderState
 			, BackCull( true )
 			, DepthTest( true )
 			, Clip( true )
+			, Offscreen( false )
+			, Temporal( false )
 		{}
 
 		bool AlphaBlend : 1;
@@ -1513,6 +1573,8 @@ class RenderState
 		bool BackCull : 1;
 		bool DepthTest : 1;
 		bool Clip : 1;
+		bool Offscreen : 1;
+		bool Temporal : 1;
 	};
 
 
@@ -1542,10 +1604,16 @@ class DepthBuffer
 
 		void Init( Vector2Int a_Size )
 		{
+			delete[] m_Buffer;
 			m_Size = a_Size;
 			m_Buffer = new float[ a_Size.x * a_Size.y ];
 		}
 
+		inline float Get( uint32_t a_X, uint32_t a_Y ) const
+		{
+			return m_Buffer[ a_Y * m_Size.x + a_X ];
+		}
+
 		inline bool Test( uint32_t a_X, uint32_t a_Y, float a_Z )
 		{
 			return s_DepthCompareFunc( a_Z, m_Buffer[ a_Y * m_Size.x + a_X ] );
@@ -1585,6 +1653,65 @@ class DepthBuffer
 		float* m_Buffer;
 	};
 
+// Intermediate colour buffer used when rendering at a different resolution to the console.
+class ColourTarget
+	{
+	public:
+
+		ColourTarget()
+			: m_Size( 0 )
+			, m_Buffer( nullptr )
+		{}
+
+		~ColourTarget()
+		{
+			delete[] m_Buffer;
+		}
+
+		void Init( Vector2Int a_Size )
+		{
+			delete[] m_Buffer;
+			m_Size = a_Size;
+			m_Buffer = new Colour[ a_Size.x * a_Size.y ];
+		}
+
+		inline void Write( uint32_t a_X, uint32_t a_Y, Colour a_Colour )
+		{
+			m_Buffer[ a_Y * m_Size.x + a_X ] = a_Colour;
+		}
+
+		inline const Colour* GetRow( uint32_t a_Y ) const
+		{
+			return m_Buffer + a_Y * m_Size.x;
+		}
+
+		inline void Swap( ColourTarget& a_ColourTarget )
+		{
+			std::swap( m_Size, a_ColourTarget.m_Size );
+			std::swap( m_Buffer, a_ColourTarget.m_Buffer );
+		}
+
+		inline Vector2Int GetSize() const
+		{
+			return m_Size;
+		}
+
+		void Reset( Colour a_Colour )
+		{
+			Colour* Begin = m_Buffer, * End = m_Buffer + ( m_Size.x * m_Size.y );
+
+			for ( ; Begin != End; ++Begin )
+			{
+				*Begin = a_Colour;
+			}
+		}
+
+	private:
+
+		Vector2Int m_Size;
+		Colour* m_Buffer;
+	};
+
 template < uint8_t _Interface >
 static bool CullCheck( Vector4* a_P )
 	{
@@ -1593,7 +1720,7 @@ static bool CullCheck( Vector4* a_P )
 		static constexpr bool _CullFront = _Interface & ( 1u << 5u );
 		static constexpr bool _CullBack = _Interface & ( 1u << 4u );
 		static constexpr bool _DepthTest = _Interface & ( 1u << 3u );
-		static constexpr bool _Unused0 = _Interface & ( 1u << 2u );
+		static constexpr bool _Offscreen = _Interface & ( 1u << 2u );
 		static constexpr bool _Unused1 = _Interface & ( 1u << 1u );
 		static constexpr bool _Unused2 = _Interface & ( 1u << 0u );
 
@@ -1638,7 +1765,7 @@ static void RasterizeTriangle( Vector4* a_P, AttribSpan< float >* a_V, uint32_t
 		static constexpr bool _CullFront = _Interface & ( 1u << 5u );
 		static constexpr bool _CullBack = _Interface & ( 1u << 4u );
 		static constexpr bool _DepthTest = _Interface & ( 1u << 3u );
-		static constexpr bool _Unused0 = _Interface & ( 1u << 2u );
+		static constexpr bool _Offscreen = _Interface & ( 1u << 2u );
 		static constexpr bool _Unused1 = _Interface & ( 1u << 1u );
 		static constexpr bool _Unused2 = _Interface & ( 1u << 0u );
 
@@ -1758,8 +1885,16 @@ static void RasterizeTriangle( Vector4* a_P, AttribSpan< float >* a_V, uint32_t
 					}
 
 					a_FragmentShader();
+					++s_ShadedFragments;
 
-					if ( FragColour.w > 0.01f ) ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetColour( { PBegin->x, Y }, FragColour );
+					if constexpr ( _Offscreen )
+					{
+						if ( FragColour.w > 0.01f ) s_ColourTarget.Write( PBegin->x, Y, FragColour );
+					}
+					else
+					{
+						if ( FragColour.w > 0.01f ) ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetColour( { PBegin->x, Y }, FragColour );
+					}
 				}
 
 				*PL += *PStepL;
@@ -1820,7 +1955,16 @@ static void RasterizeTriangle( Vector4* a_P, AttribSpan< float >* a_V, uint32_t
 					}
 
 					a_FragmentShader();
-					if ( FragColour.w > 0.01f ) ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetColour( { PBegin->x, Y }, FragColour );
+					++s_ShadedFragments;
+
+					if constexpr ( _Offscreen )
+					{
+						if ( FragColour.w > 0.01f ) s_ColourTarget.Write( PBegin->x, Y, FragColour );
+					}
+					else
+					{
+						if ( FragColour.w > 0.01f ) ConsoleWindow::GetCurrentContext()->GetScreenBuffer().SetColour( { PBegin->x, Y }, FragColour );
+					}
 				}
 
 				*PL += *PStepL;
@@ -1993,7 +2137,7 @@ static void ProcessVertices( uint32_t a_Begin, uint32_t a_End, uint32_t a_Stride
 		static constexpr bool _CullFront = _Interface & ( 1u << 5u );
 		static constexpr bool _CullBack = _Interface & ( 1u << 4u );
 		static constexpr bool _DepthTest = _Interface & ( 1u << 3u );
-		static constexpr bool _Unused0 = _Interface & ( 1u << 2u );
+		static constexpr bool _Offscreen = _Interface & ( 1u << 2u );
 		static constexpr bool _Unused1 = _Interface & ( 1u << 1u );
 		static constexpr bool _Unused2 = _Interface & ( 1u << 0u );
 
@@ -2041,13 +2185,13 @@ static void ProcessFragments( uint32_t a_Begin, uint32_t a_End, uint32_t a_Strid
 		static constexpr bool _CullFront = _Interface & ( 1u << 5u );
 		static constexpr bool _CullBack = _Interface & ( 1u << 4u );
 		static constexpr bool _DepthTest = _Interface & ( 1u << 3u );
-		static constexpr bool _Unused0 = _Interface & ( 1u << 2u );
+		static constexpr bool _Offscreen = _Interface & ( 1u << 2u );
 		static constexpr bool _Unused1 = _Interface & ( 1u << 1u );
 		static constexpr bool _Unused2 = _Interface & ( 1u << 0u );
 
 		// Prepare screen space size.
 		static Vector2 FullWindow, HalfWindow;
-		FullWindow = Vector2::One * 0.1f + ConsoleWindow::GetCurrentContext()->GetSize();
+		FullWindow = Vector2::One * 0.1f + GetRenderSize();
 		HalfWindow = 0.5f * FullWindow;
 
 		static constexpr auto ConvertToScreenSpace = []( Vector4* a_P )
@@ -2061,7 +2205,8 @@ static void ProcessFragments( uint32_t a_Begin, uint32_t a_End, uint32_t a_Strid
 			a_P->y += 1.0f;
 			a_P->x *= HalfWindow.x;
 			a_P->y *= HalfWindow.y;
-			a_P->y = static_cast< int >( FullWindow.y - a_P->y );
+			a_P->x += s_Jitter.x;
+			a_P->y = static_cast< int >( FullWindow.y - a_P->y + s_Jitter.y );
 		};
 
 		// Get spans that will be set to vertex and position storage.
@@ -2588,11 +2733,28 @@ inline static StrideRegistry                  s_VaryingStrides;
 inline static RenderState                     s_RenderState;
 inline static DepthBuffer                     s_DepthBuffer;
 inline static Pixel                           s_ClearColour;
+inline static Colour                          s_ClearTargetColour;
+inline static ColourTarget                    s_ColourTarget;
+inline static SubCellMode                     s_SubCellMode = SubCellMode::NONE;
+
+// Resolution scaling and temporal accumulation.
+inline static float                           s_RenderScale = 1.0f;
+inline static float                           s_TemporalBlend = 0.2f;
+inline static ColourTarget                    s_OutputTarget;
+inline static ColourTarget                    s_HistoryTarget;
+inline static bool                            s_HasHistory = false;
+inline static Matrix4                         s_PreviousProjectionView;
+inline static Vector2                         s_Jitter;
+inline static uint32_t                        s_JitterIndex = 0;
+inline static uint64_t                        s_ShadedFragments = 0;
 inline static float                           s_ClearDepth;
 inline static std::array< TextureUnit, 32 >   s_TextureUnits;
 inline static uint32_t                        s_ActiveTextureUnit;
 inline static uint32_t                        s_ActiveTextureTarget;
-inline static DrawProcessorFunc               s_DrawProcessorFunc = DrawProcessor< 0b10011111 >;
+inline static DrawProcessorFunc               s_DrawProcessorFunc = DrawProcessor< 0b10011011 >;
+
+static void UpdateRenderTargets();
+static void Upsample( const Matrix4* a_ProjectionView );
 
 static void UpdateDrawProcessor()
 	{
@@ -2601,7 +2763,7 @@ static void UpdateDrawProcessor()
 		//static constexpr bool _CullFront = _Interface & ( 1u << 5u );
 		//static constexpr bool _CullBack = _Interface & ( 1u << 4u );
 		//static constexpr bool _DepthTest = _Interface & ( 1u << 3u );
-		//static constexpr bool _Unused0 = _Interface & ( 1u << 2u );
+		//static constexpr bool _Offscreen = _Interface & ( 1u << 2u );
 		//static constexpr bool _Unused1 = _Interface & ( 1u << 1u );
 		//static constexpr bool _Unused2 = _Interface & ( 1u << 0u );
 
@@ -2612,7 +2774,7 @@ static void UpdateDrawProcessor()
 		if ( s_RenderState.CullFace && s_RenderState.FrontCull ) Interface |= ( 1u << 5u );
 		if ( s_RenderState.CullFace && s_RenderState.BackCull ) Interface |= ( 1u << 4u );
 		if ( s_RenderState.DepthTest ) Interface |= ( 1u << 3u );
-		if ( true ) Interface |= ( 1u << 2u ); // Unused
+		if ( s_RenderState.Offscreen ) Interface |= ( 1u << 2u );
 		if ( true ) Interface |= ( 1u << 1u ); // Unused
 		if ( true ) Interface |= ( 1u << 0u ); // Unused
 
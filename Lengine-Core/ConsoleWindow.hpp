@@ -1,10 +1,12 @@
 #pragma once
 #include <Windows.h>
 #include <thread>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include "Math.hpp"
 #include "Colour.hpp"
 #include "ScreenBuffer.hpp"
+#include "FrameRecorder.hpp"
 #include "PixelColourMap.hpp"
 
 class ConsoleWindow
@@ -16,6 +18,16 @@ public:
     typedef SMALL_RECT  WindowRegion;
     typedef std::thread Thread;
 
+    struct PresentStats
+    {
+        uint64_t Submitted;
+        uint64_t Presented;
+        uint64_t Dropped;
+        uint64_t WrittenCells;
+        float    LastLatency;
+        float    AverageLatency;
+    };
+
     void SetTitle( const char* a_Title )
     {
         size_t Length = strlen( a_Title ) + 1;
@@ -150,17 +162,16 @@ public:
         SetWindowLong( NewWindow->m_WindowHandle, GWL_STYLE, WS_CAPTION | DS_MODALFRAME | WS_MINIMIZEBOX | WS_SYSMENU );
         SetWindowPos( NewWindow->m_WindowHandle, 0, 0, 0, 0, 0, SWP_FRAMECHANGED | SWP_NOSIZE | SWP_NOMOVE | SWP_NOZORDER | SWP_SHOWWINDOW );
         NewWindow->SetTitle( a_Title );
+        NewWindow->m_PresentEvent = CreateEvent( nullptr, false, false, nullptr );
         NewWindow->m_Thread = new Thread( []( ConsoleWindow* a_ConsoleWindow )
                                           {
                                               while ( true )
                                               {
-                                                  std::unique_lock< std::mutex > Locker( a_ConsoleWindow->m_Mutex );
-                                                  a_ConsoleWindow->m_ConditionVariable.wait( Locker );
+                                                  WaitForSingleObject( a_ConsoleWindow->m_PresentEvent, INFINITE );
                                                   
-                                                  if ( a_ConsoleWindow->m_BufferReady )
+                                                  while ( const ScreenFrame* Frame = a_ConsoleWindow->m_ScreenBuffer.AcquireFrontBuffer() )
                                                   {
-                                                      a_ConsoleWindow->WriteBuffer();
-                                                      a_ConsoleWindow->m_BufferReady = false;
+                                                      a_ConsoleWindow->WriteBuffer( *Frame );
                                                   }
                                               }
                                           }, NewWindow );
@@ -182,33 +193,95 @@ public:
         s_ActiveWindow = a_Window;
     }
 
+    // Never blocks. The frame is handed to the present thread and the back buffer is replaced.
     static void SwapBuffers( ConsoleWindow* a_Window )
     {
-        a_Window->m_ScreenBuffer.SwapPixelBuffer();
-        a_Window->DrawBuffer();
+        a_Window->m_SubmittedFrames.fetch_add( 1, std::memory_order_relaxed );
+
+        if ( a_Window->m_Recorder )
+        {
+            a_Window->m_Recorder->Capture( 
+                a_Window->m_ScreenBuffer.GetPixelBuffer(), 
+                a_Window->m_ScreenBuffer.GetColourBuffer(), 
+                ScreenFrame::Clock::now() );
+        }
+
+        if ( !a_Window->m_ScreenBuffer.SwapPixelBuffer( a_Window->m_PresentMode ) )
+        {
+            a_Window->m_DroppedFrames.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        SetEvent( a_Window->m_PresentEvent );
     }
 
-private:
+    inline void SetPresentMode( PresentMode a_PresentMode )
+    {
+        m_PresentMode = a_PresentMode;
+    }
 
-    void DrawBuffer()
+    inline PresentMode GetPresentMode()
     {
-        m_BufferReady = true;
-        m_ConditionVariable.notify_one();
+        return m_PresentMode;
+    }
 
-        //while ( m_BufferReady );
+    // Every submitted frame is captured into a_Recorder until it is replaced or cleared.
+    inline void SetRecorder( FrameRecorder* a_Recorder )
+    {
+        m_Recorder = a_Recorder;
+    }
+
+    inline FrameRecorder* GetRecorder()
+    {
+        return m_Recorder;
+    }
+
+    PresentStats GetPresentStats()
+    {
+        PresentStats Stats;
+        Stats.Submitted      = m_SubmittedFrames.load( std::memory_order_relaxed );
+        Stats.Presented      = m_PresentedFrames.load( std::memory_order_relaxed );
+        Stats.Dropped        = m_DroppedFrames.load( std::memory_order_relaxed );
+        Stats.WrittenCells   = m_WrittenCells.load( std::memory_order_relaxed );
+        Stats.LastLatency    = m_LastLatency.load( std::memory_order_relaxed );
+        Stats.AverageLatency = m_AverageLatency.load( std::memory_order_relaxed );
+        return Stats;
     }
 
-    void WriteBuffer()
+private:
+
+    // Writes only the regions of the frame that differ from what is already on the console.
+    void WriteBuffer( const ScreenFrame& a_Frame )
     {
-        WriteConsoleOutput(
-            m_ConsoleHandle,
-            m_ScreenBuffer.GetPixelBuffer(),
-            { m_ScreenBuffer.GetWidth(), m_ScreenBuffer.GetHeight() },
-            { 0, 0 },
-            &m_WindowRegion );
+        for ( const RectInt& Dirty : m_ScreenBuffer.ResolveDirtyRects( a_Frame ) )
+        {
+            WindowRegion Region;
+            Region.Left = m_WindowRegion.Left + static_cast< short >( Dirty.GetLeft() );
+            Region.Top = m_WindowRegion.Top + static_cast< short >( Dirty.GetBottom() );
+            Region.Right = m_WindowRegion.Left + static_cast< short >( Dirty.GetRight() );
+            Region.Bottom = m_WindowRegion.Top + static_cast< short >( Dirty.GetTop() );
+
+            WriteConsoleOutput(
+                m_ConsoleHandle,
+                a_Frame.Pixels,
+                { m_ScreenBuffer.GetWidth(), m_ScreenBuffer.GetHeight() },
+                { static_cast< short >( Dirty.GetLeft() ), static_cast< short >( Dirty.GetBottom() ) },
+                &Region );
+
+            m_WrittenCells.fetch_add( static_cast< uint64_t >( Dirty.Size.x ) * Dirty.Size.y, std::memory_order_relaxed );
+        }
+
+        // Latency is measured from submission to the end of the console write.
+        float Latency = std::chrono::duration< float >( ScreenFrame::Clock::now() - a_Frame.Submitted ).count();
+        float Average = m_AverageLatency.load( std::memory_order_relaxed );
+        Average = m_PresentedFrames.load( std::memory_order_relaxed ) ? Average + ( Latency - Average ) * 0.1f : Latency;
+        m_LastLatency.store( Latency, std::memory_order_relaxed );
+        m_AverageLatency.store( Average, std::memory_order_relaxed );
+        m_PresentedFrames.fetch_add( 1, std::memory_order_relaxed );
     }
 
-    bool                         m_BufferReady;
+    PresentMode                  m_PresentMode = PresentMode::LATEST;
+    FrameRecorder*               m_Recorder = nullptr;
+    HANDLE                       m_PresentEvent;
     ConsoleHandle                m_ConsoleHandle;
     WindowHandle                 m_WindowHandle;
     WindowRegion                 m_WindowRegion;
@@ -217,7 +290,11 @@ private:
     std::string                  m_Title;
     ScreenBuffer                 m_ScreenBuffer;
     Thread*                      m_Thread;
-    std::condition_variable      m_ConditionVariable;
-    std::mutex                   m_Mutex;
+    std::atomic< uint64_t >      m_SubmittedFrames = 0;
+    std::atomic< uint64_t >      m_PresentedFrames = 0;
+    std::atomic< uint64_t >      m_DroppedFrames = 0;
+    std::atomic< uint64_t >      m_WrittenCells = 0;
+    std::atomic< float >         m_LastLatency = 0.0f;
+    std::atomic< float >         m_AverageLatency = 0.0f;
     inline static ConsoleWindow* s_ActiveWindow;
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <emmintrin.h>
+
+#include "DepthRasterizer.hpp"
+#include "Mesh.hpp"
+
+DepthRasterizer::DepthRasterizer()
+	: m_Depth( nullptr )
+	, m_Width( 0 )
+	, m_Height( 0 )
+	, m_ProjectionView( Matrix4::Identity )
+{ }
+
+void DepthRasterizer::Begin( const Matrix4& a_ProjectionView, float* a_Depth, uint32_t a_Width, uint32_t a_Height, bool a_Clear )
+{
+	m_Depth = a_Depth;
+	m_Width = a_Width;
+	m_Height = a_Height;
+	m_ProjectionView = a_ProjectionView;
+
+	if ( a_Clear )
+	{
+		std::fill( m_Depth, m_Depth + a_Width * a_Height, 1.0f );
+	}
+}
+
+uint32_t DepthRasterizer::Rasterize( const Mesh& a_Mesh, const Matrix4& a_Model )
+{
+	float PVM[ 4 ][ 4 ];
+	LoadRows( Math::Multiply( m_ProjectionView, a_Model ), PVM );
+
+	// Project every vertex once, triangles share most of them.
+	uint32_t VertexCount = a_Mesh.GetVertexCount();
+	const Vector3* Positions = a_Mesh.GetPositions();
+	m_Vertices.resize( VertexCount );
+	m_Clipped.resize( VertexCount );
+
+	for ( uint32_t i = 0; i < VertexCount; ++i )
+	{
+		float W = TransformRow( PVM, 3, Positions[ i ] );
+		m_Clipped[ i ] = W < NearW;
+
+		if ( !m_Clipped[ i ] )
+		{
+			float InverseW = 1.0f / W;
+			m_Vertices[ i ].x = ( TransformRow( PVM, 0, Positions[ i ] ) * InverseW * 0.5f + 0.5f ) * m_Width;
+			m_Vertices[ i ].y = ( TransformRow( PVM, 1, Positions[ i ] ) * InverseW * 0.5f + 0.5f ) * m_Height;
+			m_Vertices[ i ].z =   TransformRow( PVM, 2, Positions[ i ] ) * InverseW;
+		}
+	}
+
+	uint32_t IndexCount = a_Mesh.GetIndexCount();
+	const uint32_t* Indices = a_Mesh.GetIndices();
+	uint32_t Triangles = 0;
+
+	for ( uint32_t i = 0; i + 2 < IndexCount; i += 3 )
+	{
+		uint32_t A = Indices[ i ], B = Indices[ i + 1 ], C = Indices[ i + 2 ];
+
+		if ( m_Clipped[ A ] | m_Clipped[ B ] | m_Clipped[ C ] )
+		{
+			continue;
+		}
+
+		RasterizeTriangle( m_Vertices[ A ], m_Vertices[ B ], m_Vertices[ C ] );
+		++Triangles;
+	}
+
+	return Triangles;
+}
+
+void DepthRasterizer::RasterizeTriangle( ScreenVertex a_A, ScreenVertex a_B, ScreenVertex a_C )
+{
+	float Area = ( a_B.x - a_A.x ) * ( a_C.y - a_A.y ) - ( a_B.y - a_A.y ) * ( a_C.x - a_A.x );
+
+	// Both windings are drawn, occluders don't have to be closed.
+	if ( Area < 0.0f )
+	{
+		std::swap( a_B, a_C );
+		Area = -Area;
+	}
+
+	if ( Area < 1e-6f )
+	{
+		return;
+	}
+
+	// Clamped as floats first, projected vertices can lie far outside the buffer.
+	int32_t MinX = static_cast< int32_t >( Math::Clamp( Math::Min( a_A.x, Math::Min( a_B.x, a_C.x ) ), 0.0f, static_cast< float >( m_Width ) ) );
+	int32_t MinY = static_cast< int32_t >( Math::Clamp( Math::Min( a_A.y, Math::Min( a_B.y, a_C.y ) ), 0.0f, static_cast< float >( m_Height ) ) );
+	int32_t MaxX = static_cast< int32_t >( Math::Clamp( Math::Max( a_A.x, Math::Max( a_B.x, a_C.x ) ), -1.0f, m_Width - 1.0f ) );
+	int32_t MaxY = static_cast< int32_t >( Math::Clamp( Math::Max( a_A.y, Math::Max( a_B.y, a_C.y ) ), -1.0f, m_Height - 1.0f ) );
+
+	if ( MinX > MaxX || MinY > MaxY )
+	{
+		return;
+	}
+
+	// Edge functions, positive inside. Each is opposite the vertex it weights for depth.
+	float EdgeX[ 3 ] = { a_B.y - a_C.y, a_C.y - a_A.y, a_A.y - a_B.y };
+	float EdgeY[ 3 ] = { a_C.x - a_B.x, a_A.x - a_C.x, a_B.x - a_A.x };
+	float EdgeC[ 3 ] =
+	{
+		-( EdgeX[ 0 ] * a_B.x + EdgeY[ 0 ] * a_B.y ),
+		-( EdgeX[ 1 ] * a_C.x + EdgeY[ 1 ] * a_C.y ),
+		-( EdgeX[ 2 ] * a_A.x + EdgeY[ 2 ] * a_A.y )
+	};
+
+	float InverseArea = 1.0f / Area;
+	float DepthX = ( EdgeX[ 0 ] * a_A.z + EdgeX[ 1 ] * a_B.z + EdgeX[ 2 ] * a_C.z ) * InverseArea;
+	float DepthY = ( EdgeY[ 0 ] * a_A.z + EdgeY[ 1 ] * a_B.z + EdgeY[ 2 ] * a_C.z ) * InverseArea;
+	float DepthC = ( EdgeC[ 0 ] * a_A.z + EdgeC[ 1 ] * a_B.z + EdgeC[ 2 ] * a_C.z ) * InverseArea;
+
+	// Rows start on a multiple of four so the buffer can be walked in whole blocks.
+	int32_t StartX = MinX & ~3;
+	__m128 Offsets = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+	__m128 PixelX = _mm_add_ps( _mm_set1_ps( static_cast< float >( StartX ) ), Offsets );
+	__m128 Step[ 3 ];
+	__m128 Row[ 3 ];
+
+	for ( uint32_t e = 0; e < 3; ++e )
+	{
+		Step[ e ] = _mm_set1_ps( EdgeX[ e ] * 4.0f );
+	}
+
+	__m128 DepthStep = _mm_set1_ps( DepthX * 4.0f );
+
+	for ( int32_t y = MinY; y <= MaxY; ++y )
+	{
+		float PixelY = static_cast< float >( y ) + 0.5f;
+
+		for ( uint32_t e = 0; e < 3; ++e )
+		{
+			Row[ e ] = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( EdgeX[ e ] ), PixelX ), _mm_set1_ps( EdgeY[ e ] * PixelY + EdgeC[ e ] ) );
+		}
+
+		__m128 Depth = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( DepthX ), PixelX ), _mm_set1_ps( DepthY * PixelY + DepthC ) );
+		float* Destination = m_Depth + y * m_Width;
+
+		for ( int32_t x = StartX; x <= MaxX; x += 4 )
+		{
+			// A pixel is outside if any edge function is negative, the sign bits tell.
+			__m128 Signs = _mm_or_ps( Row[ 0 ], _mm_or_ps( Row[ 1 ], Row[ 2 ] ) );
+			__m128 Outside = _mm_castsi128_ps( _mm_srai_epi32( _mm_castps_si128( Signs ), 31 ) );
+
+			if ( _mm_movemask_ps( Outside ) != 0xF )
+			{
+				__m128 Stored = _mm_loadu_ps( Destination + x );
+				__m128 Nearest = _mm_min_ps( Stored, Depth );
+				_mm_storeu_ps( Destination + x, _mm_or_ps( _mm_and_ps( Outside, Stored ), _mm_andnot_ps( Outside, Nearest ) ) );
+			}
+
+			for ( uint32_t e = 0; e < 3; ++e )
+			{
+				Row[ e ] = _mm_add_ps( Row[ e ], Step[ e ] );
+			}
+
+			Depth = _mm_add_ps( Depth, DepthStep );
+		}
+	}
+}
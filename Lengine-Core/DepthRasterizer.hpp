@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.hpp"
+
+class Mesh;
+
+// Draws meshes into a float depth buffer keeping the nearest depth, four pixels at a time. Nothing
+// but depth is produced, there is no shading and no attributes are interpolated. Both windings are
+// drawn, and triangles crossing the near plane are skipped.
+class DepthRasterizer
+{
+public:
+
+	// Clip space w below this counts as crossing the near plane.
+	static constexpr float NearW = 1e-4f;
+
+	DepthRasterizer();
+
+	// Draws into a_Depth from here on, which holds a_Width * a_Height floats. a_Width must be a
+	// multiple of four. The buffer is cleared to 1 unless a_Clear is false, so the contents of an
+	// earlier pass can be drawn over.
+	void Begin( const Matrix4& a_ProjectionView, float* a_Depth, uint32_t a_Width, uint32_t a_Height, bool a_Clear = true );
+
+	// Returns the number of triangles rasterized.
+	uint32_t Rasterize( const Mesh& a_Mesh, const Matrix4& a_Model );
+
+	inline const Matrix4& GetProjectionView() const
+	{
+		return m_ProjectionView;
+	}
+
+	inline static void LoadRows( const Matrix4& a_Matrix, float( &o_Rows )[ 4 ][ 4 ] )
+	{
+		for ( uint32_t r = 0; r < 4; ++r )
+		{
+			const auto& Row = a_Matrix.GetRow( r );
+
+			for ( uint32_t c = 0; c < 4; ++c )
+			{
+				o_Rows[ r ][ c ] = Row[ c ];
+			}
+		}
+	}
+
+	inline static float TransformRow( const float( &a_Rows )[ 4 ][ 4 ], uint32_t a_Row, const Vector3& a_Point )
+	{
+		return a_Rows[ a_Row ][ 0 ] * a_Point.x + a_Rows[ a_Row ][ 1 ] * a_Point.y + a_Rows[ a_Row ][ 2 ] * a_Point.z + a_Rows[ a_Row ][ 3 ];
+	}
+
+private:
+
+	struct ScreenVertex
+	{
+		float x, y, z;
+	};
+
+	void RasterizeTriangle( ScreenVertex a_A, ScreenVertex a_B, ScreenVertex a_C );
+
+	float*                      m_Depth;
+	uint32_t                    m_Width;
+	uint32_t                    m_Height;
+	std::vector< ScreenVertex > m_Vertices;
+	std::vector< uint8_t >      m_Clipped;
+	Matrix4                     m_ProjectionView;
+};
@@ -0,0 +1,416 @@
+#include "FrameRecorder.hpp"
+#include "ConsoleWindow.hpp"
+
+static_assert( sizeof( Pixel ) == sizeof( uint32_t ), "Recordings expect 32 bit pixels." );
+static_assert( sizeof( Colour ) == sizeof( uint32_t ), "Recordings expect 32 bit colours." );
+
+template < typename T >
+static inline void WriteValue( FILE* a_File, const T& a_Value )
+{
+	fwrite( &a_Value, sizeof( T ), 1, a_File );
+}
+
+template < typename T >
+static inline bool ReadValue( FILE* a_File, T& o_Value )
+{
+	return fread( &o_Value, sizeof( T ), 1, a_File ) == 1;
+}
+
+// FrameRecording...
+void FrameRecording::Encode( const uint32_t* a_Current, const uint32_t* a_Previous, size_t a_Count, std::vector< uint8_t >& o_Output )
+{
+	o_Output.clear();
+
+	auto Word = [&]( size_t a_Index )
+	{
+		return a_Previous ? a_Current[ a_Index ] ^ a_Previous[ a_Index ] : a_Current[ a_Index ];
+	};
+
+	auto Append = [&]( uint32_t a_Word )
+	{
+		size_t Offset = o_Output.size();
+		o_Output.resize( Offset + sizeof( uint32_t ) );
+		memcpy( o_Output.data() + Offset, &a_Word, sizeof( uint32_t ) );
+	};
+
+	size_t Index = 0;
+
+	while ( Index < a_Count )
+	{
+		uint32_t Value = Word( Index );
+		size_t Run = 1;
+
+		while ( Index + Run < a_Count && Run < 128 && Word( Index + Run ) == Value )
+		{
+			++Run;
+		}
+
+		if ( Run > 1 )
+		{
+			o_Output.push_back( static_cast< uint8_t >( 0x80 | ( Run - 1 ) ) );
+			Append( Value );
+			Index += Run;
+			continue;
+		}
+
+		// Gather literals until the next repeat.
+		size_t Literals = 1;
+
+		while ( Index + Literals < a_Count && Literals < 128 )
+		{
+			if ( Index + Literals + 1 < a_Count && Word( Index + Literals ) == Word( Index + Literals + 1 ) )
+			{
+				break;
+			}
+
+			++Literals;
+		}
+
+		o_Output.push_back( static_cast< uint8_t >( Literals - 1 ) );
+
+		for ( size_t i = 0; i < Literals; ++i )
+		{
+			Append( Word( Index + i ) );
+		}
+
+		Index += Literals;
+	}
+}
+
+bool FrameRecording::Decode( const uint8_t* a_Input, size_t a_Size, uint32_t* o_Words, size_t a_Count, bool a_Delta )
+{
+	const uint8_t* End = a_Input + a_Size;
+	size_t Index = 0;
+
+	while ( a_Input < End && Index < a_Count )
+	{
+		uint8_t Control = *a_Input++;
+		size_t Count = ( Control & 0x7F ) + 1;
+		bool Repeat = Control & 0x80;
+		size_t Bytes = Repeat ? sizeof( uint32_t ) : Count * sizeof( uint32_t );
+
+		if ( End - a_Input < static_cast< ptrdiff_t >( Bytes ) || Index + Count > a_Count )
+		{
+			return false;
+		}
+
+		for ( size_t i = 0; i < Count; ++i, ++Index )
+		{
+			uint32_t Value;
+			memcpy( &Value, a_Input + ( Repeat ? 0 : i * sizeof( uint32_t ) ), sizeof( uint32_t ) );
+			o_Words[ Index ] = a_Delta ? o_Words[ Index ] ^ Value : Value;
+		}
+
+		a_Input += Bytes;
+	}
+
+	return Index == a_Count && a_Input == End;
+}
+
+// FrameRecorder...
+FrameRecorder::FrameRecorder()
+	: m_File( nullptr )
+	, m_Thread( nullptr )
+	, m_Stopping( false )
+	, m_Slots()
+	, m_Size()
+	, m_KeyframeInterval( 0 )
+	, m_CapturedFrames( 0 )
+	, m_RecordedFrames( 0 )
+	, m_SkippedFrames( 0 )
+	, m_WrittenFrames( 0 )
+{ }
+
+FrameRecorder::~FrameRecorder()
+{
+	Stop();
+}
+
+bool FrameRecorder::Start( const char* a_Path, Vector< short, 2 > a_Size, uint16_t a_KeyframeInterval )
+{
+	if ( m_File || fopen_s( &m_File, a_Path, "wb" ) )
+	{
+		return false;
+	}
+
+	size_t Area = static_cast< size_t >( a_Size.x ) * a_Size.y;
+	m_Size = a_Size;
+	m_KeyframeInterval = a_KeyframeInterval ? a_KeyframeInterval : 1;
+	m_CapturedFrames = 0;
+	m_WrittenFrames = 0;
+	m_RecordedFrames = 0;
+	m_SkippedFrames = 0;
+	m_Stopping = false;
+	m_StartTime = Clock::now();
+	m_PreviousPixels.assign( Area, 0 );
+	m_PreviousColours.assign( Area, 0 );
+
+	for ( Slot& CaptureSlot : m_Slots )
+	{
+		CaptureSlot.Pixels.resize( Area );
+		CaptureSlot.Colours.resize( Area );
+		CaptureSlot.State = SlotState::FREE;
+	}
+
+	fwrite( FrameRecording::Magic, 1, sizeof( FrameRecording::Magic ), m_File );
+	WriteValue( m_File, FrameRecording::Version );
+	WriteValue( m_File, a_Size.x );
+	WriteValue( m_File, a_Size.y );
+	WriteValue( m_File, m_KeyframeInterval );
+
+	m_Thread = new std::thread( &FrameRecorder::WriteLoop, this );
+	return true;
+}
+
+void FrameRecorder::Stop()
+{
+	if ( !m_File )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > Lock( m_Mutex );
+		m_Stopping = true;
+	}
+
+	m_ConditionVariable.notify_one();
+	m_Thread->join();
+	delete m_Thread;
+	m_Thread = nullptr;
+	fclose( m_File );
+	m_File = nullptr;
+}
+
+bool FrameRecorder::Capture( const Pixel* a_Pixels, const Colour* a_Colours, Clock::time_point a_Time )
+{
+	if ( !m_File )
+	{
+		return false;
+	}
+
+	Slot* Target = nullptr;
+
+	{
+		std::lock_guard< std::mutex > Lock( m_Mutex );
+
+		for ( Slot& CaptureSlot : m_Slots )
+		{
+			if ( CaptureSlot.State == SlotState::FREE )
+			{
+				Target = &CaptureSlot;
+				Target->State = SlotState::FILLING;
+				break;
+			}
+		}
+	}
+
+	if ( !Target )
+	{
+		m_SkippedFrames.fetch_add( 1, std::memory_order_relaxed );
+		return false;
+	}
+
+	size_t Area = static_cast< size_t >( m_Size.x ) * m_Size.y;
+	memcpy( Target->Pixels.data(), a_Pixels, Area * sizeof( uint32_t ) );
+	memcpy( Target->Colours.data(), a_Colours, Area * sizeof( uint32_t ) );
+	Target->Index = m_CapturedFrames++;
+	Target->Timestamp = std::chrono::duration_cast< std::chrono::microseconds >( a_Time - m_StartTime ).count();
+
+	{
+		std::lock_guard< std::mutex > Lock( m_Mutex );
+		Target->State = SlotState::READY;
+	}
+
+	m_ConditionVariable.notify_one();
+	return true;
+}
+
+void FrameRecorder::WriteLoop()
+{
+	while ( true )
+	{
+		Slot* Next = nullptr;
+
+		{
+			std::unique_lock< std::mutex > Lock( m_Mutex );
+
+			// Frames are written oldest first, pending frames are still written when stopping.
+			auto FindReady = [&]()
+			{
+				Next = nullptr;
+
+				for ( Slot& CaptureSlot : m_Slots )
+				{
+					if ( CaptureSlot.State == SlotState::READY && ( !Next || CaptureSlot.Index < Next->Index ) )
+					{
+						Next = &CaptureSlot;
+					}
+				}
+
+				return Next || m_Stopping;
+			};
+
+			m_ConditionVariable.wait( Lock, FindReady );
+
+			if ( !Next )
+			{
+				return;
+			}
+
+			Next->State = SlotState::WRITING;
+		}
+
+		WriteFrame( *Next );
+
+		{
+			std::lock_guard< std::mutex > Lock( m_Mutex );
+			Next->State = SlotState::FREE;
+		}
+
+		m_RecordedFrames.fetch_add( 1, std::memory_order_relaxed );
+	}
+}
+
+void FrameRecorder::WriteFrame( const Slot& a_Slot )
+{
+	size_t Area = static_cast< size_t >( m_Size.x ) * m_Size.y;
+	bool Keyframe = m_WrittenFrames % m_KeyframeInterval == 0;
+
+	FrameRecording::Encode( a_Slot.Pixels.data(), Keyframe ? nullptr : m_PreviousPixels.data(), Area, m_PixelStream );
+	FrameRecording::Encode( a_Slot.Colours.data(), Keyframe ? nullptr : m_PreviousColours.data(), Area, m_ColourStream );
+
+	WriteValue( m_File, Keyframe ? FrameRecording::FrameType::KEY : FrameRecording::FrameType::DELTA );
+	WriteValue( m_File, a_Slot.Index );
+	WriteValue( m_File, a_Slot.Timestamp );
+	WriteValue( m_File, static_cast< uint32_t >( m_PixelStream.size() ) );
+	WriteValue( m_File, static_cast< uint32_t >( m_ColourStream.size() ) );
+	fwrite( m_PixelStream.data(), 1, m_PixelStream.size(), m_File );
+	fwrite( m_ColourStream.data(), 1, m_ColourStream.size(), m_File );
+
+	m_PreviousPixels = a_Slot.Pixels;
+	m_PreviousColours = a_Slot.Colours;
+	++m_WrittenFrames;
+}
+
+// FramePlayer...
+FramePlayer::FramePlayer()
+	: m_File( nullptr )
+	, m_FirstFrame( 0 )
+	, m_Size()
+	, m_FrameIndex( 0 )
+	, m_Timestamp( 0 )
+{ }
+
+FramePlayer::~FramePlayer()
+{
+	Close();
+}
+
+bool FramePlayer::Open( const char* a_Path )
+{
+	Close();
+
+	if ( fopen_s( &m_File, a_Path, "rb" ) )
+	{
+		m_File = nullptr;
+		return false;
+	}
+
+	char Magic[ 4 ];
+	uint16_t Version;
+	uint16_t KeyframeInterval;
+
+	if ( fread( Magic, 1, sizeof( Magic ), m_File ) != sizeof( Magic ) ||
+		 memcmp( Magic, FrameRecording::Magic, sizeof( Magic ) ) ||
+		 !ReadValue( m_File, Version ) || Version != FrameRecording::Version ||
+		 !ReadValue( m_File, m_Size.x ) ||
+		 !ReadValue( m_File, m_Size.y ) ||
+		 !ReadValue( m_File, KeyframeInterval ) )
+	{
+		Close();
+		return false;
+	}
+
+	size_t Area = static_cast< size_t >( m_Size.x ) * m_Size.y;
+	m_Pixels.assign( Area, 0 );
+	m_Colours.assign( Area, 0 );
+	m_FirstFrame = ftell( m_File );
+	return true;
+}
+
+void FramePlayer::Close()
+{
+	if ( m_File )
+	{
+		fclose( m_File );
+		m_File = nullptr;
+	}
+}
+
+bool FramePlayer::Rewind()
+{
+	return m_File && !fseek( m_File, m_FirstFrame, SEEK_SET );
+}
+
+bool FramePlayer::Next()
+{
+	if ( !m_File )
+	{
+		return false;
+	}
+
+	FrameRecording::FrameType Type;
+	uint32_t PixelBytes;
+	uint32_t ColourBytes;
+
+	if ( !ReadValue( m_File, Type ) ||
+		 !ReadValue( m_File, m_FrameIndex ) ||
+		 !ReadValue( m_File, m_Timestamp ) ||
+		 !ReadValue( m_File, PixelBytes ) ||
+		 !ReadValue( m_File, ColourBytes ) )
+	{
+		return false;
+	}
+
+	bool Delta = Type == FrameRecording::FrameType::DELTA;
+	m_Stream.resize( static_cast< size_t >( PixelBytes ) + ColourBytes );
+
+	return
+		fread( m_Stream.data(), 1, m_Stream.size(), m_File ) == m_Stream.size() &&
+		FrameRecording::Decode( m_Stream.data(), PixelBytes, m_Pixels.data(), m_Pixels.size(), Delta ) &&
+		FrameRecording::Decode( m_Stream.data() + PixelBytes, ColourBytes, m_Colours.data(), m_Colours.size(), Delta );
+}
+
+void FramePlayer::Play( ConsoleWindow* a_Window, bool a_RecordedSpeed )
+{
+	ScreenBuffer& Target = a_Window->GetScreenBuffer();
+	short Width = Math::Min( Target.GetWidth(), m_Size.x );
+	short Height = Math::Min( Target.GetHeight(), m_Size.y );
+	auto PlaybackStart = FrameRecorder::Clock::now();
+	bool First = true;
+	uint64_t FirstTimestamp = 0;
+
+	while ( Next() )
+	{
+		if ( First )
+		{
+			FirstTimestamp = m_Timestamp;
+			First = false;
+		}
+
+		if ( a_RecordedSpeed )
+		{
+			std::this_thread::sleep_until( PlaybackStart + std::chrono::microseconds( m_Timestamp - FirstTimestamp ) );
+		}
+
+		for ( short y = 0; y < Height; ++y )
+		{
+			memcpy( Target.GetPixelBuffer() + y * Target.GetWidth(), GetPixels() + y * m_Size.x, Width * sizeof( Pixel ) );
+			memcpy( Target.GetColourBuffer() + y * Target.GetWidth(), GetColours() + y * m_Size.x, Width * sizeof( Colour ) );
+		}
+
+		Target.MarkDirty( RectInt( 0, 0, Width, Height ) );
+		ConsoleWindow::SwapBuffers( a_Window );
+	}
+}
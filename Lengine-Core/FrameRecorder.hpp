@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+#include "ScreenBuffer.hpp"
+
+class ConsoleWindow;
+
+// Recording file layout:
+//   Header  : "LFRC", uint16 version, int16 width, int16 height, uint16 keyframe interval.
+//   Frame   : uint8 type, uint64 frame index, uint64 microseconds since start,
+//             uint32 pixel bytes, uint32 colour bytes, pixel stream, colour stream.
+// Pixels and colours are both 32 bit words. Keyframes store the words directly, delta frames store
+// them XOR'd with the previous frame. Both are then run-length encoded: a control byte with the top
+// bit set is followed by one word repeated ( control & 0x7F ) + 1 times, otherwise it is followed by
+// control + 1 literal words.
+class FrameRecording
+{
+public:
+
+	enum class FrameType : uint8_t
+	{
+		KEY,
+		DELTA
+	};
+
+	static constexpr char     Magic[ 4 ] = { 'L', 'F', 'R', 'C' };
+	static constexpr uint16_t Version    = 1;
+
+	static void Encode( const uint32_t* a_Current, const uint32_t* a_Previous, size_t a_Count, std::vector< uint8_t >& o_Output );
+	static bool Decode( const uint8_t* a_Input, size_t a_Size, uint32_t* o_Words, size_t a_Count, bool a_Delta );
+};
+
+// Streams submitted ScreenBuffer frames to a recording file. Capture only copies the buffers into one
+// of two slots, encoding and writing happen on a background thread. If both slots are still in use
+// the frame is skipped rather than stalling the caller.
+class FrameRecorder
+{
+public:
+
+	typedef ScreenFrame::Clock Clock;
+
+	FrameRecorder();
+	~FrameRecorder();
+	bool Start( const char* a_Path, Vector< short, 2 > a_Size, uint16_t a_KeyframeInterval = 60 );
+	void Stop();
+	bool Capture( const Pixel* a_Pixels, const Colour* a_Colours, Clock::time_point a_Time );
+
+	inline bool IsRecording() const
+	{
+		return m_File;
+	}
+
+	inline uint64_t GetRecordedFrames() const
+	{
+		return m_RecordedFrames.load( std::memory_order_relaxed );
+	}
+
+	inline uint64_t GetSkippedFrames() const
+	{
+		return m_SkippedFrames.load( std::memory_order_relaxed );
+	}
+
+private:
+
+	enum class SlotState : uint8_t
+	{
+		FREE,
+		FILLING,
+		READY,
+		WRITING
+	};
+
+	struct Slot
+	{
+		std::vector< uint32_t > Pixels;
+		std::vector< uint32_t > Colours;
+		uint64_t                Index;
+		uint64_t                Timestamp;
+		SlotState               State;
+	};
+
+	void WriteLoop();
+	void WriteFrame( const Slot& a_Slot );
+
+	FILE*                   m_File;
+	std::thread*            m_Thread;
+	std::mutex              m_Mutex;
+	std::condition_variable m_ConditionVariable;
+	bool                    m_Stopping;
+	Slot                    m_Slots[ 2 ];
+	Vector< short, 2 >      m_Size;
+	uint16_t                m_KeyframeInterval;
+	uint64_t                m_CapturedFrames;
+	Clock::time_point       m_StartTime;
+	std::atomic< uint64_t > m_RecordedFrames;
+	std::atomic< uint64_t > m_SkippedFrames;
+
+	// Writer thread only.
+	std::vector< uint32_t > m_PreviousPixels;
+	std::vector< uint32_t > m_PreviousColours;
+	std::vector< uint8_t >  m_PixelStream;
+	std::vector< uint8_t >  m_ColourStream;
+	uint64_t                m_WrittenFrames;
+};
+
+// Reads a recording back one frame at a time. The decoded buffers can be handed to any present
+// backend, or replayed straight into a ConsoleWindow with Play.
+class FramePlayer
+{
+public:
+
+	FramePlayer();
+	~FramePlayer();
+	bool Open( const char* a_Path );
+	void Close();
+	bool Rewind();
+	bool Next();
+	void Play( ConsoleWindow* a_Window, bool a_RecordedSpeed = true );
+
+	inline bool IsOpen() const
+	{
+		return m_File;
+	}
+
+	inline const Pixel* GetPixels() const
+	{
+		return reinterpret_cast< const Pixel* >( m_Pixels.data() );
+	}
+
+	inline const Colour* GetColours() const
+	{
+		return reinterpret_cast< const Colour* >( m_Colours.data() );
+	}
+
+	inline Vector< short, 2 > GetSize() const
+	{
+		return m_Size;
+	}
+
+	inline uint64_t GetFrameIndex() const
+	{
+		return m_FrameIndex;
+	}
+
+	// Microseconds since the recording started.
+	inline uint64_t GetTimestamp() const
+	{
+		return m_Timestamp;
+	}
+
+private:
+
+	FILE*                   m_File;
+	long                    m_FirstFrame;
+	Vector< short, 2 >      m_Size;
+	std::vector< uint32_t > m_Pixels;
+	std::vector< uint32_t > m_Colours;
+	std::vector< uint8_t >  m_Stream;
+	uint64_t                m_FrameIndex;
+	uint64_t                m_Timestamp;
+};
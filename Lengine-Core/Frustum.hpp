@@ -1,45 +1,106 @@
 #pragma once
 #include "Math.hpp"
+#include "Bounds.hpp"
 #include "Camera.hpp"
 
+// Planes are extracted from the rows of the projection view matrix, with their normals pointing
+// into the frustum. A point is inside when its distance from every plane is positive.
 struct Frustum
 {
+	enum class Containment : uint8_t
+	{
+		OUTSIDE,
+		INTERSECTING,
+		INSIDE
+	};
+
+	// Plane mask with every plane enabled.
+	static constexpr uint8_t AllPlanes = 0x3F;
+
 	Frustum( const Camera& a_Camera )
+		: Frustum( a_Camera.GetProjectionViewMatrix() )
+	{ }
+
+	Frustum( const Matrix4& a_ProjectionView )
+	{
+		const auto& X = a_ProjectionView.GetRow( 0 );
+		const auto& Y = a_ProjectionView.GetRow( 1 );
+		const auto& Z = a_ProjectionView.GetRow( 2 );
+		const auto& W = a_ProjectionView.GetRow( 3 );
+
+		Left   = Geometry::Normalize( Plane( W[ 0 ] + X[ 0 ], W[ 1 ] + X[ 1 ], W[ 2 ] + X[ 2 ], W[ 3 ] + X[ 3 ] ) );
+		Right  = Geometry::Normalize( Plane( W[ 0 ] - X[ 0 ], W[ 1 ] - X[ 1 ], W[ 2 ] - X[ 2 ], W[ 3 ] - X[ 3 ] ) );
+		Top    = Geometry::Normalize( Plane( W[ 0 ] - Y[ 0 ], W[ 1 ] - Y[ 1 ], W[ 2 ] - Y[ 2 ], W[ 3 ] - Y[ 3 ] ) );
+		Bottom = Geometry::Normalize( Plane( W[ 0 ] + Y[ 0 ], W[ 1 ] + Y[ 1 ], W[ 2 ] + Y[ 2 ], W[ 3 ] + Y[ 3 ] ) );
+		Front  = Geometry::Normalize( Plane( W[ 0 ] + Z[ 0 ], W[ 1 ] + Z[ 1 ], W[ 2 ] + Z[ 2 ], W[ 3 ] + Z[ 3 ] ) );
+		Back   = Geometry::Normalize( Plane( W[ 0 ] - Z[ 0 ], W[ 1 ] - Z[ 1 ], W[ 2 ] - Z[ 2 ], W[ 3 ] - Z[ 3 ] ) );
+	}
+
+	bool Intersects( const Vector3& a_Point ) const
+	{
+		for ( const Plane& FrustumPlane : Planes )
+		{
+			if ( Geometry::DistanceFromPlane( FrustumPlane, a_Point ) < 0.0f )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Intersects( const Sphere& a_Sphere ) const
 	{
-		const Transform* CameraTransform = a_Camera.GetOwner().GetTransform();
-		Vector2 FarSize;
-		FarSize.y = a_Camera.GetFarZ() * Math::Tan( a_Camera.GetFOV() * 0.5f );
-		FarSize.x = FarSize.y * a_Camera.GetAspect();
-		Vector3 CameraPosition = CameraTransform->GetGlobalPosition();
-		Vector3 CameraForward = CameraTransform->GetGlobalForward();
-		Vector3 CameraRight = CameraTransform->GetGlobalRight();
-		Vector3 CameraUp = CameraTransform->GetGlobalUp();
-		Vector3 NearP = a_Camera.GetNearZ() * CameraForward;
-		Vector3 FarP = a_Camera.GetFarZ() * CameraForward;
-
-		// Front
-		Front.normal = CameraForward;
-		Front.distance = Math::Dot( CameraPosition + NearP, Front.normal );
-
-		// Back
-		Back.normal = -CameraForward;
-		Back.distance = Math::Dot( CameraPosition + FarP, Back.normal );
-
-		// Right
-		Right.normal = Math::Cross( CameraUp, FarP + CameraRight * FarSize.x );
-		Right.distance = Math::Dot( CameraPosition, Right.normal );
-
-		// Left
-		Left.normal = Math::Cross( CameraUp, FarP - CameraRight * FarSize.x );
-		Left.distance = Math::Dot( CameraPosition, Left.normal );
-
-		// Top
-		Top.normal = Math::Cross( CameraRight, FarP - CameraUp * FarSize.y );
-		Top.distance = Math::Dot( CameraPosition, Top.normal );
-
-		// Bottom
-		Bottom.normal = Math::Cross( FarP + CameraUp * FarSize.y, CameraRight );
-		Bottom.distance = Math::Dot( CameraPosition, Bottom.normal );
+		for ( const Plane& FrustumPlane : Planes )
+		{
+			if ( Geometry::DistanceFromPlane( FrustumPlane, a_Sphere.Centre ) < -a_Sphere.Radius )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Intersects( const AABB& a_Bounds ) const
+	{
+		uint8_t Mask = AllPlanes;
+		return Classify( a_Bounds, Mask ) != Containment::OUTSIDE;
+	}
+
+	// Only the planes set in io_Mask are tested. Planes the box lies fully inside of are cleared from
+	// the mask, so children of a box can skip them.
+	Containment Classify( const AABB& a_Bounds, uint8_t& io_Mask ) const
+	{
+		Vector3 Centre = a_Bounds.GetCentre();
+		Vector3 Extents = a_Bounds.GetExtents();
+
+		for ( uint32_t i = 0; i < 6; ++i )
+		{
+			if ( !( io_Mask & ( 1u << i ) ) )
+			{
+				continue;
+			}
+
+			const Plane& FrustumPlane = Planes[ i ];
+			float Distance = Geometry::DistanceFromPlane( FrustumPlane, Centre );
+			float Radius =
+				Math::Abs( FrustumPlane.a ) * Extents.x +
+				Math::Abs( FrustumPlane.b ) * Extents.y +
+				Math::Abs( FrustumPlane.c ) * Extents.z;
+
+			if ( Distance < -Radius )
+			{
+				return Containment::OUTSIDE;
+			}
+
+			if ( Distance >= Radius )
+			{
+				io_Mask &= ~( 1u << i );
+			}
+		}
+
+		return io_Mask ? Containment::INTERSECTING : Containment::INSIDE;
 	}
 
 	union
@@ -56,4 +117,4 @@ struct Frustum
 			Plane Back;
 		};
 	};
-};
\ No newline at end of file
+};
@@ -66,6 +66,26 @@ public:
 		return GameObject::FindByID( Alias::FindByName( a_Name ) );
 	}
 
+	inline static AliasView FindAllByName( Hash a_Name )
+	{
+		return Alias::FindAllByName( a_Name );
+	}
+
+	inline static AliasView FindByTag( Hash a_Tag )
+	{
+		return Alias::FindByTag( a_Tag );
+	}
+
+	inline static AliasView FindByLayer( uint8_t a_Layer )
+	{
+		return Alias::FindByLayer( a_Layer );
+	}
+
+	inline bool HasTag( Hash a_Tag ) const
+	{
+		return Alias::HasTag( m_ID, a_Tag );
+	}
+
 	inline static void Destroy( GameObject a_GameObject )
 	{
 		Component::Destroy< Transform >( a_GameObject );
@@ -400,12 +400,17 @@ public:
 		, FrontFaceCull( false )
 		, BackFaceCull( false )
 		, AlphaBlending( false )
+		, Instancing( false )
 	{ }
 
 	bool FrontFaceCull : 1;
 	bool BackFaceCull  : 1;
 	bool AlphaBlending : 1;
 
+	// Draws sharing this material and a mesh are batched into one instanced draw. Set along with the
+	// shader, from Shader::IsInstanced.
+	bool Instancing    : 1;
+
 	template < typename T >
 	void AddProperty( const Name& a_Key, const T& a_Value )
 	{
@@ -413,6 +418,7 @@ public:
 		auto& NewProperty = m_Properties.back();
 		NewProperty.SetName( a_Key );
 		NewProperty.Set( a_Value );
+		MarkModified();
 
 		if ( !m_Shader || !m_Shader->IsCompiled() )
 		{
@@ -460,6 +466,7 @@ public:
 		}
 		
 		Iter->Set( o_Value );
+		MarkModified();
 		return true;
 	}
 
@@ -487,6 +494,7 @@ public:
 			m_Enabled.erase( ToRemove );
 		}
 
+		MarkModified();
 		return true;
 	}
 
@@ -513,6 +521,7 @@ public:
 		auto& NewProperty = m_Textures[ a_Key ];
 		NewProperty.m_Name = a_Key;
 		NewProperty.m_Resource = a_Texture;
+		MarkModified();
 
 		/*if ( !m_Shader->GetProgramHandle() )
 		{
@@ -535,6 +544,7 @@ public:
 		if ( Iter != m_Textures.end() )
 		{
 			Iter->second.m_Resource = a_Texture;
+			MarkModified();
 			return true;
 		}
 
@@ -548,6 +558,7 @@ public:
 		if ( Iter != m_Textures.end() )
 		{
 			m_Textures.erase( Iter );
+			MarkModified();
 			return true;
 		}
 
@@ -577,6 +588,8 @@ public:
 	void SetShader( const Shader* a_Shader )
 	{
 		m_Shader = a_Shader;
+		Instancing = a_Shader && a_Shader->IsInstanced();
+		MarkModified();
 
 		if ( !m_Shader || !m_Shader->IsCompiled() )
 		{
@@ -4,6 +4,7 @@
 #include "Colour.hpp"
 #include "Vertex.hpp"
 #include "Resource.hpp"
+#include "Bounds.hpp"
 
 class Mesh : public Resource
 {
@@ -11,6 +12,7 @@ public:
 
 	Mesh()
 		: m_Outermost( size_t( -1 ) )
+		, m_HasBounds( false )
 		, m_ActiveColourChannel( 0 )
 		, m_ActiveTexelChannel( 0 )
 	{ }
@@ -65,6 +67,25 @@ public:
 		return Math::Length( m_Positions[ GetOutermost() ] );
 	}
 
+	inline const AABB& GetBounds() const
+	{
+		if ( !m_HasBounds && !m_Positions.empty() )
+		{
+			AABB Bounds( m_Positions[ 0 ], m_Positions[ 0 ] );
+
+			for ( const Vector3& Position : m_Positions )
+			{
+				Bounds.Min = Math::Min( Bounds.Min, Position );
+				Bounds.Max = Math::Max( Bounds.Max, Position );
+			}
+
+			const_cast< Mesh* >( this )->m_Bounds = Bounds;
+			const_cast< Mesh* >( this )->m_HasBounds = true;
+		}
+
+		return m_Bounds;
+	}
+
 	inline const uint32_t* GetIndices() const
 	{
 		return m_Indices.data();
@@ -182,6 +203,8 @@ public:
 	std::array< std::vector< Vector2 >, 8 > m_Texels;
 	std::array< std::vector< Vector4 >, 8 > m_Colours;
 	uint32_t                                m_Outermost;
+	AABB                                    m_Bounds;
+	bool                                    m_HasBounds;
 	uint32_t                                m_ActiveColourChannel;
 	uint32_t                                m_ActiveTexelChannel;
 };
\ No newline at end of file
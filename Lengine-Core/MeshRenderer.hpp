@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <vector>
+
 #include "Renderer.hpp"
 #include "Mesh.hpp"
 #include "Material.hpp"
@@ -11,7 +14,31 @@
 #include "Light.hpp"
 #include "File.hpp"
 #include "Rect.hpp"
-#include "Frustum.hpp"
+
+// A coarser mesh, drawn once the renderer covers less than ScreenSize of the screen height.
+struct MeshLOD
+{
+	ResourceHandle< Mesh > Handle;
+	float                  ScreenSize;
+
+	template < typename _Serializer >
+	void Serialize( _Serializer& a_Serializer ) const
+	{
+		a_Serializer << Handle << ScreenSize;
+	}
+
+	template < typename _Deserializer >
+	void Deserialize( _Deserializer& a_Deserializer )
+	{
+		a_Deserializer >> Handle >> ScreenSize;
+	}
+
+	template < typename _Sizer >
+	void SizeOf( _Sizer& a_Sizer ) const
+	{
+		a_Sizer& Handle& ScreenSize;
+	}
+};
 
 DefineComponent( MeshRenderer, Renderer )
 {
@@ -19,60 +46,99 @@ public:
 
 	void OnRender( RenderQueue & a_Queue ) const override
 	{
-		if ( !Camera::GetMainCamera() )
+		Submit( a_Queue, this->GetOwner().GetTransform()->GetGlobalMatrix() );
+	}
+
+	// Draws as OnRender does, with the owner's global matrix passed in rather than looked up. Used when
+	// walking the pipeline's renderer group, which holds the Transform alongside.
+	void Submit( RenderQueue& a_Queue, const Matrix4& a_Model ) const
+	{
+		const Mesh* Current = GetLODMesh( m_LOD );
+
+		if ( !Current || !m_Material.Assure() )
 		{
 			return;
 		}
 
-		if ( !m_Mesh.Assure() || !m_Material.Assure() )
+		if ( m_Fade >= 1.0f || m_PreviousLOD == m_LOD )
 		{
+			a_Queue.Submit( Current, m_Material.Get(), m_Material->GetShader(), a_Model, this->GetRenderLayer(), m_Material->AlphaBlending );
 			return;
 		}
 
-		Frustum ViewFrustum = *Camera::GetMainCamera();
-		float Radius = m_Mesh->GetRadius();
-		bool Collided = false;
+		a_Queue.Submit( Current, m_Material.Get(), m_Material->GetShader(), a_Model, this->GetRenderLayer(), m_Material->AlphaBlending, m_Fade );
+
+		if ( const Mesh* Previous = GetLODMesh( m_PreviousLOD ) )
+		{
+			a_Queue.Submit( Previous, m_Material.Get(), m_Material->GetShader(), a_Model, this->GetRenderLayer(), m_Material->AlphaBlending, m_Fade - 1.0f );
+		}
+	}
+
+	void SelectLOD( float a_ScreenSize, float a_DeltaTime ) override
+	{
+		// Thresholds are widened by the hysteresis in the direction of travel, so renderers sitting
+		// on a threshold don't flicker between levels.
+		uint32_t Level = m_LOD;
 
-		// Perform broadphase frustum culling.
+		while ( Level < m_LODs.size() && a_ScreenSize < m_LODs[ Level ].ScreenSize * ( 1.0f - m_LODHysteresis ) )
+		{
+			++Level;
+		}
 
-		// THIS IS NOT WORKING, IT NEVER REJECTS.
-		for ( const auto& FrustumPlane : ViewFrustum.Planes )
+		while ( Level > 0 && a_ScreenSize > m_LODs[ Level - 1 ].ScreenSize * ( 1.0f + m_LODHysteresis ) )
 		{
-			float dist = Geometry::DistanceFromPlane( FrustumPlane, this->GetOwner().GetTransform()->GetGlobalPosition() );
+			--Level;
+		}
 
-			if ( dist > -Radius )
-			{
-				Collided = true;
-				break;
-			}
+		if ( Level != m_LOD )
+		{
+			m_PreviousLOD = m_LOD;
+			m_LOD = Level;
+			m_Fade = m_LODCrossFade > 0.0f ? 0.0f : 1.0f;
 		}
+		else if ( m_Fade < 1.0f )
+		{
+			m_Fade = Math::Min( m_Fade + a_DeltaTime / m_LODCrossFade, 1.0f );
+		}
+	}
 
-		// THIS NEVER GETS HIT FOR SOME REASON, INVESTIGATE FURTHER.
-		if ( !Collided )
+	bool GetBounds( AABB& o_Bounds ) const override
+	{
+		if ( !m_Mesh.Assure() || !m_Mesh->HasPositions() )
 		{
-			return;
+			return false;
 		}
 
-		RenderInstruction Instruction;
-		Instruction.Modification = RenderInstruction::Modification::SET;
-		Instruction.Object = RenderInstruction::Object::Mesh;
-		Instruction.ResourceSource = m_Mesh.Get();
-		a_Queue += Instruction;
+		o_Bounds = m_Mesh->GetBounds().Transformed( this->GetOwner().GetTransform()->GetGlobalMatrix() );
+		return true;
+	}
 
-		Instruction.Modification = RenderInstruction::Modification::SET;
-		Instruction.Object = RenderInstruction::Object::Material;
-		Instruction.ResourceSource = m_Material.Get();
-		a_Queue += Instruction;
+	const Mesh* GetOccluder() const override
+	{
+		if ( !m_Occluder )
+		{
+			return nullptr;
+		}
 
-		Instruction.Modification = RenderInstruction::Modification::SET;
-		Instruction.Object = RenderInstruction::Object::Model;
-		Instruction.ResourceSource = &this->GetOwner().GetTransform()->GetGlobalMatrix();
-		a_Queue += Instruction;
+		const Mesh* Proxy = m_OccluderMesh.Assure();
+		return Proxy ? Proxy : m_Mesh.Assure();
+	}
 
-		Instruction.Modification = RenderInstruction::Modification::DRAW;
-		Instruction.Object = RenderInstruction::Object::None;
-		Instruction.ResourceSource = nullptr;
-		a_Queue += Instruction;
+	// Static casters always cast with the mesh itself, so their cached shadow doesn't change with the
+	// level of detail.
+	const Mesh* GetShadowCaster() const override
+	{
+		if ( !m_CastShadows )
+		{
+			return nullptr;
+		}
+
+		return m_StaticShadows ? m_Mesh.Assure() : GetLODMesh( m_LOD );
+	}
+
+	bool IsStaticShadowCaster() const override
+	{
+		return m_CastShadows && m_StaticShadows;
 	}
 
 	const Mesh* GetMesh() const
@@ -88,6 +154,7 @@ public:
 	void SetMesh( ResourceHandle< Mesh > a_Mesh )
 	{
 		m_Mesh = a_Mesh;
+		this->InvalidateBounds();
 	}
 
 	void SetMaterial( ResourceHandle< Material > a_Material )
@@ -95,29 +162,138 @@ public:
 		m_Material = a_Material;
 	}
 
+	// Adds a level that is drawn instead of the mesh once the renderer covers less than a_ScreenSize
+	// of the screen height. Levels are kept ordered from the largest screen size down.
+	void AddLOD( ResourceHandle< Mesh > a_Mesh, float a_ScreenSize )
+	{
+		auto Where = std::find_if( m_LODs.begin(), m_LODs.end(), [ a_ScreenSize ]( const MeshLOD& a_LOD ){ return a_LOD.ScreenSize < a_ScreenSize; } );
+		m_LODs.insert( Where, { a_Mesh, a_ScreenSize } );
+		ResetLOD();
+	}
+
+	void ClearLODs()
+	{
+		m_LODs.clear();
+		ResetLOD();
+	}
+
+	// Number of levels, including the mesh itself.
+	inline uint32_t GetLODCount() const
+	{
+		return static_cast< uint32_t >( m_LODs.size() ) + 1;
+	}
+
+	inline uint32_t GetLOD() const
+	{
+		return m_LOD;
+	}
+
+	inline float GetLODHysteresis() const
+	{
+		return m_LODHysteresis;
+	}
+
+	// Fraction a threshold has to be passed by before the level changes.
+	inline void SetLODHysteresis( float a_Hysteresis )
+	{
+		m_LODHysteresis = a_Hysteresis;
+	}
+
+	inline float GetLODCrossFade() const
+	{
+		return m_LODCrossFade;
+	}
+
+	// Seconds taken to fade between levels, 0 switches instantly. While fading both levels are drawn,
+	// the incoming one with a u_LODFade rising from 0 to 1 and the outgoing one with a u_LODFade rising
+	// from -1 to 0, so shaders can dither them with complementary patterns.
+	inline void SetLODCrossFade( float a_Seconds )
+	{
+		m_LODCrossFade = a_Seconds;
+	}
+
+	inline bool IsOccluder() const
+	{
+		return m_Occluder;
+	}
+
+	// Occluders hide renderers behind them. A simplified proxy mesh can stand in for the drawn mesh,
+	// it should lie inside of it.
+	void SetOccluder( bool a_Occluder, ResourceHandle< Mesh > a_Proxy = ResourceHandle< Mesh >() )
+	{
+		m_Occluder = a_Occluder;
+		m_OccluderMesh = a_Proxy;
+		this->InvalidateBounds();
+	}
+
+	inline bool GetCastShadows() const
+	{
+		return m_CastShadows;
+	}
+
+	inline bool GetStaticShadows() const
+	{
+		return m_StaticShadows;
+	}
+
+	// Static shadows are drawn once and cached until a static caster moves, changes or is destroyed.
+	// Only mark renderers that rarely move.
+	void SetCastShadows( bool a_CastShadows, bool a_Static = false )
+	{
+		m_CastShadows = a_CastShadows;
+		m_StaticShadows = a_Static;
+		this->InvalidateBounds();
+	}
+
 private:
 
+	// Falls back to the mesh if a level fails to load.
+	const Mesh* GetLODMesh( uint32_t a_Level ) const
+	{
+		const Mesh* Found = a_Level > 0 && a_Level <= m_LODs.size() ? m_LODs[ a_Level - 1 ].Handle.Assure() : nullptr;
+		return Found ? Found : m_Mesh.Assure();
+	}
+
+	void ResetLOD()
+	{
+		m_LOD = 0;
+		m_PreviousLOD = 0;
+		m_Fade = 1.0f;
+	}
+
 	friend class ResourcePackager;
 	friend class Serialization;
 
 	template < typename _Serializer >
 	void Serialize( _Serializer & a_Serializer ) const
 	{
-		a_Serializer << m_Mesh << m_Material;
+		a_Serializer << m_Mesh << m_Material << m_LODs << m_LODHysteresis << m_LODCrossFade;
 	}
 
 	template < typename _Deserializer >
 	void Deserialize( _Deserializer & a_Deserializer )
 	{
-		a_Deserializer >> m_Mesh >> m_Material;
+		a_Deserializer >> m_Mesh >> m_Material >> m_LODs >> m_LODHysteresis >> m_LODCrossFade;
 	}
 
 	template < typename _Sizer >
 	void SizeOf( _Sizer & a_Sizer ) const
 	{
-		a_Sizer& m_Mesh& m_Material;
+		a_Sizer& m_Mesh& m_Material& m_LODs& m_LODHysteresis& m_LODCrossFade;
 	}
 
 	ResourceHandle< Mesh     > m_Mesh;
 	ResourceHandle< Material > m_Material;
+	ResourceHandle< Mesh     > m_OccluderMesh;
+	bool                       m_Occluder = false;
+	bool                       m_CastShadows = true;
+	bool                       m_StaticShadows = false;
+
+	// Level 0 is m_Mesh, level i is m_LODs[ i - 1 ].
+	std::vector< MeshLOD >     m_LODs;
+	float                      m_LODHysteresis = 0.1f;
+	float                      m_LODCrossFade = 0.0f;
+	uint32_t                   m_LOD = 0;
+	uint32_t                   m_PreviousLOD = 0;
+	float                      m_Fade = 1.0f;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <emmintrin.h>
+
+#include "OcclusionBuffer.hpp"
+
+OcclusionBuffer::OcclusionBuffer()
+	: m_Depth( nullptr )
+{
+	DepthRasterizer::LoadRows( Matrix4::Identity, m_Rows );
+}
+
+void OcclusionBuffer::Begin( const Matrix4& a_ProjectionView )
+{
+	m_Storage.resize( Width * Height );
+	Begin( a_ProjectionView, m_Storage.data() );
+}
+
+void OcclusionBuffer::Begin( const Matrix4& a_ProjectionView, float* a_Depth )
+{
+	m_Depth = a_Depth;
+	m_Rasterizer.Begin( a_ProjectionView, a_Depth, Width, Height );
+	DepthRasterizer::LoadRows( a_ProjectionView, m_Rows );
+}
+
+uint32_t OcclusionBuffer::RasterizeOccluder( const Mesh& a_Mesh, const Matrix4& a_Model )
+{
+	return m_Rasterizer.Rasterize( a_Mesh, a_Model );
+}
+
+bool OcclusionBuffer::IsVisible( const AABB& a_Bounds ) const
+{
+	float MinX = static_cast< float >( Width ), MinY = static_cast< float >( Height ), MinZ = 1.0f;
+	float MaxX = 0.0f, MaxY = 0.0f;
+
+	for ( uint32_t i = 0; i < 8; ++i )
+	{
+		Vector3 Corner(
+			i & 1 ? a_Bounds.Max.x : a_Bounds.Min.x,
+			i & 2 ? a_Bounds.Max.y : a_Bounds.Min.y,
+			i & 4 ? a_Bounds.Max.z : a_Bounds.Min.z );
+
+		float W = DepthRasterizer::TransformRow( m_Rows, 3, Corner );
+
+		if ( W < DepthRasterizer::NearW )
+		{
+			return true;
+		}
+
+		float InverseW = 1.0f / W;
+		float X = ( DepthRasterizer::TransformRow( m_Rows, 0, Corner ) * InverseW * 0.5f + 0.5f ) * Width;
+		float Y = ( DepthRasterizer::TransformRow( m_Rows, 1, Corner ) * InverseW * 0.5f + 0.5f ) * Height;
+		MinX = Math::Min( MinX, X );
+		MinY = Math::Min( MinY, Y );
+		MaxX = Math::Max( MaxX, X );
+		MaxY = Math::Max( MaxY, Y );
+		MinZ = Math::Min( MinZ, DepthRasterizer::TransformRow( m_Rows, 2, Corner ) * InverseW );
+	}
+
+	int32_t StartX = static_cast< int32_t >( Math::Clamp( MinX, 0.0f, static_cast< float >( Width ) ) ) & ~3;
+	int32_t StartY = static_cast< int32_t >( Math::Clamp( MinY, 0.0f, static_cast< float >( Height ) ) );
+	int32_t EndX = static_cast< int32_t >( Math::Clamp( MaxX, -1.0f, Width - 1.0f ) );
+	int32_t EndY = static_cast< int32_t >( Math::Clamp( MaxY, -1.0f, Height - 1.0f ) );
+
+	// Visible if any covered pixel lies behind the nearest point of the box. Whole blocks are
+	// tested, which only widens the rectangle.
+	__m128 Nearest = _mm_set1_ps( MinZ );
+
+	for ( int32_t y = StartY; y <= EndY; ++y )
+	{
+		const float* Source = m_Depth + y * Width;
+
+		for ( int32_t x = StartX; x <= EndX; x += 4 )
+		{
+			if ( _mm_movemask_ps( _mm_cmpge_ps( _mm_loadu_ps( Source + x ), Nearest ) ) )
+			{
+				return true;
+			}
+		}
+	}
+
+	return StartX > EndX || StartY > EndY;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.hpp"
+#include "Bounds.hpp"
+#include "DepthRasterizer.hpp"
+
+struct OcclusionStats
+{
+	uint32_t Occluders         = 0;
+	uint32_t OccluderTriangles = 0;
+	uint32_t Tested            = 0;
+	uint32_t Culled            = 0;
+	float    RasterizeTime     = 0.0f;
+	float    TestTime          = 0.0f;
+};
+
+// Small CPU depth buffer that occluders are rasterized into. Bounds are then tested against it by
+// their screen rectangle and nearest depth. Triangles and boxes crossing the near plane are skipped
+// and treated as visible respectively, so tests only ever err towards drawing.
+class OcclusionBuffer
+{
+public:
+
+	static constexpr uint32_t Width  = 256;
+	static constexpr uint32_t Height = 128;
+
+	OcclusionBuffer();
+
+	void Begin( const Matrix4& a_ProjectionView );
+
+	// Rasterizes into a_Depth rather than memory of the buffer's own. It must hold Width * Height
+	// floats and stay valid for as long as the buffer is used.
+	void Begin( const Matrix4& a_ProjectionView, float* a_Depth );
+
+	// Returns the number of triangles rasterized.
+	uint32_t RasterizeOccluder( const Mesh& a_Mesh, const Matrix4& a_Model );
+
+	bool IsVisible( const AABB& a_Bounds ) const;
+
+	inline const float* GetDepth() const
+	{
+		return m_Depth;
+	}
+
+private:
+
+	DepthRasterizer      m_Rasterizer;
+	float*               m_Depth;
+	std::vector< float > m_Storage;
+	float                m_Rows[ 4 ][ 4 ];
+};
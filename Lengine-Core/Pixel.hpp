@@ -49,6 +49,16 @@ struct Pixel : protected CHAR_INFO
 		CHAR_INFO::Attributes |= static_cast< WORD >( a_ConsoleColour ) << 4;
 	}
 
+	inline bool operator==( const Pixel& a_Pixel ) const
+	{
+		return Char.UnicodeChar == a_Pixel.Char.UnicodeChar && CHAR_INFO::Attributes == a_Pixel.CHAR_INFO::Attributes;
+	}
+
+	inline bool operator!=( const Pixel& a_Pixel ) const
+	{
+		return !( *this == a_Pixel );
+	}
+
 	inline operator CHAR_INFO& ( )
 	{
 		return *reinterpret_cast< CHAR_INFO* >( this );
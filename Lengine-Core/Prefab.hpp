@@ -1,4 +1,7 @@
 #pragma once
+#include <memory>
+#include <vector>
+
 #include "Resource.hpp"
 #include "GameObject.hpp"
 
@@ -14,37 +17,33 @@ public:
 
 	static GameObject Instantiate( const Prefab& a_Prefab )
 	{
-		// Create GameObject
-		GameObject NewGameObject = GameObject::Instantiate( a_Prefab.GetName() );
+		return GameObject::FindByID( static_cast< GameObjectID >( *Spawn( a_Prefab, 1 ) ) );
+	}
 
-		// Add Components to GameObject
-		for ( auto Begin = a_Prefab.m_Components.begin(), End = a_Prefab.m_Components.end(); Begin != End; ++Begin )
-		{
-			// Add component with the given type hash.
-			void* NewComponent;
-			ComponentBase::GetTypeMap().InvokeFunction( Begin->first, "AddComponent"_H, NewComponent, NewGameObject.GetID() );
-			
-			// Deserialize prefab data into component.
-			bool Successful;
-			BufferStream Stream;
-			Stream.Open( const_cast< uint8_t* >( Begin->second.data() ), Begin->second.size() );
-			BufferDeserializer Deserializer( Stream );
-			ComponentBase::GetTypeMap().InvokeFunction( Begin->first, "BufferDeserializeComponent"_H, Successful, Deserializer, NewComponent );
-		}
+	// Instantiates a_Count copies at once and appends their roots to o_Roots.
+	static void InstantiateMany( const Prefab& a_Prefab, uint32_t a_Count, std::vector< GameObject >& o_Roots )
+	{
+		const entt::entity* Roots = Spawn( a_Prefab, a_Count );
 
-		// Create sub prefabs and attach as children recursively.
-		for ( auto Begin = a_Prefab.m_Children.begin(), End = a_Prefab.m_Children.end(); Begin != End; ++Begin )
+		for ( uint32_t i = 0; i < a_Count; ++i )
 		{
-			GameObject NewChild = Prefab::Instantiate( *Begin );
-			NewGameObject.GetTransform()->AttachChild( NewChild, false );
+			o_Roots.push_back( GameObject::FindByID( static_cast< GameObjectID >( Roots[ i ] ) ) );
 		}
+	}
 
-		NewGameObject.GetTransform()->UpdateTransform();
-		return NewGameObject;
+	// Deserializes the components once into prototypes that instances are copied from. Happens on the
+	// first instantiation otherwise. Changing the prefab through its own functions bakes it again, changing
+	// a child through GetChild needs Bake to be called on the root.
+	void Bake() const
+	{
+		auto Baked = std::make_shared< BakedPrefab >();
+		BakeNode( *Baked, BakedNode::Root );
+		m_Baked = Baked;
 	}
 
 	inline Prefab* AddChild()
 	{
+		m_Baked.reset();
 		return &m_Children.emplace_back();
 	}
 
@@ -56,6 +55,7 @@ public:
 		}
 
 		m_Children.erase( m_Children.begin() + a_Index );
+		m_Baked.reset();
 		return true;
 	}
 
@@ -91,6 +91,7 @@ public:
 			return false;
 		}
 
+		m_Baked.reset();
 		auto& Binary = m_Components[ ComponentHash ];
 		Binary.resize( Serialization::GetSizeOf( a_Component ) );
 		bool Successful;
@@ -113,6 +114,7 @@ public:
 			return false;
 		}
 
+		m_Baked.reset();
 		auto& Binary = m_Components[ ComponentHash ];
 		_Component NewComponent;
 		Binary.resize( Serialization::GetSizeOf( NewComponent ) );
@@ -137,6 +139,7 @@ public:
 		}
 
 		m_Components.erase( Iter );
+		m_Baked.reset();
 		return true;
 	}
 
@@ -165,6 +168,7 @@ public:
 		}
 
 		a_Patch( ThisComponent );
+		m_Baked.reset();
 		Iter->second.resize( Serialization::GetSizeOf( ThisComponent ) );
 		Stream.Open();
 		BufferSerializer Serializer( Stream );
@@ -181,6 +185,111 @@ private:
 	typedef std::vector< uint8_t > ComponentBinary;
 	typedef std::map< size_t, ComponentBinary > ComponentBinaryMap;
 
+	struct BakedNode
+	{
+		static constexpr uint32_t Root = uint32_t( -1 );
+
+		uint32_t                                    Parent;
+		entt::entity                                Prototype;
+		std::vector< ComponentBase::CloneFunction > Components;
+	};
+
+	// A prefab and its children flattened, parents ahead of their children.
+	struct BakedPrefab
+	{
+		~BakedPrefab()
+		{
+			for ( const BakedNode& Node : Nodes )
+			{
+				ComponentBase::GetPrototypeRegistry().destroy( Node.Prototype );
+			}
+		}
+
+		std::vector< BakedNode > Nodes;
+	};
+
+	void BakeNode( BakedPrefab& o_Baked, uint32_t a_Parent ) const
+	{
+		entt::registry& Prototypes = ComponentBase::GetPrototypeRegistry();
+		uint32_t Index = static_cast< uint32_t >( o_Baked.Nodes.size() );
+		BakedNode& Node = o_Baked.Nodes.emplace_back();
+		Node.Parent = a_Parent;
+		Node.Prototype = Prototypes.create();
+
+		// Same as GameObject::Instantiate, the prefab's own Alias and Transform are read over these.
+		Prototypes.emplace< Alias >( Node.Prototype ).SetName( GetName() );
+		Prototypes.emplace< Transform >( Node.Prototype );
+		Node.Components.push_back( ComponentBase::CloneComponent< Alias > );
+		Node.Components.push_back( ComponentBase::CloneComponent< Transform > );
+
+		for ( auto Begin = m_Components.begin(), End = m_Components.end(); Begin != End; ++Begin )
+		{
+			ComponentBase::CloneFunction Clone = nullptr;
+			BufferStream Stream;
+			Stream.Open( const_cast< uint8_t* >( Begin->second.data() ), Begin->second.size() );
+			BufferDeserializer Deserializer( Stream );
+			ComponentBase::GetTypeMap().InvokeFunction( Begin->first, "BufferBakeComponent"_H, Clone, Deserializer, entt::entity( Node.Prototype ) );
+
+			if ( Clone && std::find( Node.Components.begin(), Node.Components.end(), Clone ) == Node.Components.end() )
+			{
+				Node.Components.push_back( Clone );
+			}
+		}
+
+		// Node may move as children are added, it is done with by now.
+		for ( const Prefab& Child : m_Children )
+		{
+			Child.BakeNode( o_Baked, Index );
+		}
+	}
+
+	// Creates a_Count copies of every node, the copies of a node next to each other so each component is
+	// copied across them in one go. Returns the roots, valid until the next call.
+	static const entt::entity* Spawn( const Prefab& a_Prefab, uint32_t a_Count )
+	{
+		static std::vector< entt::entity > Entities;
+
+		if ( !a_Prefab.m_Baked )
+		{
+			a_Prefab.Bake();
+		}
+
+		const std::vector< BakedNode >& Nodes = a_Prefab.m_Baked->Nodes;
+		entt::registry& Registry = ComponentBase::GetRegistry();
+		Entities.resize( Nodes.size() * a_Count );
+		Registry.create( Entities.begin(), Entities.end() );
+
+		for ( size_t i = 0; i < Nodes.size(); ++i )
+		{
+			const entt::entity* Begin = Entities.data() + i * a_Count;
+
+			for ( ComponentBase::CloneFunction Clone : Nodes[ i ].Components )
+			{
+				Clone( Nodes[ i ].Prototype, Begin, Begin + a_Count );
+			}
+		}
+
+		// Parents were copied ahead of their children, so children attach in the prefab's order.
+		for ( size_t i = 1; i < Nodes.size(); ++i )
+		{
+			const entt::entity* Children = Entities.data() + i * a_Count;
+			const entt::entity* Parents = Entities.data() + Nodes[ i ].Parent * a_Count;
+
+			for ( uint32_t j = 0; j < a_Count; ++j )
+			{
+				Transform* Parent = Registry.try_get< Transform >( Parents[ j ] );
+				Registry.get< Transform >( Children[ j ] ).SetParentImpl( Parent, false );
+			}
+		}
+
+		for ( uint32_t i = 0; i < a_Count; ++i )
+		{
+			Registry.get< Transform >( Entities[ i ] ).UpdateTransform();
+		}
+
+		return Entities.data();
+	}
+
 	template < typename _Serializer >
 	void Serialize( _Serializer& a_Serializer ) const
 	{
@@ -191,6 +300,7 @@ private:
 	void Deserialize( _Deserializer& a_Deserializer )
 	{
 		a_Deserializer >> reinterpret_cast< Resource& >( *this ) >> m_Components >> m_Children;
+		m_Baked.reset();
 	}
 
 	template < typename _Sizer >
@@ -199,6 +309,7 @@ private:
 		a_Sizer & reinterpret_cast< const Resource& >( *this ) & m_Components & m_Children;
 	}
 
-	ComponentBinaryMap    m_Components;
-	std::vector< Prefab > m_Children;
+	ComponentBinaryMap             m_Components;
+	std::vector< Prefab >          m_Children;
+	mutable std::shared_ptr< BakedPrefab > m_Baked;
 };
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+
+#include "RenderGraph.hpp"
+#include "TimingTable.hpp"
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read( ResourceID a_Resource )
+{
+	m_Graph.m_Passes[ m_Pass ].Accesses.push_back( { a_Resource, false } );
+	m_Graph.m_Dirty = true;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write( ResourceID a_Resource )
+{
+	m_Graph.m_Passes[ m_Pass ].Accesses.push_back( { a_Resource, true } );
+	m_Graph.m_Dirty = true;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SideEffect()
+{
+	m_Graph.m_Passes[ m_Pass ].SideEffect = true;
+	m_Graph.m_Dirty = true;
+	return *this;
+}
+
+RenderGraph::ResourceID RenderGraph::CreateTarget( const std::string& a_Name, const RenderTargetDesc& a_Desc )
+{
+	return AddResource( a_Name, ResourceType::TARGET, a_Desc );
+}
+
+RenderGraph::ResourceID RenderGraph::CreateResource( const std::string& a_Name )
+{
+	return AddResource( a_Name, ResourceType::VIRTUAL, { 0, 0, 0 } );
+}
+
+RenderGraph::ResourceID RenderGraph::Import( const std::string& a_Name )
+{
+	return AddResource( a_Name, ResourceType::IMPORTED, { 0, 0, 0 } );
+}
+
+RenderGraph::ResourceID RenderGraph::FindResource( const std::string& a_Name ) const
+{
+	for ( ResourceID i = 0; i < m_Resources.size(); ++i )
+	{
+		if ( m_Resources[ i ].Name == a_Name )
+		{
+			return i;
+		}
+	}
+
+	return Null;
+}
+
+RenderGraph::ResourceID RenderGraph::AddResource( const std::string& a_Name, ResourceType a_Type, const RenderTargetDesc& a_Desc )
+{
+	m_Resources.push_back( { a_Name, a_Type, a_Desc, nullptr, Null, Null, Null } );
+	m_Dirty = true;
+	return static_cast< ResourceID >( m_Resources.size() - 1 );
+}
+
+void RenderGraph::SetTargetDesc( ResourceID a_Resource, const RenderTargetDesc& a_Desc )
+{
+	RenderTargetDesc& Desc = m_Resources[ a_Resource ].Desc;
+
+	if ( Desc.Width != a_Desc.Width || Desc.Height != a_Desc.Height || Desc.PixelSize != a_Desc.PixelSize )
+	{
+		Desc = a_Desc;
+		m_Dirty = true;
+	}
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass( const std::string& a_Name, const PassFunction& a_Function )
+{
+	m_Passes.push_back( { a_Name, a_Function, {}, true, false, false, 0.0f } );
+	m_Dirty = true;
+	return PassBuilder( *this, static_cast< PassID >( m_Passes.size() - 1 ) );
+}
+
+RenderGraph::PassID RenderGraph::FindPass( const std::string& a_Name ) const
+{
+	for ( PassID i = 0; i < m_Passes.size(); ++i )
+	{
+		if ( m_Passes[ i ].Name == a_Name )
+		{
+			return i;
+		}
+	}
+
+	return Null;
+}
+
+void RenderGraph::SetPassEnabled( PassID a_Pass, bool a_Enabled )
+{
+	if ( m_Passes[ a_Pass ].Enabled != a_Enabled )
+	{
+		m_Passes[ a_Pass ].Enabled = a_Enabled;
+		m_Dirty = true;
+	}
+}
+
+void RenderGraph::Compile()
+{
+	size_t PassCount = m_Passes.size();
+	std::vector< std::vector< PassID > > Writers( m_Resources.size() );
+	std::vector< std::vector< PassID > > Producers( PassCount );
+	std::vector< std::vector< PassID > > Successors( PassCount );
+
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		m_Passes[ p ].Culled = true;
+		m_Passes[ p ].Time = 0.0f;
+
+		if ( !m_Passes[ p ].Enabled )
+		{
+			continue;
+		}
+
+		for ( const Access& Entry : m_Passes[ p ].Accesses )
+		{
+			std::vector< PassID >& ResourceWriters = Writers[ Entry.Resource ];
+
+			if ( Entry.Write && ( ResourceWriters.empty() || ResourceWriters.back() != p ) )
+			{
+				ResourceWriters.push_back( p );
+			}
+		}
+	}
+
+	auto AddEdge = [&]( PassID a_Before, PassID a_After )
+	{
+		if ( a_Before != a_After )
+		{
+			Successors[ a_Before ].push_back( a_After );
+		}
+	};
+
+	// Writers of a resource run in declaration order. Readers run after the writer they see, and
+	// before the writer that follows it.
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		if ( !m_Passes[ p ].Enabled )
+		{
+			continue;
+		}
+
+		for ( const Access& Entry : m_Passes[ p ].Accesses )
+		{
+			const std::vector< PassID >& ResourceWriters = Writers[ Entry.Resource ];
+			auto Before = std::lower_bound( ResourceWriters.begin(), ResourceWriters.end(), p );
+			auto After = std::upper_bound( ResourceWriters.begin(), ResourceWriters.end(), p );
+			bool Writes = Before != After;
+
+			if ( Entry.Write )
+			{
+				if ( Before != ResourceWriters.begin() )
+				{
+					AddEdge( *( Before - 1 ), p );
+				}
+
+				continue;
+			}
+
+			if ( Before != ResourceWriters.begin() )
+			{
+				Producers[ p ].push_back( *( Before - 1 ) );
+				AddEdge( *( Before - 1 ), p );
+
+				if ( After != ResourceWriters.end() )
+				{
+					AddEdge( p, *After );
+				}
+			}
+			else if ( !Writes && !ResourceWriters.empty() )
+			{
+				Producers[ p ].push_back( ResourceWriters.back() );
+				AddEdge( ResourceWriters.back(), p );
+			}
+		}
+	}
+
+	// Keep passes with side effects or that write imported resources, and everything they read from.
+	std::vector< PassID > Pending;
+
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		const PassNode& Pass = m_Passes[ p ];
+		bool Root = Pass.SideEffect;
+
+		for ( const Access& Entry : Pass.Accesses )
+		{
+			Root |= Entry.Write && m_Resources[ Entry.Resource ].Type == ResourceType::IMPORTED;
+		}
+
+		if ( Pass.Enabled && Root )
+		{
+			m_Passes[ p ].Culled = false;
+			Pending.push_back( p );
+		}
+	}
+
+	while ( !Pending.empty() )
+	{
+		PassID p = Pending.back();
+		Pending.pop_back();
+
+		for ( PassID Producer : Producers[ p ] )
+		{
+			if ( m_Passes[ Producer ].Culled )
+			{
+				m_Passes[ Producer ].Culled = false;
+				Pending.push_back( Producer );
+			}
+		}
+	}
+
+	// Order the kept passes, preferring declaration order among those that are ready.
+	std::vector< uint32_t > Incoming( PassCount, 0 );
+	std::priority_queue< PassID, std::vector< PassID >, std::greater< PassID > > Ready;
+
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		if ( !m_Passes[ p ].Culled )
+		{
+			for ( PassID Successor : Successors[ p ] )
+			{
+				Incoming[ Successor ] += !m_Passes[ Successor ].Culled;
+			}
+		}
+	}
+
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		if ( !m_Passes[ p ].Culled && Incoming[ p ] == 0 )
+		{
+			Ready.push( p );
+		}
+	}
+
+	m_Order.clear();
+
+	while ( !Ready.empty() )
+	{
+		PassID p = Ready.top();
+		Ready.pop();
+		m_Order.push_back( p );
+
+		for ( PassID Successor : Successors[ p ] )
+		{
+			if ( !m_Passes[ Successor ].Culled && --Incoming[ Successor ] == 0 )
+			{
+				Ready.push( Successor );
+			}
+		}
+	}
+
+	// Passes left over are part of a cycle. They still run, in declaration order, and the graph is
+	// reported as cyclic.
+	m_Cyclic = false;
+
+	for ( PassID p = 0; p < PassCount; ++p )
+	{
+		if ( !m_Passes[ p ].Culled && Incoming[ p ] > 0 )
+		{
+			m_Order.push_back( p );
+			m_Cyclic = true;
+		}
+	}
+
+	AssignMemory();
+	m_Dirty = false;
+}
+
+void RenderGraph::AssignMemory()
+{
+	std::vector< ResourceID > Targets;
+
+	for ( ResourceNode& Resource : m_Resources )
+	{
+		Resource.Memory = nullptr;
+		Resource.Block = Null;
+		Resource.First = Null;
+		Resource.Last = Null;
+	}
+
+	// Lifetimes run from the first to the last pass in the order that uses a target.
+	for ( uint32_t i = 0; i < m_Order.size(); ++i )
+	{
+		for ( const Access& Entry : m_Passes[ m_Order[ i ] ].Accesses )
+		{
+			ResourceNode& Resource = m_Resources[ Entry.Resource ];
+
+			if ( Resource.Type != ResourceType::TARGET )
+			{
+				continue;
+			}
+
+			if ( Resource.First == Null )
+			{
+				Resource.First = i;
+				Targets.push_back( Entry.Resource );
+			}
+
+			Resource.Last = i;
+		}
+	}
+
+	std::sort( Targets.begin(), Targets.end(), [&]( ResourceID a_A, ResourceID a_B )
+	{
+		const ResourceNode& A = m_Resources[ a_A ];
+		const ResourceNode& B = m_Resources[ a_B ];
+		return A.First != B.First ? A.First < B.First : A.Desc.GetSize() > B.Desc.GetSize();
+	} );
+
+	// Each target takes the smallest free block it fits in. If none fit, the largest free block is
+	// grown, and only if no block is free is a new one added.
+	struct BlockUse
+	{
+		size_t   Size;
+		uint32_t Last;
+	};
+
+	std::vector< BlockUse > Blocks;
+	m_RequestedSize = 0;
+
+	for ( ResourceID Target : Targets )
+	{
+		ResourceNode& Resource = m_Resources[ Target ];
+		size_t Size = Resource.Desc.GetSize();
+		uint32_t Fit = Null;
+		uint32_t Largest = Null;
+
+		for ( uint32_t b = 0; b < Blocks.size(); ++b )
+		{
+			if ( Blocks[ b ].Last >= Resource.First )
+			{
+				continue;
+			}
+
+			if ( Blocks[ b ].Size >= Size && ( Fit == Null || Blocks[ b ].Size < Blocks[ Fit ].Size ) )
+			{
+				Fit = b;
+			}
+
+			if ( Largest == Null || Blocks[ b ].Size > Blocks[ Largest ].Size )
+			{
+				Largest = b;
+			}
+		}
+
+		uint32_t Block = Fit != Null ? Fit : Largest;
+
+		if ( Block == Null )
+		{
+			Block = static_cast< uint32_t >( Blocks.size() );
+			Blocks.push_back( { 0, 0 } );
+		}
+
+		Blocks[ Block ].Size = std::max( Blocks[ Block ].Size, Size );
+		Blocks[ Block ].Last = Resource.Last;
+		Resource.Block = Block;
+		m_RequestedSize += Size;
+	}
+
+	// Blocks only ever grow, so a graph that changes back and forth doesn't reallocate.
+	m_AllocatedSize = 0;
+
+	if ( m_Blocks.size() < Blocks.size() )
+	{
+		m_Blocks.resize( Blocks.size() );
+	}
+
+	for ( uint32_t b = 0; b < Blocks.size(); ++b )
+	{
+		if ( m_Blocks[ b ].size() < Blocks[ b ].Size )
+		{
+			m_Blocks[ b ].resize( Blocks[ b ].Size );
+		}
+
+		m_AllocatedSize += Blocks[ b ].Size;
+	}
+
+	for ( ResourceID Target : Targets )
+	{
+		m_Resources[ Target ].Memory = m_Blocks[ m_Resources[ Target ].Block ].data();
+	}
+}
+
+void RenderGraph::Execute()
+{
+	if ( m_Dirty )
+	{
+		Compile();
+	}
+
+	for ( PassID p : m_Order )
+	{
+		PassNode& Pass = m_Passes[ p ];
+		auto Start = std::chrono::high_resolution_clock::now();
+		Pass.Function( *this );
+		Pass.Time = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+	}
+}
+
+void RenderGraph::Describe( std::ostream& a_Stream ) const
+{
+	TimingTable Passes( a_Stream, m_Cyclic ? "Render graph (cyclic, passes run in declaration order)" : "Render graph" );
+
+	for ( PassID p : m_Order )
+	{
+		Passes.Time( m_Passes[ p ].Name, m_Passes[ p ].Time ) << std::endl;
+	}
+
+	Passes.Total();
+
+	for ( const PassNode& Pass : m_Passes )
+	{
+		if ( Pass.Culled )
+		{
+			a_Stream << "  " << Pass.Name << ( Pass.Enabled ? " (culled)" : " (disabled)" ) << std::endl;
+		}
+	}
+
+	TimingTable Targets( a_Stream, "Targets" );
+
+	for ( const ResourceNode& Resource : m_Resources )
+	{
+		if ( Resource.Type == ResourceType::TARGET && Resource.First != Null )
+		{
+			Targets.Row( Resource.Name, Resource.Desc.GetSize() / 1024.0f, "KB" )
+				<< ", block " << Resource.Block << ", passes " << Resource.First << " to " << Resource.Last << std::endl;
+		}
+	}
+
+	a_Stream << "  Requested " << m_RequestedSize / 1024.0f << " KB, allocated " << m_AllocatedSize / 1024.0f
+		<< " KB, saved " << ( m_RequestedSize - m_AllocatedSize ) / 1024.0f << " KB" << std::endl;
+}
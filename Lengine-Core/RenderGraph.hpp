@@ -0,0 +1,177 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Invoker.hpp"
+
+struct RenderTargetDesc
+{
+	inline size_t GetSize() const
+	{
+		return static_cast< size_t >( Width ) * Height * PixelSize;
+	}
+
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t PixelSize;
+};
+
+// Passes declare the resources they read and write, and the graph works out the rest when it
+// changes. Passes that nothing depends on are culled, the rest are ordered by their dependencies, and
+// targets whose lifetimes don't overlap share memory.
+//
+// Resources come in three kinds. Targets have memory owned by the graph, which is only valid inside
+// the passes that use them. Virtual resources have no memory and only express ordering. Imported
+// resources live outside of the graph, such as the screen, and passes writing them are always kept.
+//
+// A read sees the contents from the last writer declared before the reading pass. If there isn't one
+// it sees the last writer declared after, so passes added later can produce resources that existing
+// passes read.
+class RenderGraph
+{
+public:
+
+	typedef uint32_t ResourceID;
+	typedef uint32_t PassID;
+	typedef Action< const RenderGraph& > PassFunction;
+
+	static constexpr uint32_t Null = uint32_t( -1 );
+
+	class PassBuilder
+	{
+	public:
+
+		PassBuilder& Read( ResourceID a_Resource );
+		PassBuilder& Write( ResourceID a_Resource );
+
+		// Passes with side effects are never culled.
+		PassBuilder& SideEffect();
+
+		inline operator PassID() const
+		{
+			return m_Pass;
+		}
+
+	private:
+
+		friend class RenderGraph;
+
+		PassBuilder( RenderGraph& a_Graph, PassID a_Pass )
+			: m_Graph( a_Graph )
+			, m_Pass( a_Pass )
+		{ }
+
+		RenderGraph& m_Graph;
+		PassID       m_Pass;
+	};
+
+	ResourceID CreateTarget( const std::string& a_Name, const RenderTargetDesc& a_Desc );
+	ResourceID CreateResource( const std::string& a_Name );
+	ResourceID Import( const std::string& a_Name );
+	ResourceID FindResource( const std::string& a_Name ) const;
+
+	void SetTargetDesc( ResourceID a_Resource, const RenderTargetDesc& a_Desc );
+
+	inline const RenderTargetDesc& GetTargetDesc( ResourceID a_Resource ) const
+	{
+		return m_Resources[ a_Resource ].Desc;
+	}
+
+	template < typename T >
+	inline T* GetTarget( ResourceID a_Resource ) const
+	{
+		return reinterpret_cast< T* >( m_Resources[ a_Resource ].Memory );
+	}
+
+	PassBuilder AddPass( const std::string& a_Name, const PassFunction& a_Function );
+	PassID FindPass( const std::string& a_Name ) const;
+
+	// Disabled passes are left out as if they had never been added.
+	void SetPassEnabled( PassID a_Pass, bool a_Enabled );
+
+	inline bool IsPassEnabled( PassID a_Pass ) const
+	{
+		return m_Passes[ a_Pass ].Enabled;
+	}
+
+	// Compiles the graph if it changed, then runs the passes in order and times them.
+	void Execute();
+	void Compile();
+
+	// Writes the pass order with the time each pass took in the last frame, the culled passes, and
+	// how much memory sharing saved.
+	void Describe( std::ostream& a_Stream ) const;
+
+	inline const std::vector< PassID >& GetOrder() const
+	{
+		return m_Order;
+	}
+
+	inline float GetPassTime( PassID a_Pass ) const
+	{
+		return m_Passes[ a_Pass ].Time;
+	}
+
+	// Bytes all targets in use would take up on their own.
+	inline size_t GetRequestedSize() const
+	{
+		return m_RequestedSize;
+	}
+
+	// Bytes actually set aside for them.
+	inline size_t GetAllocatedSize() const
+	{
+		return m_AllocatedSize;
+	}
+
+private:
+
+	enum class ResourceType : uint8_t
+	{
+		VIRTUAL,
+		TARGET,
+		IMPORTED
+	};
+
+	struct ResourceNode
+	{
+		std::string      Name;
+		ResourceType     Type;
+		RenderTargetDesc Desc;
+		uint8_t*         Memory;
+		uint32_t         Block;
+		uint32_t         First;
+		uint32_t         Last;
+	};
+
+	struct Access
+	{
+		ResourceID Resource;
+		bool       Write;
+	};
+
+	struct PassNode
+	{
+		std::string           Name;
+		PassFunction          Function;
+		std::vector< Access > Accesses;
+		bool                  Enabled;
+		bool                  SideEffect;
+		bool                  Culled;
+		float                 Time;
+	};
+
+	ResourceID AddResource( const std::string& a_Name, ResourceType a_Type, const RenderTargetDesc& a_Desc );
+	void AssignMemory();
+
+	std::vector< ResourceNode >           m_Resources;
+	std::vector< PassNode >               m_Passes;
+	std::vector< PassID >                 m_Order;
+	std::vector< std::vector< uint8_t > > m_Blocks;
+	size_t                                m_RequestedSize = 0;
+	size_t                                m_AllocatedSize = 0;
+	bool                                  m_Dirty = true;
+	bool                                  m_Cyclic = false;
+};
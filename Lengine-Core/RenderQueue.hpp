@@ -1,43 +1,205 @@
 #pragma once
-#include "RenderInstruction.hpp"
+#include <cstdint>
+#include <vector>
 
+#include "Math.hpp"
+
+class Mesh;
+class Material;
+class Shader;
+
+struct DrawItem
+{
+	uint64_t        Key;
+	const Mesh*     Mesh;
+	const Material* Material;
+	Matrix4         Model;
+	float           Fade;
+	uint32_t        Order;
+};
+
+// Draws are collected into a contiguous list that is kept between frames, so once the capacity has
+// grown to fit the scene no allocations happen while building the queue. Draws hold a copy of their
+// model matrix, as transforms may move in memory before the queue is drawn. Each draw carries a 64 bit
+// key, and the list is radix sorted on it before submission. Draws with equal keys are ordered by the
+// order they were submitted with, see SetOrder.
+//
+// Key layout, most significant bit first:
+//   Opaque      : layer 4 | 0 | shader 12 | material 12 | mesh 12 | depth 23
+//   Translucent : layer 4 | 1 | inverted depth 23 | shader 12 | material 12 | mesh 12
+// Opaque draws are grouped by state and drawn front to back within a group, translucent draws are
+// drawn back to front.
 class RenderQueue
 {
 public:
 
-	RenderQueue& operator+=( RenderInstruction a_Instruction )
+	static constexpr uint32_t LayerBits = 4;
+	static constexpr uint32_t IDBits    = 12;
+	static constexpr uint32_t DepthBits = 23;
+
+	void Begin( const Vector3& a_ViewPosition, const Vector3& a_ViewForward, float a_FarZ )
 	{
-		if ( a_Instruction.Modification != RenderInstruction::Modification::NONE )
+		m_Items.clear();
+		m_ViewPosition = a_ViewPosition;
+		m_ViewForward = a_ViewForward;
+		m_InverseFarZ = a_FarZ > 0.0f ? 1.0f / a_FarZ : 0.0f;
+	}
+
+	// Draws submitted from now on carry a_Order. Giving every renderer its own keeps the sorted queue
+	// the same however the renderers were spread over threads.
+	inline void SetOrder( uint32_t a_Order )
+	{
+		m_Order = a_Order;
+	}
+
+	// a_Fade is passed on to the shader as u_LODFade, see MeshRenderer::SetLODCrossFade.
+	void Submit( const Mesh* a_Mesh, const Material* a_Material, const Shader* a_Shader, const Matrix4& a_Model, uint8_t a_Layer = 0, bool a_Translucent = false, float a_Fade = 1.0f )
+	{
+		float Depth = Math::Dot( Matrix4::ExtractTranslation( a_Model ) - m_ViewPosition, m_ViewForward ) * m_InverseFarZ;
+		uint64_t QuantizedDepth = static_cast< uint64_t >( Math::Clamp( Depth, 0.0f, 1.0f ) * static_cast< float >( ( 1u << DepthBits ) - 1 ) );
+
+		uint64_t State =
+			FoldID( a_Shader   ) << ( IDBits * 2 ) |
+			FoldID( a_Material ) <<   IDBits       |
+			FoldID( a_Mesh     );
+
+		uint64_t Key = static_cast< uint64_t >( a_Layer & ( ( 1u << LayerBits ) - 1 ) ) << 60;
+
+		if ( a_Translucent )
+		{
+			QuantizedDepth = ( ( 1u << DepthBits ) - 1 ) - QuantizedDepth;
+			Key |= 1ull << 59 | QuantizedDepth << ( IDBits * 3 ) | State;
+		}
+		else
 		{
-			m_RenderInstructions.push_back( a_Instruction );
+			Key |= State << DepthBits | QuantizedDepth;
 		}
 
-		return *this;
+		m_Items.push_back( { Key, a_Mesh, a_Material, a_Model, a_Fade, m_Order } );
 	}
 
-private:
+	void Sort()
+	{
+		size_t Count = m_Items.size();
+		m_Scratch.resize( Count );
+
+		DrawItem* Source = m_Items.data();
+		DrawItem* Destination = m_Scratch.data();
+
+		// Least significant digit first, 8 bits per pass, over the order and then the key. Passes where
+		// every item shares the same digit are skipped, which is common for the layer and depth bytes
+		// and the upper bytes of the order.
+		for ( uint32_t Pass = 0; Pass < 12; ++Pass )
+		{
+			size_t Offsets[ 256 ] = { 0 };
+			auto Digit = [ Pass ]( const DrawItem& a_Item ) -> size_t
+			{
+				return Pass < 4 ? ( a_Item.Order >> ( Pass * 8 ) ) & 0xFF : ( a_Item.Key >> ( ( Pass - 4 ) * 8 ) ) & 0xFF;
+			};
+
+			for ( size_t i = 0; i < Count; ++i )
+			{
+				++Offsets[ Digit( Source[ i ] ) ];
+			}
+
+			if ( Count == 0 || Offsets[ Digit( Source[ 0 ] ) ] == Count )
+			{
+				continue;
+			}
+
+			for ( size_t i = 0, Total = 0; i < 256; ++i )
+			{
+				size_t Digits = Offsets[ i ];
+				Offsets[ i ] = Total;
+				Total += Digits;
+			}
+
+			for ( size_t i = 0; i < Count; ++i )
+			{
+				Destination[ Offsets[ Digit( Source[ i ] ) ]++ ] = Source[ i ];
+			}
 
-	inline void Sort()
+			std::swap( Source, Destination );
+		}
+
+		if ( Source != m_Items.data() )
+		{
+			m_Items.swap( m_Scratch );
+		}
+	}
+
+	// Replaces the contents with the items of a_Queues, which must each be sorted. Items are merged by
+	// key and then by order, so the result doesn't depend on which queue an item was submitted to.
+	void Merge( const RenderQueue* a_Queues, size_t a_Count )
 	{
-		// Need to sort the queue here somehow.
+		size_t Total = 0;
+		m_Heads.assign( a_Count, 0 );
+
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Total += a_Queues[ i ].m_Items.size();
+		}
+
+		m_Items.clear();
+		m_Items.reserve( Total );
+
+		// Few queues are merged at once, one per thread, so the smallest head is found by scanning.
+		for ( size_t n = 0; n < Total; ++n )
+		{
+			size_t Smallest = a_Count;
+
+			for ( size_t i = 0; i < a_Count; ++i )
+			{
+				if ( m_Heads[ i ] < a_Queues[ i ].m_Items.size() && ( Smallest == a_Count || IsBefore( a_Queues[ i ].m_Items[ m_Heads[ i ] ], a_Queues[ Smallest ].m_Items[ m_Heads[ Smallest ] ] ) ) )
+				{
+					Smallest = i;
+				}
+			}
+
+			m_Items.push_back( a_Queues[ Smallest ].m_Items[ m_Heads[ Smallest ]++ ] );
+		}
+	}
+
+	inline const DrawItem* begin() const
+	{
+		return m_Items.data();
+	}
+
+	inline const DrawItem* end() const
+	{
+		return m_Items.data() + m_Items.size();
 	}
 
-	inline RenderInstruction& Front()
+	inline size_t Size() const
 	{
-		return m_RenderInstructions.front();
+		return m_Items.size();
 	}
 
-	inline void Pop()
+	inline bool Empty() const
 	{
-		m_RenderInstructions.pop_front();
+		return m_Items.empty();
 	}
 
-	inline bool Empty()
+private:
+
+	inline static bool IsBefore( const DrawItem& a_Left, const DrawItem& a_Right )
 	{
-		return m_RenderInstructions.empty();
+		return a_Left.Key < a_Right.Key || ( a_Left.Key == a_Right.Key && a_Left.Order < a_Right.Order );
 	}
 
-	friend class RenderingPipeline;
+	// Pointers are folded into a short id. Collisions only weaken the grouping, each item still
+	// carries the resources it draws with.
+	inline static uint64_t FoldID( const void* a_Resource )
+	{
+		uintptr_t Address = reinterpret_cast< uintptr_t >( a_Resource ) >> 4;
+		return ( Address ^ ( Address >> IDBits ) ^ ( Address >> ( IDBits * 2 ) ) ) & ( ( 1u << IDBits ) - 1 );
+	}
 
-	std::list< RenderInstruction > m_RenderInstructions;
-};
\ No newline at end of file
+	std::vector< DrawItem > m_Items;
+	std::vector< DrawItem > m_Scratch;
+	std::vector< size_t >   m_Heads;
+	Vector3                 m_ViewPosition;
+	Vector3                 m_ViewForward;
+	float                   m_InverseFarZ = 0.0f;
+	uint32_t                m_Order = 0;
+};
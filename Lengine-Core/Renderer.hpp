@@ -1,12 +1,84 @@
 #pragma once
 #include "Component.hpp"
+#include "Bounds.hpp"
 #include "RenderQueue.hpp"
+#include "RenderingPipeline.hpp"
+
+class Mesh;
+
+template < typename T >
+class IMeshRenderer;
+
+typedef IMeshRenderer< void > MeshRenderer;
 
 DefineComponent( Renderer, Component )
 {
 public:
 
-	friend class RenderPipeline;
-	
+	friend class RenderingPipeline;
+
+	// Renderers are tracked by the pipeline's spatial index from creation until they are destroyed.
+	// Exact MeshRenderers are also collected through the pipeline's renderer group.
+	void OnCreate()
+	{
+		m_Proxy = RenderingPipeline::AddRenderer( this->GetOwnerID(), Resolve, std::is_same_v< Exact, MeshRenderer > );
+	}
+
+	void OnDestroy()
+	{
+		RenderingPipeline::RemoveRenderer( this->GetOwnerID(), Resolve );
+	}
+
+	// SelectLOD and OnRender run on worker threads, a renderer should only modify itself in them.
 	virtual void OnRender( RenderQueue& a_RenderQueue ) const { };
-};
\ No newline at end of file
+
+	// World space bounds used for culling. Renderers that return false are never culled.
+	virtual bool GetBounds( AABB& o_Bounds ) const { return false; }
+
+	// Mesh rasterized into the occlusion buffer with the owner's transform, if this renderer hides
+	// what is behind it.
+	virtual const Mesh* GetOccluder() const { return nullptr; }
+
+	// Mesh drawn into the sun's shadow map with the owner's transform, if this renderer casts shadows.
+	virtual const Mesh* GetShadowCaster() const { return nullptr; }
+
+	// Static casters are cached in the shadow map across frames. Call InvalidateBounds when this or
+	// the caster changes.
+	virtual bool IsStaticShadowCaster() const { return false; }
+
+	// Called for visible renderers before OnRender, with the height of their bounds as a fraction of
+	// the screen height.
+	virtual void SelectLOD( float a_ScreenSize, float a_DeltaTime ) { }
+
+	// Layers are drawn in ascending order, before any other sorting.
+	inline uint8_t GetRenderLayer() const
+	{
+		return m_RenderLayer;
+	}
+
+	inline void SetRenderLayer( uint8_t a_Layer )
+	{
+		m_RenderLayer = a_Layer;
+	}
+
+protected:
+
+	// Call when the bounds change for reasons other than the Transform moving.
+	inline void InvalidateBounds()
+	{
+		RenderingPipeline::InvalidateRenderer( this->GetOwnerID() );
+	}
+
+	uint8_t m_RenderLayer = 0;
+
+private:
+
+	uint32_t m_Proxy = uint32_t( -1 );
+
+	using Exact = std::tuple_element_t< std::tuple_size_v< typename unwrap< IRenderer< T > >::Tuple > - 1, typename unwrap< IRenderer< T > >::Tuple >;
+
+	static Renderer* Resolve( GameObjectID a_ID )
+	{
+		return reinterpret_cast< Renderer* >( Component::GetExactComponent< Exact >( a_ID ) );
+	}
+};
@@ -27,7 +27,13 @@ namespace Rendering
 	void ApplyUniform( const char* a_Name, uint32_t a_Count, const Matrix4* a_Value );
 	void Clear();
 	void Draw();
+	void DrawInstanced( const Matrix4* a_Models, uint32_t a_Count );
+	void Resolve( const Matrix4& a_ProjectionView );
 
 	
+	// Instanced draws feed each model matrix to the vertex shader as four Vector4 columns starting at
+	// this attribute location. Shaders used for them read u_PV rather than u_PVM.
+	constexpr uint32_t InstanceModelLocation = 8;
+
 	inline static const Mesh* ActiveMesh;
 };
\ No newline at end of file
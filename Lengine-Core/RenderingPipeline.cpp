@@ -1,5 +1,6 @@
-#include <list>
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 
 #include "RenderingPipeline.hpp"
 #include "Component.hpp"
@@ -7,7 +8,10 @@
 #include "Frustum.hpp"
 #include "Renderer.hpp"
 #include "Rendering.hpp"
-#include "RenderInstruction.hpp"
+#include "RenderingState.hpp"
+#include "Residency.hpp"
+#include "Time.hpp"
+#include "WorkerPool.hpp"
 #include "RenderQueue.hpp"
 #include "Mesh.hpp"
 #include "Material.hpp"
@@ -17,69 +21,695 @@
 void RenderingPipeline::Init()
 {
 	Rendering::Init();
+
+	// Culling narrows down the visible set, which is collected into the draw queue and then drawn.
+	// Features add their own passes around these through GetRenderGraph. Shadows are drawn once the
+	// occlusion depth is done with, so the two targets can share memory.
+	s_OcclusionDepth = s_RenderGraph.CreateTarget( "OcclusionDepth", { OcclusionBuffer::Width, OcclusionBuffer::Height, sizeof( float ) } );
+	s_ShadowDepth = s_RenderGraph.CreateTarget( "ShadowMap", { s_ShadowMap.GetResolution(), s_ShadowMap.GetResolution() * s_ShadowMap.GetCascadeCount(), sizeof( float ) } );
+	RenderGraph::ResourceID VisibleSet = s_RenderGraph.CreateResource( "VisibleSet" );
+	RenderGraph::ResourceID DrawQueue = s_RenderGraph.CreateResource( "DrawQueue" );
+	RenderGraph::ResourceID Backbuffer = s_RenderGraph.Import( "Backbuffer" );
+
+	s_FrustumCullPass = s_RenderGraph.AddPass( "FrustumCull", FrustumCullPass ).Write( VisibleSet );
+	s_OccluderPass = s_RenderGraph.AddPass( "Occluders", OccluderPass ).Read( VisibleSet ).Write( VisibleSet ).Write( s_OcclusionDepth );
+	s_OcclusionCullPass = s_RenderGraph.AddPass( "OcclusionCull", OcclusionCullPass ).Read( VisibleSet ).Read( s_OcclusionDepth ).Write( VisibleSet );
+	s_ShadowPass = s_RenderGraph.AddPass( "Shadows", ShadowPass ).Write( s_ShadowDepth );
+	s_RenderGraph.AddPass( "Collect", CollectPass ).Read( VisibleSet ).Write( DrawQueue );
+	s_RenderGraph.AddPass( "Forward", ForwardPass ).Read( DrawQueue ).Read( s_ShadowDepth ).Write( Backbuffer );
+
+	// Created up front rather than on first use, as it moves every MeshRenderer and Transform.
+	Component::GetOwningGroup< MeshRenderer, Transform >();
 }
 
-void RenderingPipeline::Tick()
+uint32_t RenderingPipeline::AddRenderer( GameObjectID a_Owner, RendererResolver a_Resolver, bool a_Grouped )
 {
-	// Collect all instructions.
-	auto Renderers = Component::GetComponents< Renderer >();
-	RenderQueue Queue;
+	uint32_t Index;
 
-	for ( auto Renderer : Renderers )
+	if ( !s_FreeProxies.empty() )
+	{
+		Index = s_FreeProxies.back();
+		s_FreeProxies.pop_back();
+	}
+	else
 	{
-		Renderer->OnRender( Queue );
+		Index = static_cast< uint32_t >( s_Proxies.size() );
+		s_Proxies.emplace_back();
 	}
 
-	// Sort all render instructions
-	//s_RenderInstructions.sort();
+	// Renderers on the same object are chained together.
+	auto Existing = s_ProxyLookup.find( a_Owner );
+	RendererProxy& Proxy = s_Proxies[ Index ];
+	Proxy.Owner = a_Owner;
+	Proxy.Resolve = a_Resolver;
+	Proxy.Node = SpatialIndex::Null;
+	Proxy.Next = Existing != s_ProxyLookup.end() ? Existing->second : SpatialIndex::Null;
+	Proxy.Pending = false;
+	Proxy.Unbounded = false;
+	Proxy.StaticCaster = false;
+	Proxy.Occluder = false;
+	Proxy.Grouped = a_Grouped;
+	s_ProxyLookup[ a_Owner ] = Index;
+	Invalidate( Index );
+	return Index;
+}
 
-	// Remove this later
-	//Sleep( 33 );
+void RenderingPipeline::RemoveRenderer( GameObjectID a_Owner, RendererResolver a_Resolver )
+{
+	auto Existing = s_ProxyLookup.find( a_Owner );
 
-	Rendering::Clear();
+	if ( Existing == s_ProxyLookup.end() )
+	{
+		return;
+	}
+
+	uint32_t* Link = &Existing->second;
+
+	while ( *Link != SpatialIndex::Null && s_Proxies[ *Link ].Resolve != a_Resolver )
+	{
+		Link = &s_Proxies[ *Link ].Next;
+	}
+
+	if ( *Link == SpatialIndex::Null )
+	{
+		return;
+	}
+
+	uint32_t Index = *Link;
+	RendererProxy& Proxy = s_Proxies[ Index ];
+	*Link = Proxy.Next;
+
+	if ( Existing->second == SpatialIndex::Null )
+	{
+		s_ProxyLookup.erase( Existing );
+	}
+
+	if ( Proxy.Node != SpatialIndex::Null )
+	{
+		s_SpatialIndex.Remove( Proxy.Node );
+		Proxy.Node = SpatialIndex::Null;
+	}
+
+	if ( Proxy.Unbounded )
+	{
+		s_UnboundedProxies.erase( std::find( s_UnboundedProxies.begin(), s_UnboundedProxies.end(), Index ) );
+		Proxy.Unbounded = false;
+	}
+
+	if ( Proxy.StaticCaster )
+	{
+		s_ShadowMap.InvalidateStatic();
+		Proxy.StaticCaster = false;
+	}
+
+	// Pending proxies are freed once they come out of the pending list.
+	Proxy.Resolve = nullptr;
+
+	if ( !Proxy.Pending )
+	{
+		s_FreeProxies.push_back( Index );
+	}
+}
 
-	// Process queue.
-	while ( !Queue.Empty() )
+void RenderingPipeline::InvalidateRenderer( GameObjectID a_Owner )
+{
+	auto Existing = s_ProxyLookup.find( a_Owner );
+
+	if ( Existing == s_ProxyLookup.end() )
+	{
+		return;
+	}
+
+	for ( uint32_t Index = Existing->second; Index != SpatialIndex::Null; Index = s_Proxies[ Index ].Next )
+	{
+		Invalidate( Index );
+	}
+}
+
+void RenderingPipeline::Invalidate( uint32_t a_Proxy )
+{
+	RendererProxy& Proxy = s_Proxies[ a_Proxy ];
+
+	if ( !Proxy.Pending )
+	{
+		Proxy.Pending = true;
+		s_PendingProxies.push_back( a_Proxy );
+	}
+}
+
+void RenderingPipeline::UpdateSpatialIndex()
+{
+	for ( GameObjectID Moved : Transform::GetMoved() )
+	{
+		InvalidateRenderer( Moved );
+	}
+
+	for ( uint32_t Index : s_PendingProxies )
 	{
-		auto& Instruction = Queue.Front();
+		RendererProxy& Proxy = s_Proxies[ Index ];
+		Proxy.Pending = false;
 
-		switch ( Instruction.Modification )
+		if ( !Proxy.Resolve )
+		{
+			s_FreeProxies.push_back( Index );
+			continue;
+		}
+
+		const Renderer* Found = Proxy.Resolve( Proxy.Owner );
+		AABB Bounds;
+
+		// Cached static shadows are redrawn whenever a static caster changes.
+		bool StaticCaster = Found && Found->IsStaticShadowCaster();
+
+		if ( StaticCaster || Proxy.StaticCaster )
+		{
+			s_ShadowMap.InvalidateStatic();
+		}
+
+		Proxy.StaticCaster = StaticCaster;
+		Proxy.Occluder = Found && Found->GetOccluder();
+
+		if ( Found && Found->GetBounds( Bounds ) )
+		{
+			if ( Proxy.Unbounded )
+			{
+				s_UnboundedProxies.erase( std::find( s_UnboundedProxies.begin(), s_UnboundedProxies.end(), Index ) );
+				Proxy.Unbounded = false;
+			}
+
+			if ( Proxy.Node == SpatialIndex::Null )
+			{
+				Proxy.Node = s_SpatialIndex.Insert( Bounds, Index );
+			}
+			else
+			{
+				s_SpatialIndex.Move( Proxy.Node, Bounds );
+			}
+		}
+		else
 		{
-			case RenderInstruction::Modification::SET:
+			if ( Proxy.Node != SpatialIndex::Null )
 			{
-				switch ( Instruction.Object )
+				s_SpatialIndex.Remove( Proxy.Node );
+				Proxy.Node = SpatialIndex::Null;
+			}
+
+			if ( !Proxy.Unbounded )
+			{
+				s_UnboundedProxies.push_back( Index );
+				Proxy.Unbounded = true;
+			}
+		}
+	}
+
+	s_PendingProxies.clear();
+}
+
+bool RenderingPipeline::GetScreenSize( const RendererProxy& a_Proxy, float& o_ScreenSize )
+{
+	if ( a_Proxy.Node == SpatialIndex::Null )
+	{
+		return false;
+	}
+
+	// Screen size is the projected diameter of the bounding sphere over the screen height. Fat bounds
+	// are shrunk back by the margin they were grown with.
+	const AABB& Bounds = s_SpatialIndex.GetFatBounds( a_Proxy.Node );
+	float Radius = Math::Length( Bounds.GetExtents() );
+	float Distance = Math::Length( Bounds.GetCentre() - s_ViewPosition );
+	o_ScreenSize = Distance > Radius ? Math::Min( Radius * s_LODScale / Distance, 1.0f ) : 1.0f;
+	return true;
+}
+
+bool RenderingPipeline::CollectRenderer( uint32_t a_Proxy, uint32_t a_Thread )
+{
+	const RendererProxy& Proxy = s_Proxies[ a_Proxy ];
+	Renderer* Found = Proxy.Resolve( Proxy.Owner );
+
+	if ( !Found )
+	{
+		return false;
+	}
+
+	float ScreenSize;
+
+	if ( GetScreenSize( Proxy, ScreenSize ) )
+	{
+		Found->SelectLOD( ScreenSize, s_DeltaTime );
+	}
+
+	s_ThreadQueues[ a_Thread ].SetOrder( a_Proxy );
+	Found->OnRender( s_ThreadQueues[ a_Thread ] );
+	return true;
+}
+
+bool RenderingPipeline::WalkGroup( size_t a_Marked )
+{
+	// Walking reads every renderer in the group, which only pays off once enough of them are needed.
+	size_t Size = Component::GetOwningGroup< MeshRenderer, Transform >().size();
+	return a_Marked > 0 && static_cast< float >( a_Marked ) >= static_cast< float >( Size ) * s_GroupThreshold;
+}
+
+void RenderingPipeline::QueryVisible( const Frustum& a_Frustum )
+{
+	// The tree is split into a few subtrees per thread. Each is queried into its own list, so the
+	// order of the result doesn't depend on scheduling.
+	s_SpatialIndex.Split( a_Frustum, WorkerPool::GetThreadCount() * 4, s_Subtrees, []( uint32_t a_Proxy ){ s_VisibleProxies.push_back( a_Proxy ); } );
+
+	if ( s_SubtreeVisible.size() < s_Subtrees.size() )
+	{
+		s_SubtreeVisible.resize( s_Subtrees.size() );
+	}
+
+	WorkerPool::ParallelFor( s_Subtrees.size(), 1, [ &a_Frustum ]( size_t a_Begin, size_t a_End, uint32_t a_Thread )
+	{
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			std::vector< uint32_t >& Visible = s_SubtreeVisible[ i ];
+			Visible.clear();
+			s_SpatialIndex.Query( a_Frustum, s_Subtrees[ i ], s_ThreadStacks[ a_Thread ], [ &Visible ]( uint32_t a_Proxy ){ Visible.push_back( a_Proxy ); } );
+		}
+	} );
+
+	for ( size_t i = 0; i < s_Subtrees.size(); ++i )
+	{
+		s_VisibleProxies.insert( s_VisibleProxies.end(), s_SubtreeVisible[ i ].begin(), s_SubtreeVisible[ i ].end() );
+	}
+}
+
+void RenderingPipeline::FrustumCullPass( const RenderGraph& a_Graph )
+{
+	QueryVisible( Frustum( s_ProjectionView ) );
+}
+
+void RenderingPipeline::OccluderPass( const RenderGraph& a_Graph )
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+	s_OcclusionBuffer.Begin( s_ProjectionView, a_Graph.GetTarget< float >( s_OcclusionDepth ) );
+
+	// Rasterize occluders and move them to the front, they are always drawn.
+	size_t Occluders = 0;
+
+	for ( size_t i = 0; i < s_VisibleProxies.size(); ++i )
+	{
+		const RendererProxy& Proxy = s_Proxies[ s_VisibleProxies[ i ] ];
+
+		// Whether a renderer is an occluder is kept along with its bounds, only occluders are looked up.
+		if ( !Proxy.Occluder )
+		{
+			continue;
+		}
+
+		const Renderer* Found = Proxy.Resolve( Proxy.Owner );
+		const Mesh* Occluder = Found ? Found->GetOccluder() : nullptr;
+
+		if ( Occluder )
+		{
+			s_OcclusionStats.OccluderTriangles += s_OcclusionBuffer.RasterizeOccluder( *Occluder, Found->GetOwner().GetTransform()->GetGlobalMatrix() );
+			std::swap( s_VisibleProxies[ Occluders++ ], s_VisibleProxies[ i ] );
+		}
+	}
+
+	s_OcclusionStats.Occluders = static_cast< uint32_t >( Occluders );
+	s_OcclusionStats.RasterizeTime = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+}
+
+void RenderingPipeline::OcclusionCullPass( const RenderGraph& a_Graph )
+{
+	size_t Occluders = s_OcclusionStats.Occluders;
+
+	if ( Occluders == 0 )
+	{
+		return;
+	}
+
+	// Test everything else by its fat bounds from the spatial index, which are conservative. The
+	// buffer is only read from here on, so tests are spread across threads.
+	auto Start = std::chrono::high_resolution_clock::now();
+	s_OcclusionResults.resize( s_VisibleProxies.size() );
+
+	WorkerPool::ParallelFor( s_VisibleProxies.size() - Occluders, OcclusionBatchSize, [ Occluders ]( size_t a_Begin, size_t a_End, uint32_t )
+	{
+		for ( size_t i = a_Begin + Occluders; i < a_End + Occluders; ++i )
+		{
+			s_OcclusionResults[ i ] = s_OcclusionBuffer.IsVisible( s_SpatialIndex.GetFatBounds( s_Proxies[ s_VisibleProxies[ i ] ].Node ) );
+		}
+	} );
+
+	size_t Kept = Occluders;
+
+	for ( size_t i = Occluders; i < s_VisibleProxies.size(); ++i )
+	{
+		if ( s_OcclusionResults[ i ] )
+		{
+			s_VisibleProxies[ Kept++ ] = s_VisibleProxies[ i ];
+		}
+	}
+
+	s_OcclusionStats.Tested = static_cast< uint32_t >( s_VisibleProxies.size() - Occluders );
+	s_OcclusionStats.Culled = static_cast< uint32_t >( s_VisibleProxies.size() - Kept );
+	s_OcclusionStats.TestTime = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+	s_VisibleProxies.resize( Kept );
+}
+
+void RenderingPipeline::MarkCaster( uint32_t a_Proxy, uint32_t a_Cascade, bool a_Static )
+{
+	const RendererProxy& Proxy = s_Proxies[ a_Proxy ];
+
+	// Static casters are left out while the cascade's cached layer already holds them.
+	if ( Proxy.StaticCaster && !a_Static )
+	{
+		return;
+	}
+
+	if ( !Proxy.Grouped )
+	{
+		CollectCaster( a_Proxy, a_Cascade );
+		return;
+	}
+
+	if ( !s_ProxyMarks[ a_Proxy ] )
+	{
+		s_GroupedProxies.push_back( a_Proxy );
+	}
+
+	s_ProxyMarks[ a_Proxy ] |= 1 << a_Cascade;
+}
+
+void RenderingPipeline::CollectCaster( uint32_t a_Proxy, uint32_t a_Cascade )
+{
+	const RendererProxy& Proxy = s_Proxies[ a_Proxy ];
+	const Renderer* Found = Proxy.Resolve( Proxy.Owner );
+	const Mesh* Caster = Found ? Found->GetShadowCaster() : nullptr;
+
+	if ( Caster )
+	{
+		( Proxy.StaticCaster ? s_StaticCasters : s_DynamicCasters )[ a_Cascade ].push_back( { Caster, Found->GetOwner().GetTransform()->GetGlobalMatrix() } );
+	}
+}
+
+void RenderingPipeline::ShadowPass( const RenderGraph& a_Graph )
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+	uint32_t Cascades = s_ShadowMap.GetCascadeCount();
+
+	// Casters are found by the light space frustum of each cascade, one cascade at a time as the
+	// spatial index is queried with its own stack. MeshRenderers are marked with the cascades they
+	// fall in, the rest are gathered straight away.
+	s_GroupedProxies.clear();
+	s_ProxyMarks.assign( s_Proxies.size(), 0 );
+
+	for ( uint32_t i = 0; i < Cascades; ++i )
+	{
+		bool Static = !s_ShadowMap.IsStaticCached( i );
+		s_StaticCasters[ i ].clear();
+		s_DynamicCasters[ i ].clear();
+		s_SpatialIndex.Query( Frustum( s_ShadowMap.GetCascadeMatrix( i ) ), [ i, Static ]( uint32_t a_Proxy ){ MarkCaster( a_Proxy, i, Static ); } );
+
+		for ( uint32_t Proxy : s_UnboundedProxies )
+		{
+			MarkCaster( Proxy, i, Static );
+		}
+	}
+
+	// Marked MeshRenderers are gathered for every cascade in a single walk of the group.
+	if ( WalkGroup( s_GroupedProxies.size() ) )
+	{
+		auto& Group = Component::GetOwningGroup< MeshRenderer, Transform >();
+		auto Renderers = Component::GetOwned< MeshRenderer >( Group );
+		auto Transforms = Component::GetOwned< Transform >( Group );
+
+		for ( size_t i = 0, Size = Group.size(); i < Size; ++i )
+		{
+			const MeshRenderer& Found = Renderers[ i ];
+			uint8_t Mark = s_ProxyMarks[ Found.m_Proxy ];
+			const Mesh* Caster = Mark ? Found.GetShadowCaster() : nullptr;
+
+			if ( !Caster )
+			{
+				continue;
+			}
+
+			auto& Casters = s_Proxies[ Found.m_Proxy ].StaticCaster ? s_StaticCasters : s_DynamicCasters;
+
+			for ( uint32_t c = 0; c < Cascades; ++c )
+			{
+				if ( Mark & ( 1 << c ) )
 				{
-					case RenderInstruction::Object::Mesh:
-					{
-						Rendering::ApplyMesh( *static_cast< const Mesh* >( Instruction.ResourceSource ) );
-						break;
-					}
-					case RenderInstruction::Object::Material:
-					{
-						Rendering::ApplyMaterial( *static_cast< const Material* >( Instruction.ResourceSource ) );
-						break;
-					}
-					case RenderInstruction::Object::Model:
-					{
-						const Matrix4* ActiveModel = static_cast< const Matrix4* >( Instruction.ResourceSource );
-						Rendering::ApplyUniform( "u_Model", 16, &( *ActiveModel )[ 0 ] );
-						Matrix4 PVM = Math::Multiply( Camera::GetMainCamera()->GetProjectionViewMatrix(), *ActiveModel );
-						Rendering::ApplyUniform( "u_PVM", 16, &PVM );
-						break;
-					}
+					Casters[ c ].push_back( { Caster, Transforms[ i ].GetGlobalMatrix() } );
 				}
-
-				s_Dirty = true;
-				break;
 			}
-			case RenderInstruction::Modification::DRAW:
+		}
+	}
+	else
+	{
+		for ( uint32_t Proxy : s_GroupedProxies )
+		{
+			for ( uint32_t c = 0; c < Cascades; ++c )
 			{
-				Rendering::Draw();
+				if ( s_ProxyMarks[ Proxy ] & ( 1 << c ) )
+				{
+					CollectCaster( Proxy, c );
+				}
 			}
 		}
+	}
 
-		Queue.Pop();
+	for ( uint32_t i = 0; i < Cascades; ++i )
+	{
+		s_ShadowStats.Casters += static_cast< uint32_t >( s_StaticCasters[ i ].size() + s_DynamicCasters[ i ].size() );
+		s_ShadowStats.StaticCasters += static_cast< uint32_t >( s_StaticCasters[ i ].size() );
+		s_ShadowStats.CachedCascades += s_ShadowMap.IsStaticCached( i );
 	}
+
+	// Cascades are drawn into their own slices of the target in parallel.
+	float* Depth = a_Graph.GetTarget< float >( s_ShadowDepth );
+	size_t Texels = static_cast< size_t >( s_ShadowMap.GetResolution() ) * s_ShadowMap.GetResolution();
+
+	WorkerPool::ParallelFor( Cascades, 1, [ Depth, Texels ]( size_t a_Begin, size_t a_End, uint32_t )
+	{
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			s_ShadowTriangles[ i ] = s_ShadowMap.RenderCascade( static_cast< uint32_t >( i ), Depth + i * Texels, s_StaticCasters[ i ], s_DynamicCasters[ i ] );
+		}
+	} );
+
+	for ( uint32_t i = 0; i < Cascades; ++i )
+	{
+		s_ShadowStats.Triangles += s_ShadowTriangles[ i ];
+	}
+
+	s_ShadowMap.SetDepth( Depth );
+	s_ShadowStats.RasterizeTime = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+}
+
+void RenderingPipeline::CollectPass( const RenderGraph& a_Graph )
+{
+	// Renderers pick their level of detail and submit their draws across threads, each thread into
+	// its own queue. The queues are sorted in parallel and merged by key.
+	for ( RenderQueue& Queue : s_ThreadQueues )
+	{
+		Queue.Begin( s_ViewPosition, s_ViewForward, s_FarZ );
+	}
+
+	// MeshRenderers are marked and collected by walking their group, reading each along with its
+	// Transform in lockstep. Other renderers, or all of them when few MeshRenderers are visible, are
+	// looked up one at a time.
+	s_GroupedProxies.clear();
+	s_LookupProxies.clear();
+
+	for ( const std::vector< uint32_t >* Proxies : { &s_VisibleProxies, &s_UnboundedProxies } )
+	{
+		for ( uint32_t Proxy : *Proxies )
+		{
+			( s_Proxies[ Proxy ].Grouped ? s_GroupedProxies : s_LookupProxies ).push_back( Proxy );
+		}
+	}
+
+	bool Walk = WalkGroup( s_GroupedProxies.size() );
+
+	if ( Walk )
+	{
+		s_ProxyMarks.assign( s_Proxies.size(), 0 );
+
+		for ( uint32_t Proxy : s_GroupedProxies )
+		{
+			s_ProxyMarks[ Proxy ] = 1;
+		}
+	}
+	else
+	{
+		s_LookupProxies.insert( s_LookupProxies.end(), s_GroupedProxies.begin(), s_GroupedProxies.end() );
+	}
+
+	std::atomic< uint32_t > Collected = 0;
+
+	WorkerPool::ParallelFor( s_LookupProxies.size(), CollectBatchSize, [ &Collected ]( size_t a_Begin, size_t a_End, uint32_t a_Thread )
+	{
+		uint32_t Count = 0;
+
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			Count += CollectRenderer( s_LookupProxies[ i ], a_Thread );
+		}
+
+		Collected += Count;
+	} );
+
+	if ( Walk )
+	{
+		auto& Group = Component::GetOwningGroup< MeshRenderer, Transform >();
+		auto Renderers = Component::GetOwned< MeshRenderer >( Group );
+		auto Transforms = Component::GetOwned< Transform >( Group );
+
+		WorkerPool::ParallelFor( Group.size(), CollectBatchSize, [ Renderers, Transforms, &Collected ]( size_t a_Begin, size_t a_End, uint32_t a_Thread )
+		{
+			uint32_t Count = 0;
+
+			for ( size_t i = a_Begin; i < a_End; ++i )
+			{
+				MeshRenderer& Found = Renderers[ i ];
+
+				if ( !s_ProxyMarks[ Found.m_Proxy ] )
+				{
+					continue;
+				}
+
+				float ScreenSize;
+
+				if ( GetScreenSize( s_Proxies[ Found.m_Proxy ], ScreenSize ) )
+				{
+					Found.SelectLOD( ScreenSize, s_DeltaTime );
+				}
+
+				s_ThreadQueues[ a_Thread ].SetOrder( Found.m_Proxy );
+				Found.Submit( s_ThreadQueues[ a_Thread ], Transforms[ i ].GetGlobalMatrix() );
+				++Count;
+			}
+
+			Collected += Count;
+		} );
+	}
+
+	WorkerPool::ParallelFor( s_ThreadQueues.size(), 1, []( size_t a_Begin, size_t a_End, uint32_t )
+	{
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			s_ThreadQueues[ i ].Sort();
+		}
+	} );
+
+	s_Queue.Merge( s_ThreadQueues.data(), s_ThreadQueues.size() );
+	s_VisibleCount = Collected;
+
+	// PVM matrices are computed up front in batches rather than one at a time during submission.
+	const DrawItem* Items = s_Queue.begin();
+	s_PVMs.resize( s_Queue.Size() );
+
+	WorkerPool::ParallelFor( s_Queue.Size(), PVMBatchSize, [ Items ]( size_t a_Begin, size_t a_End, uint32_t )
+	{
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			s_PVMs[ i ] = Math::Multiply( s_ProjectionView, Items[ i ].Model );
+		}
+	} );
+}
+
+void RenderingPipeline::ForwardPass( const RenderGraph& a_Graph )
+{
+	const DrawItem* Items = s_Queue.begin();
+	size_t Count = s_Queue.Size();
+
+	RenderingState::BeginFrame();
+	Residency::NextFrame();
+	Rendering::Clear();
+	s_DrawCalls = 0;
+
+	// Process queue. Consecutive draws usually share state after sorting, the backend skips any
+	// binds that are already in place. Opaque keys order by material and mesh before depth, so
+	// renderers sharing an instancing material and a mesh end up next to each other and are
+	// submitted as a single instanced draw.
+	for ( size_t Begin = 0, End; Begin < Count; Begin = End )
+	{
+		const DrawItem& Item = Items[ Begin ];
+		End = Begin + 1;
+
+		Rendering::ApplyMesh( *Item.Mesh );
+		Rendering::ApplyMaterial( *Item.Material );
+
+		if ( !Item.Material->Instancing )
+		{
+			Rendering::ApplyUniform( "u_LODFade", 1, &Item.Fade );
+			Rendering::ApplyUniform( "u_Model", 16, &Item.Model[ 0 ] );
+			Rendering::ApplyUniform( "u_PVM", 1, &s_PVMs[ Begin ] );
+			Rendering::Draw();
+			++s_DrawCalls;
+			continue;
+		}
+
+		// Instancing shaders only read the model matrix per instance, so a run also has to share
+		// its u_LODFade. Fading draws mostly end up in runs of their own.
+		s_Instances.clear();
+		s_Instances.push_back( Item.Model );
+
+		while ( End < Count && Items[ End ].Mesh == Item.Mesh && Items[ End ].Material == Item.Material && Items[ End ].Fade == Item.Fade )
+		{
+			s_Instances.push_back( Items[ End++ ].Model );
+		}
+
+		Rendering::ApplyUniform( "u_LODFade", 1, &Item.Fade );
+		Rendering::ApplyUniform( "u_PV", 1, &s_ProjectionView );
+		Rendering::DrawInstanced( s_Instances.data(), static_cast< uint32_t >( s_Instances.size() ) );
+		++s_DrawCalls;
+	}
+
+	Rendering::Resolve( s_ProjectionView );
+}
+
+void RenderingPipeline::Tick()
+{
+	UpdateSpatialIndex();
+
+	uint32_t Threads = WorkerPool::GetThreadCount();
+	s_ThreadQueues.resize( Threads );
+	s_ThreadStacks.resize( Threads );
+
+	const Camera* MainCamera = Camera::GetMainCamera();
+	s_ProjectionView = MainCamera ? MainCamera->GetProjectionViewMatrix() : Matrix4::Identity;
+	s_ViewPosition = Vector3::Zero;
+	s_ViewForward = Vector3::Forward;
+	s_FarZ = 0.0f;
+	s_DeltaTime = Time::GetRealDeltaTime();
+	s_VisibleProxies.clear();
+	s_OcclusionStats = OcclusionStats();
+	s_ShadowStats = ShadowStats();
+	s_ShadowMap.SetDepth( nullptr );
+
+	if ( MainCamera )
+	{
+		const Transform* CameraTransform = MainCamera->GetOwner().GetTransform();
+		s_ViewPosition = CameraTransform->GetGlobalPosition();
+		s_LODScale = 1.0f / ( Math::Tan( MainCamera->GetFOV() * 0.5f ) * ( 1.0f + 2.0f * SpatialIndex::Margin ) );
+		s_ViewForward = CameraTransform->GetGlobalForward();
+		s_FarZ = MainCamera->GetFarZ();
+	}
+
+	const Light* Sun = Light::GetSun();
+	bool Shadows = MainCamera && Sun && s_Shadows;
+
+	if ( Shadows )
+	{
+		s_ShadowMap.Fit( Sun->GetDirection(), s_ViewPosition, s_ViewForward, MainCamera->GetFOV(), MainCamera->GetAspect(), MainCamera->GetNearZ() );
+	}
+
+	// Without a camera nothing is culled, only renderers that can't be culled are collected. The
+	// graph only recompiles when this changes.
+	s_RenderGraph.SetPassEnabled( s_FrustumCullPass, MainCamera != nullptr );
+	s_RenderGraph.SetPassEnabled( s_OccluderPass, MainCamera && s_OcclusionCulling );
+	s_RenderGraph.SetPassEnabled( s_OcclusionCullPass, MainCamera && s_OcclusionCulling );
+	s_RenderGraph.SetPassEnabled( s_ShadowPass, Shadows );
+	s_RenderGraph.SetTargetDesc( s_ShadowDepth, { s_ShadowMap.GetResolution(), s_ShadowMap.GetResolution() * s_ShadowMap.GetCascadeCount(), sizeof( float ) } );
+	s_RenderGraph.Execute();
 }
 
 void RenderingPipeline::Draw()
@@ -1,9 +1,128 @@
 #pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "RenderQueue.hpp"
+#include "SpatialIndex.hpp"
+#include "OcclusionBuffer.hpp"
+#include "ShadowMap.hpp"
+#include "RenderGraph.hpp"
+
+typedef uint32_t GameObjectID;
+
+template < typename T >
+class IRenderer;
+
+typedef IRenderer< void > Renderer;
+
+template < typename T >
+class ICamera;
+
+typedef ICamera< void > Camera;
+
+struct Frustum;
 
 class RenderingPipeline
 {
 public:
 
+	typedef Renderer*( *RendererResolver )( GameObjectID );
+
+	// Renderers are found through the spatial index rather than by walking every component. The
+	// resolver fetches the renderer back from its owner, as component addresses aren't stable.
+	// Grouped renderers are exact MeshRenderers, held in the MeshRenderer and Transform group. Returns
+	// the renderer's proxy, which stays put until it is removed.
+	static uint32_t AddRenderer( GameObjectID a_Owner, RendererResolver a_Resolver, bool a_Grouped );
+	static void RemoveRenderer( GameObjectID a_Owner, RendererResolver a_Resolver );
+
+	// Queues the renderers on a_Owner to have their bounds refreshed before the next frame.
+	static void InvalidateRenderer( GameObjectID a_Owner );
+
+	inline static const SpatialIndex& GetSpatialIndex()
+	{
+		return s_SpatialIndex;
+	}
+
+	// Renderers that passed culling in the last frame.
+	inline static uint32_t GetVisibleCount()
+	{
+		return s_VisibleCount;
+	}
+
+	// Draw calls issued in the last frame, counting each instanced draw once.
+	inline static uint32_t GetDrawCallCount()
+	{
+		return s_DrawCalls;
+	}
+
+	// Renderers that pass frustum culling are also tested against a depth buffer of the occluders
+	// in view. Only takes effect once some renderer is marked as an occluder.
+	inline static void SetOcclusionCulling( bool a_Enabled )
+	{
+		s_OcclusionCulling = a_Enabled;
+	}
+
+	inline static bool GetOcclusionCulling()
+	{
+		return s_OcclusionCulling;
+	}
+
+	inline static const OcclusionStats& GetOcclusionStats()
+	{
+		return s_OcclusionStats;
+	}
+
+	// The depth is held by the render graph, and only valid while the occlusion passes run.
+	inline static const OcclusionBuffer& GetOcclusionBuffer()
+	{
+		return s_OcclusionBuffer;
+	}
+
+	// The sun casts shadows while enabled and there is a main camera. Off by default, as none of the
+	// built in shaders sample the shadow map yet.
+	inline static void SetShadows( bool a_Enabled )
+	{
+		s_Shadows = a_Enabled;
+	}
+
+	inline static bool GetShadows()
+	{
+		return s_Shadows;
+	}
+
+	// Settings can be changed at any time. Shaders sample it during the forward pass, at any other
+	// time the depth is no longer held and everything is lit.
+	inline static ShadowMap& GetShadowMap()
+	{
+		return s_ShadowMap;
+	}
+
+	inline static const ShadowStats& GetShadowStats()
+	{
+		return s_ShadowStats;
+	}
+
+	// Culled MeshRenderers are collected by walking the MeshRenderer and Transform group once at least
+	// this fraction of it passes, reading both packed in lockstep. Below that they are looked up one at
+	// a time like other renderers. 0 always walks the group, anything above 1 never does.
+	inline static void SetGroupThreshold( float a_Fraction )
+	{
+		s_GroupThreshold = a_Fraction;
+	}
+
+	inline static float GetGroupThreshold()
+	{
+		return s_GroupThreshold;
+	}
+
+	// Passes run every frame. Features add theirs around the built in ones, which pass along the
+	// resources "VisibleSet", "DrawQueue" and "Backbuffer" in that order. "ShadowMap" is read by the
+	// forward pass.
+	inline static RenderGraph& GetRenderGraph()
+	{
+		return s_RenderGraph;
+	}
+
 private:
 
 	friend class CGE;
@@ -167,7 +286,82 @@ private:
 	//	}
 	//}
 	
-	inline static bool            s_Dirty;
+	struct RendererProxy
+	{
+		GameObjectID     Owner;
+		RendererResolver Resolve;
+		uint32_t         Node;
+		uint32_t         Next;
+		bool             Pending;
+		bool             Unbounded;
+		bool             StaticCaster;
+		bool             Occluder;
+		bool             Grouped;
+	};
+
+	static void UpdateSpatialIndex();
+	static void Invalidate( uint32_t a_Proxy );
+	static bool GetScreenSize( const RendererProxy& a_Proxy, float& o_ScreenSize );
+	static bool CollectRenderer( uint32_t a_Proxy, uint32_t a_Thread );
+	static bool WalkGroup( size_t a_Marked );
+	static void QueryVisible( const Frustum& a_Frustum );
+	static void FrustumCullPass( const RenderGraph& a_Graph );
+	static void OccluderPass( const RenderGraph& a_Graph );
+	static void OcclusionCullPass( const RenderGraph& a_Graph );
+	static void MarkCaster( uint32_t a_Proxy, uint32_t a_Cascade, bool a_Static );
+	static void CollectCaster( uint32_t a_Proxy, uint32_t a_Cascade );
+	static void ShadowPass( const RenderGraph& a_Graph );
+	static void CollectPass( const RenderGraph& a_Graph );
+	static void ForwardPass( const RenderGraph& a_Graph );
+
+	static constexpr size_t CollectBatchSize   = 64;
+	static constexpr size_t OcclusionBatchSize = 128;
+	static constexpr size_t PVMBatchSize       = 256;
+
+	inline static bool                                         s_Dirty;
+	inline static RenderQueue                                  s_Queue;
+	inline static std::vector< Matrix4 >                       s_Instances;
+	inline static SpatialIndex                                 s_SpatialIndex;
+	inline static std::vector< RendererProxy >                 s_Proxies;
+	inline static std::unordered_map< GameObjectID, uint32_t > s_ProxyLookup;
+	inline static std::vector< uint32_t >                      s_FreeProxies;
+	inline static std::vector< uint32_t >                      s_PendingProxies;
+	inline static std::vector< uint32_t >                      s_UnboundedProxies;
+	inline static std::vector< uint32_t >                      s_VisibleProxies;
+	inline static std::vector< uint32_t >                      s_GroupedProxies;
+	inline static std::vector< uint32_t >                      s_LookupProxies;
+	inline static std::vector< uint8_t >                       s_ProxyMarks;
+	inline static float                                        s_GroupThreshold = 0.25f;
+	inline static uint32_t                                     s_VisibleCount = 0;
+	inline static uint32_t                                     s_DrawCalls = 0;
+	inline static OcclusionBuffer                              s_OcclusionBuffer;
+	inline static OcclusionStats                               s_OcclusionStats;
+	inline static bool                                         s_OcclusionCulling = true;
+	inline static std::vector< uint8_t >                       s_OcclusionResults;
+	inline static std::vector< SpatialIndex::QueryNode >       s_Subtrees;
+	inline static std::vector< std::vector< uint32_t > >       s_SubtreeVisible;
+	inline static std::vector< std::vector< SpatialIndex::QueryNode > > s_ThreadStacks;
+	inline static std::vector< RenderQueue >                   s_ThreadQueues;
+	inline static std::vector< Matrix4 >                       s_PVMs;
+	inline static RenderGraph                                  s_RenderGraph;
+	inline static RenderGraph::ResourceID                      s_OcclusionDepth;
+	inline static RenderGraph::PassID                          s_FrustumCullPass;
+	inline static RenderGraph::PassID                          s_OccluderPass;
+	inline static RenderGraph::PassID                          s_OcclusionCullPass;
+	inline static ShadowMap                                    s_ShadowMap;
+	inline static ShadowStats                                  s_ShadowStats;
+	inline static bool                                         s_Shadows = false;
+	inline static std::vector< ShadowCaster >                  s_StaticCasters[ ShadowMap::MaxCascades ];
+	inline static std::vector< ShadowCaster >                  s_DynamicCasters[ ShadowMap::MaxCascades ];
+	inline static uint32_t                                     s_ShadowTriangles[ ShadowMap::MaxCascades ];
+	inline static RenderGraph::ResourceID                      s_ShadowDepth;
+	inline static RenderGraph::PassID                          s_ShadowPass;
+	inline static Matrix4                                      s_ProjectionView;
+	inline static Vector3                                      s_ViewPosition;
+	inline static Vector3                                      s_ViewForward;
+	inline static float                                        s_FarZ = 0.0f;
+	inline static float                                        s_LODScale = 1.0f;
+	inline static float                                        s_DeltaTime = 0.0f;
 	/*inline static const Mesh*     s_ActiveMesh;
 	inline static const Material* s_ActiveMaterial;
 	inline static const Matrix4*  s_ActiveModel;
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "Hash.hpp"
+
+class Mesh;
+class Material;
+class Texture2D;
+
+struct RenderingStats
+{
+	uint32_t BindsIssued    = 0;
+	uint32_t BindsSkipped   = 0;
+	uint32_t UploadsIssued  = 0;
+	uint32_t UploadsSkipped = 0;
+};
+
+// Tracks what the Rendering backend currently has bound so redundant binds and uniform uploads can
+// be skipped. Each Should* call returns true when the backend has to do the work, and records the new
+// state. Mesh, material and texture bindings are forgotten at the start of every frame, since their
+// contents may have changed in between. Uniform values live in the program and are kept until the
+// program is deleted.
+class RenderingState
+{
+public:
+
+	static constexpr uint32_t MaxTextureUnits  = 16;
+	static constexpr uint32_t MaxCachedUniform = 64;
+
+	static void BeginFrame()
+	{
+		s_LastFrame = s_Frame;
+		s_Frame = RenderingStats();
+		s_Mesh = nullptr;
+		s_Material = nullptr;
+
+		for ( auto& Texture : s_Textures )
+		{
+			Texture = nullptr;
+		}
+	}
+
+	static bool ShouldBindMesh( const Mesh* a_Mesh )
+	{
+		return Track( s_Mesh, a_Mesh );
+	}
+
+	static bool ShouldBindMaterial( const Material* a_Material )
+	{
+		return Track( s_Material, a_Material );
+	}
+
+	static bool ShouldBindProgram( uint32_t a_Program )
+	{
+		return Track( s_Program, a_Program );
+	}
+
+	static bool ShouldBindTexture( uint32_t a_Unit, const Texture2D* a_Texture )
+	{
+		if ( a_Unit >= MaxTextureUnits )
+		{
+			++s_Frame.BindsIssued;
+			return true;
+		}
+
+		return Track( s_Textures[ a_Unit ], a_Texture );
+	}
+
+	// Values larger than MaxCachedUniform bytes are always uploaded.
+	static bool ShouldUploadUniform( const char* a_Name, const void* a_Value, uint32_t a_Size )
+	{
+		if ( a_Size > MaxCachedUniform )
+		{
+			++s_Frame.UploadsIssued;
+			return true;
+		}
+
+		uint64_t Key = static_cast< uint64_t >( s_Program ) << 32 | CRC32_RT( a_Name );
+		CachedUniform& Cached = s_Uniforms[ Key ];
+
+		if ( Cached.Size == a_Size && std::memcmp( Cached.Value, a_Value, a_Size ) == 0 )
+		{
+			++s_Frame.UploadsSkipped;
+			return false;
+		}
+
+		Cached.Size = a_Size;
+		std::memcpy( Cached.Value, a_Value, a_Size );
+		++s_Frame.UploadsIssued;
+		return true;
+	}
+
+	static void ForgetProgram( uint32_t a_Program )
+	{
+		for ( auto Begin = s_Uniforms.begin(); Begin != s_Uniforms.end(); )
+		{
+			Begin = ( Begin->first >> 32 ) == a_Program ? s_Uniforms.erase( Begin ) : std::next( Begin );
+		}
+
+		if ( s_Program == a_Program )
+		{
+			s_Program = 0;
+		}
+	}
+
+	// Counters for the frame in progress.
+	inline static const RenderingStats& GetFrameStats()
+	{
+		return s_Frame;
+	}
+
+	// Counters for the last completed frame.
+	inline static const RenderingStats& GetLastFrameStats()
+	{
+		return s_LastFrame;
+	}
+
+private:
+
+	struct CachedUniform
+	{
+		uint32_t Size = 0;
+		uint8_t  Value[ MaxCachedUniform ];
+	};
+
+	template < typename T >
+	inline static bool Track( T& a_Current, T a_Next )
+	{
+		if ( a_Current == a_Next )
+		{
+			++s_Frame.BindsSkipped;
+			return false;
+		}
+
+		a_Current = a_Next;
+		++s_Frame.BindsIssued;
+		return true;
+	}
+
+	inline static const Mesh*                                   s_Mesh = nullptr;
+	inline static const Material*                               s_Material = nullptr;
+	inline static uint32_t                                      s_Program = 0;
+	inline static const Texture2D*                              s_Textures[ MaxTextureUnits ] = { nullptr };
+	inline static std::unordered_map< uint64_t, CachedUniform > s_Uniforms;
+	inline static RenderingStats                                s_Frame;
+	inline static RenderingStats                                s_LastFrame;
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include "Resource.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+
+struct ResidencyEntry
+{
+	enum class Type : uint8_t
+	{
+		MESH,
+		TEXTURE
+	};
+
+	// Backend object handles. Meshes use the vertex array followed by one buffer per attribute,
+	// textures only use the first.
+	uint32_t        Handles[ 7 ] = { 0 };
+	Type            ResourceType;
+	uint64_t        Key;
+	Hash            Name;
+	const Resource* Source;
+	uint32_t        Version;
+	size_t          Bytes;
+	uint64_t        LastUsed;
+};
+
+// Keeps backend buffers and textures for resources alive between draws. Entries are keyed by the
+// name hash of the resource, the same hash its ResourceHandle holds, and are re-uploaded only when
+// the resource object or its version changes. Releasing a resource drops its entries. Resources
+// without a name can't be tracked that way and are re-uploaded once per frame. When the total size
+// goes over the budget, entries not used this frame are evicted least recently used first.
+class Residency
+{
+public:
+
+	typedef void( *Releaser )( ResidencyEntry& );
+
+	static void Init( Releaser a_Releaser, size_t a_Budget = 256ull * 1024 * 1024 )
+	{
+		s_Releaser = a_Releaser;
+		s_Budget = a_Budget;
+		Resource::OnRelease() += Invalidate;
+	}
+
+	// Returns the entry for the resource, o_Upload is set if its contents have to be (re)uploaded.
+	static ResidencyEntry& Acquire( ResidencyEntry::Type a_Type, const Resource& a_Resource, size_t a_Bytes, bool& o_Upload )
+	{
+		Hash Name = a_Resource.GetName().HashCode();
+		uint64_t Key = static_cast< uint64_t >( a_Type ) << 62 ^ ( Name ? Name : reinterpret_cast< uintptr_t >( &a_Resource ) );
+		auto Iterator = s_Lookup.find( Key );
+
+		if ( Iterator == s_Lookup.end() )
+		{
+			s_Entries.emplace_front();
+			Iterator = s_Lookup.emplace( Key, s_Entries.begin() ).first;
+			ResidencyEntry& Entry = s_Entries.front();
+			Entry.ResourceType = a_Type;
+			Entry.Key = Key;
+			Entry.Name = Name;
+			Entry.Source = nullptr;
+			Entry.Bytes = 0;
+		}
+		else
+		{
+			s_Entries.splice( s_Entries.begin(), s_Entries, Iterator->second );
+		}
+
+		ResidencyEntry& Entry = *Iterator->second;
+		o_Upload = Entry.Source != &a_Resource || Entry.Version != a_Resource.GetVersion() || ( !Name && Entry.LastUsed != s_Frame );
+		Entry.LastUsed = s_Frame;
+
+		if ( o_Upload )
+		{
+			s_ResidentBytes += a_Bytes - Entry.Bytes;
+			Entry.Source = &a_Resource;
+			Entry.Version = a_Resource.GetVersion();
+			Entry.Bytes = a_Bytes;
+			++s_Uploads;
+			Evict();
+		}
+
+		return Entry;
+	}
+
+	static size_t GetSize( const Mesh& a_Mesh )
+	{
+		return
+			a_Mesh.m_Positions.size()  * sizeof( Vector3 ) +
+			a_Mesh.m_Texels[ 0 ].size() * sizeof( Vector2 ) +
+			a_Mesh.m_Colours[ 0 ].size() * sizeof( Vector4 ) +
+			a_Mesh.m_Normals.size()    * sizeof( Vector3 ) +
+			a_Mesh.m_Tangents.size()   * sizeof( Vector3 ) +
+			a_Mesh.m_Bitangents.size() * sizeof( Vector3 ) +
+			a_Mesh.m_Indices.size()    * sizeof( uint32_t );
+	}
+
+	static size_t GetSize( const Texture2D& a_Texture )
+	{
+		return static_cast< size_t >( a_Texture.GetWidth() ) * a_Texture.GetHeight() * sizeof( Colour );
+	}
+
+	// Drops all entries created from resources with the given name.
+	static void Invalidate( Hash a_Name )
+	{
+		for ( auto Iterator = s_Entries.begin(); Iterator != s_Entries.end(); )
+		{
+			Iterator = Iterator->Name == a_Name ? Release( Iterator ) : std::next( Iterator );
+		}
+	}
+
+	static void Clear()
+	{
+		while ( !s_Entries.empty() )
+		{
+			Release( s_Entries.begin() );
+		}
+	}
+
+	static void NextFrame()
+	{
+		++s_Frame;
+		s_Uploads = 0;
+		s_Evictions = 0;
+	}
+
+	inline static void SetBudget( size_t a_Bytes )
+	{
+		s_Budget = a_Bytes;
+		Evict();
+	}
+
+	inline static size_t GetBudget()
+	{
+		return s_Budget;
+	}
+
+	inline static size_t GetResidentBytes()
+	{
+		return s_ResidentBytes;
+	}
+
+	inline static size_t GetResidentCount()
+	{
+		return s_Entries.size();
+	}
+
+	// Uploads and evictions since the start of the frame.
+	inline static uint32_t GetUploads()
+	{
+		return s_Uploads;
+	}
+
+	inline static uint32_t GetEvictions()
+	{
+		return s_Evictions;
+	}
+
+private:
+
+	typedef std::list< ResidencyEntry >::iterator EntryIterator;
+
+	static void Evict()
+	{
+		while ( s_ResidentBytes > s_Budget && !s_Entries.empty() && s_Entries.back().LastUsed != s_Frame )
+		{
+			Release( std::prev( s_Entries.end() ) );
+			++s_Evictions;
+		}
+	}
+
+	static EntryIterator Release( EntryIterator a_Iterator )
+	{
+		ResidencyEntry& Entry = *a_Iterator;
+
+		if ( s_Releaser )
+		{
+			s_Releaser( Entry );
+		}
+
+		s_Lookup.erase( Entry.Key );
+		s_ResidentBytes -= Entry.Bytes;
+		return s_Entries.erase( a_Iterator );
+	}
+
+	inline static std::list< ResidencyEntry >                   s_Entries;
+	inline static std::unordered_map< uint64_t, EntryIterator > s_Lookup;
+	inline static Releaser                                      s_Releaser = nullptr;
+	inline static size_t                                        s_Budget = 0;
+	inline static size_t                                        s_ResidentBytes = 0;
+	inline static uint64_t                                      s_Frame = 0;
+	inline static uint32_t                                      s_Uploads = 0;
+	inline static uint32_t                                      s_Evictions = 0;
+};
@@ -1,10 +1,12 @@
 #pragma once
+#include <mutex>
 
 #include <entt/resource/cache.hpp>
 #include <entt/resource/loader.hpp>
 
 #include "ResourcePackage.hpp"
 #include "Name.hpp"
+#include "Delegate.hpp"
 
 // Need to add loading and unloading automatically.
 class Resource;
@@ -265,14 +267,36 @@ public:
 		m_Name = a_Name;
 	}
 
+	// Anything holding data derived from this resource, such as uploaded buffers, compares versions
+	// to know when it is out of date. Mutating accessors call it, fields edited directly, such as a
+	// Mesh's vertex arrays, need it called after.
+	inline void MarkModified()
+	{
+		++m_Version;
+	}
+
+	inline uint32_t GetVersion() const
+	{
+		return m_Version;
+	}
+
+	// Invoked with the name of every resource released from its cache.
+	inline static Delegate< void, Hash >& OnRelease()
+	{
+		return s_OnRelease;
+	}
+
 	static void Init()
 	{
 		s_ResourcePackage.Init( s_PackagePath );
 	}
 
+	// Caches are guarded, so handles can be assured from worker threads. A handle itself must only be
+	// used by one thread at a time.
 	template < typename T >
 	static ResourceHandle< T > Find( Hash a_Name )
 	{
+		std::lock_guard< std::recursive_mutex > Lock( s_Mutex );
 		auto& Cache = s_ResourceRepository.Get< T >();
 		return Cache.contains( a_Name ) ? ResourceHandle< T >{ a_Name, Cache[ a_Name ] } : ResourceHandle< T >{ 0, entt::resource< T >{} };
 	}
@@ -280,6 +304,7 @@ public:
 	template < typename T >
 	static ResourceHandle< T > Load( Hash a_Name )
 	{
+		std::lock_guard< std::recursive_mutex > Lock( s_Mutex );
 		auto& Cache = s_ResourceRepository.Get< T >();
 		return Cache.contains( a_Name ) ? ResourceHandle< T >{ a_Name, Cache[ a_Name ] } : ResourceHandle< T >{ a_Name, Cache.load( a_Name, a_Name ).first->second };
 	}
@@ -287,6 +312,7 @@ public:
 	template < typename T >
 	static bool Release( Hash a_Name )
 	{
+		std::lock_guard< std::recursive_mutex > Lock( s_Mutex );
 		auto& Cache = s_ResourceRepository.Get< T >();
 
 		if ( !Cache.contains( a_Name ) )
@@ -295,12 +321,14 @@ public:
 		}
 
 		Cache.erase( a_Name );
+		s_OnRelease( a_Name );
 		return true;
 	}
 
 	template < typename T >
 	inline static bool IsLoaded( Hash a_Name )
 	{
+		std::lock_guard< std::recursive_mutex > Lock( s_Mutex );
 		return s_ResourceRepository.Get< T >().contains( a_Name );
 	}
 
@@ -335,9 +363,12 @@ private:
 		a_Sizer & m_Name;
 	}
 
-	Name m_Name;
+	Name     m_Name;
+	uint32_t m_Version = 0;
 
-	inline static std::string        s_PackagePath = "./Resources/resource.package";
-	inline static ResourcePackage    s_ResourcePackage;
-	inline static ResourceRepository s_ResourceRepository;
+	inline static std::string            s_PackagePath = "./Resources/resource.package";
+	inline static ResourcePackage        s_ResourcePackage;
+	inline static ResourceRepository     s_ResourceRepository;
+	inline static Delegate< void, Hash > s_OnRelease;
+	inline static std::recursive_mutex   s_Mutex;
 };
\ No newline at end of file
@@ -8,12 +8,7 @@ public:
 
 	static void Tick()
 	{
-		auto AllTransforms = Component::GetExactComponents< Transform >();
-
-		for ( auto Transform : AllTransforms )
-		{
-			Transform->UpdateTransform();
-		}
+		Transform::UpdateTransforms();
 	}
 
 };
\ No newline at end of file
@@ -1,6 +1,50 @@
 #pragma once
+#include <chrono>
+#include <vector>
+#include <cstring>
 #include "Rect.hpp"
 #include "PixelColourMap.hpp"
+#include "TripleBuffer.hpp"
+
+enum class PresentMode : uint8_t
+{
+    LATEST, // A newer frame replaces one that has not been presented yet.
+    FIFO    // Frames are presented in order, a frame submitted while one is pending is dropped.
+};
+
+// Columns of a single row that have been written since the previous submit.
+struct DirtySpan
+{
+    short Left;
+    short Right;
+
+    inline bool IsEmpty() const
+    {
+        return Left > Right;
+    }
+
+    inline void Include( short a_Left, short a_Right )
+    {
+        Left = a_Left < Left ? a_Left : Left;
+        Right = a_Right > Right ? a_Right : Right;
+    }
+
+    inline void Reset( short a_Width )
+    {
+        Left = a_Width;
+        Right = -1;
+    }
+};
+
+struct ScreenFrame
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    Pixel*            Pixels = nullptr;
+    DirtySpan*        Dirty = nullptr;
+    Clock::time_point Submitted;
+    uint64_t          Index = 0;
+};
 
 class ScreenBuffer
 {
@@ -8,10 +52,30 @@ public:
 
     void Initialize( Vector< short, 2 > a_BufferSize )
     {
-        m_FrontBuffer = new Pixel[ static_cast< size_t >( a_BufferSize.x ) * a_BufferSize.y ];
-        m_BackBuffer = new Pixel[ static_cast< size_t >( a_BufferSize.x ) * a_BufferSize.y ];;
+        for ( uint8_t i = 0; i < 3; ++i )
+        {
+            m_Frames[ i ].Pixels = new Pixel[ static_cast< size_t >( a_BufferSize.x ) * a_BufferSize.y ];
+            m_Frames[ i ].Dirty = new DirtySpan[ a_BufferSize.y ];
+
+            for ( short y = 0; y < a_BufferSize.y; ++y )
+            {
+                m_Frames[ i ].Dirty[ y ].Reset( a_BufferSize.x );
+            }
+        }
+
+        m_BackBuffer = m_Frames.Back().Pixels;
+        m_BackDirty = m_Frames.Back().Dirty;
+        m_PresentedBuffer = new Pixel[ static_cast< size_t >( a_BufferSize.x ) * a_BufferSize.y ];
         m_ColourBuffer = new Colour[ static_cast< size_t >( a_BufferSize.x ) * a_BufferSize.y ];
         m_Size = a_BufferSize;
+        m_RowHashes.assign( a_BufferSize.y, HashRow( m_Frames.Back().Pixels ) );
+        m_PendingHashes.assign( a_BufferSize.y, 0 );
+        m_RowFrames.assign( a_BufferSize.y, 0 );
+
+        // Slots start out with a blank image at index 0, the first frame is 1.
+        m_FrameIndex = 1;
+        m_PresentedIndex = 0;
+        m_PresentAll = true;
     }
 
     inline Pixel* GetPixelBuffer()
@@ -52,10 +116,20 @@ public:
     void SetPixel( Vector< short, 2 > a_Coord, Pixel a_Pixel )
     {
         m_BackBuffer[ a_Coord.y * m_Size.x + a_Coord.x ] = a_Pixel;
+        MarkDirty( a_Coord );
+    }
+
+    void SetPixel( Vector< short, 2 > a_Coord, Pixel a_Pixel, Colour a_Colour )
+    {
+        int Index = GetIndex( a_Coord );
+        m_BackBuffer[ Index ] = a_Pixel;
+        m_ColourBuffer[ Index ] = a_Colour;
+        MarkDirty( a_Coord );
     }
 
     void SetPixels( int a_Index, Pixel a_Pixel, short a_Count )
     {
+        MarkDirty( a_Index, a_Count );
         Pixel* PixelBegin = m_BackBuffer + a_Index;
 
         for ( ; a_Count > 0; --a_Count )
@@ -67,6 +141,7 @@ public:
 
     void SetPixels( Vector< short, 2 > a_Coord, Pixel a_Pixel, short a_Count )
     {
+        MarkDirty( GetIndex( a_Coord ), a_Count );
         Pixel* PixelBegin = m_BackBuffer + GetIndex( a_Coord );
 
         for ( ; a_Count > 0; --a_Count )
@@ -81,11 +156,13 @@ public:
         int Index = GetIndex( a_Coord );
         m_BackBuffer[ Index ] = PixelColourMap::Get().ConvertColour( a_Colour );
         m_ColourBuffer[ Index ] = a_Colour;
+        MarkDirty( a_Coord );
     }
 
     void SetColours( Vector< short, 2 > a_Coord, Colour a_Colour, short a_Count )
     {
         int Index = GetIndex( a_Coord );
+        MarkDirty( Index, a_Count );
         Pixel PixelToSet = PixelColourMap::Get().ConvertColour( a_Colour );
         Pixel* PixelBegin = m_BackBuffer + Index;
         Colour* ColourBegin = m_ColourBuffer + Index;
@@ -101,6 +178,7 @@ public:
 
     void SetColours( int a_Index, Colour a_Colour, short a_Count )
     {
+        MarkDirty( a_Index, a_Count );
         Pixel PixelToSet = PixelColourMap::Get().ConvertColour( a_Colour );
         Pixel* PixelBegin = m_BackBuffer + a_Index;
         Colour* ColourBegin = m_ColourBuffer + a_Index;
@@ -150,9 +228,115 @@ public:
         }
     }
 
-    void SwapPixelBuffer()
+    inline void MarkDirty( Vector< short, 2 > a_Coord )
+    {
+        m_BackDirty[ a_Coord.y ].Include( a_Coord.x, a_Coord.x );
+    }
+
+    // Marks a run of a_Count pixels starting at a_Index, wrapping onto following rows.
+    void MarkDirty( int a_Index, int a_Count )
+    {
+        if ( a_Count <= 0 )
+        {
+            return;
+        }
+
+        int Last = a_Index + a_Count - 1;
+        short FirstRow = static_cast< short >( a_Index / m_Size.x );
+        short LastRow = static_cast< short >( Last / m_Size.x );
+        short FirstColumn = static_cast< short >( a_Index % m_Size.x );
+        short LastColumn = static_cast< short >( Last % m_Size.x );
+
+        if ( FirstRow == LastRow )
+        {
+            m_BackDirty[ FirstRow ].Include( FirstColumn, LastColumn );
+            return;
+        }
+
+        m_BackDirty[ FirstRow ].Include( FirstColumn, m_Size.x - 1 );
+
+        for ( short y = FirstRow + 1; y < LastRow; ++y )
+        {
+            m_BackDirty[ y ].Include( 0, m_Size.x - 1 );
+        }
+
+        m_BackDirty[ LastRow ].Include( 0, LastColumn );
+    }
+
+    // For callers writing through GetPixelBuffer directly, which is not tracked.
+    inline void MarkDirty( const RectInt& a_Rect )
+    {
+        for ( int y = a_Rect.GetBottom(); y <= a_Rect.GetTop(); ++y )
+        {
+            m_BackDirty[ y ].Include( static_cast< short >( a_Rect.GetLeft() ), static_cast< short >( a_Rect.GetRight() ) );
+        }
+    }
+
+    // Hands the back buffer over to the presenting thread. Returns false if a frame was dropped,
+    // either the pending one (LATEST) or the one being submitted (FIFO).
+    bool SwapPixelBuffer( PresentMode a_PresentMode )
     {
-        std::swap( m_BackBuffer, m_FrontBuffer );
+        ScreenFrame& Frame = m_Frames.Back();
+        Frame.Submitted = ScreenFrame::Clock::now();
+        Frame.Index = m_FrameIndex;
+        const Pixel* Submitted = Frame.Pixels;
+
+        // Rows written to but holding what they held at the last submit are left out. A scene that is
+        // cleared and drawn the same again then copies and presents nothing. Hashes are only kept once
+        // the frame is taken, a refused frame is compared again on the next submit.
+        for ( short y = 0; y < m_Size.y; ++y )
+        {
+            if ( Frame.Dirty[ y ].IsEmpty() )
+            {
+                continue;
+            }
+
+            m_PendingHashes[ y ] = HashRow( Submitted + y * m_Size.x );
+
+            if ( m_PendingHashes[ y ] == m_RowHashes[ y ] )
+            {
+                Frame.Dirty[ y ].Reset( m_Size.x );
+            }
+        }
+
+        bool Presented = a_PresentMode == PresentMode::FIFO ? 
+            m_Frames.PublishQueued() : 
+            !m_Frames.PublishLatest();
+
+        // A refused FIFO frame stays in the back slot and its dirty rows carry over to the next submit.
+        if ( a_PresentMode == PresentMode::FIFO && !Presented )
+        {
+            return false;
+        }
+
+        for ( short y = 0; y < m_Size.y; ++y )
+        {
+            if ( !Frame.Dirty[ y ].IsEmpty() )
+            {
+                m_RowHashes[ y ] = m_PendingHashes[ y ];
+                m_RowFrames[ y ] = Frame.Index;
+            }
+        }
+
+        ++m_FrameIndex;
+
+        // The new back slot holds the image of an older frame. Only rows changed since then are copied
+        // over, so that the dirty rows of the next frame only describe what changes from this one.
+        ScreenFrame& Back = m_Frames.Back();
+
+        for ( short y = 0; y < m_Size.y; ++y )
+        {
+            if ( m_RowFrames[ y ] > Back.Index )
+            {
+                memcpy( Back.Pixels + y * m_Size.x, Submitted + y * m_Size.x, sizeof( Pixel ) * m_Size.x );
+            }
+
+            Back.Dirty[ y ].Reset( m_Size.x );
+        }
+
+        m_BackBuffer = Back.Pixels;
+        m_BackDirty = Back.Dirty;
+        return Presented;
     }
 
     inline Vector< short, 2 > GetCoordinate( int a_Index )
@@ -171,8 +355,104 @@ private:
 
     friend class ConsoleWindow;
 
-    Pixel*             m_BackBuffer;
-    Pixel*             m_FrontBuffer;
-    Colour*            m_ColourBuffer;
-    Vector< short, 2 > m_Size;
+    // FNV-1a over a row of pixels.
+    uint64_t HashRow( const Pixel* a_Row ) const
+    {
+        static_assert( sizeof( Pixel ) == sizeof( uint32_t ), "Pixel is expected to be a packed CHAR_INFO" );
+        uint64_t Hash = 14695981039346656037ull;
+
+        for ( short x = 0; x < m_Size.x; ++x )
+        {
+            uint32_t Value;
+            memcpy( &Value, a_Row + x, sizeof( Value ) );
+            Hash = ( Hash ^ Value ) * 1099511628211ull;
+        }
+
+        return Hash;
+    }
+
+    // Presenting thread only. Returns the latest submitted frame, or nullptr if there is none.
+    const ScreenFrame* AcquireFrontBuffer()
+    {
+        return m_Frames.Acquire() ? &m_Frames.Front() : nullptr;
+    }
+
+    // Presenting thread only. Compares the dirty rows of a_Frame against what was last presented and
+    // returns the rectangles that actually changed. Consecutive changed rows are merged into one rect.
+    // If frames were dropped since the last present, every row is compared instead.
+    const std::vector< RectInt >& ResolveDirtyRects( const ScreenFrame& a_Frame )
+    {
+        m_DirtyRects.clear();
+
+        if ( m_PresentAll )
+        {
+            memcpy( m_PresentedBuffer, a_Frame.Pixels, sizeof( Pixel ) * m_Size.x * m_Size.y );
+            m_DirtyRects.emplace_back( 0, 0, m_Size.x, m_Size.y );
+            m_PresentedIndex = a_Frame.Index;
+            m_PresentAll = false;
+            return m_DirtyRects;
+        }
+
+        bool CheckAll = a_Frame.Index != m_PresentedIndex + 1;
+        int RectTop = -1;
+        short RectLeft = 0;
+        short RectRight = 0;
+
+        for ( short y = 0; y < m_Size.y; ++y )
+        {
+            DirtySpan Span = CheckAll ? DirtySpan{ 0, static_cast< short >( m_Size.x - 1 ) } : a_Frame.Dirty[ y ];
+            const Pixel* Row = a_Frame.Pixels + y * m_Size.x;
+            Pixel* Presented = m_PresentedBuffer + y * m_Size.x;
+
+            while ( !Span.IsEmpty() && Row[ Span.Left ] == Presented[ Span.Left ] ) ++Span.Left;
+            while ( !Span.IsEmpty() && Row[ Span.Right ] == Presented[ Span.Right ] ) --Span.Right;
+
+            if ( Span.IsEmpty() )
+            {
+                if ( RectTop >= 0 )
+                {
+                    m_DirtyRects.emplace_back( RectLeft, RectTop, RectRight - RectLeft + 1, y - RectTop );
+                    RectTop = -1;
+                }
+
+                continue;
+            }
+
+            memcpy( Presented + Span.Left, Row + Span.Left, sizeof( Pixel ) * ( Span.Right - Span.Left + 1 ) );
+
+            if ( RectTop < 0 )
+            {
+                RectTop = y;
+                RectLeft = Span.Left;
+                RectRight = Span.Right;
+            }
+            else
+            {
+                RectLeft = Span.Left < RectLeft ? Span.Left : RectLeft;
+                RectRight = Span.Right > RectRight ? Span.Right : RectRight;
+            }
+        }
+
+        if ( RectTop >= 0 )
+        {
+            m_DirtyRects.emplace_back( RectLeft, RectTop, RectRight - RectLeft + 1, m_Size.y - RectTop );
+        }
+
+        m_PresentedIndex = a_Frame.Index;
+        return m_DirtyRects;
+    }
+
+    Pixel*                      m_BackBuffer;
+    DirtySpan*                  m_BackDirty;
+    Pixel*                      m_PresentedBuffer;
+    std::vector< RectInt >      m_DirtyRects;
+    std::vector< uint64_t >     m_RowHashes;
+    std::vector< uint64_t >     m_PendingHashes;
+    std::vector< uint64_t >     m_RowFrames;
+    uint64_t                    m_PresentedIndex;
+    bool                        m_PresentAll;
+    Colour*                     m_ColourBuffer;
+    TripleBuffer< ScreenFrame > m_Frames;
+    uint64_t                    m_FrameIndex;
+    Vector< short, 2 >          m_Size;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Shader.hpp"
 #include "Pointer.hpp"
+#include "Rendering.hpp"
 #include "Implementation/Shader/ConsoleGLShader.hpp"
 #include "Implementation/Shader/OpenGLShader.hpp"
 
@@ -67,6 +68,7 @@ Shared< Shader > Shader::Create( const std::string& a_Source )
 		return nullptr;
 	}
 
+	Loaded->m_Source = a_Source;
 	Loaded->m_P = nullptr;
 	Loaded->m_V = nullptr;
 	Loaded->m_M = nullptr;
@@ -106,6 +108,45 @@ bool Shader::Decompile()
 	m_Inputs.clear();
 }
 
+const Shader* Shader::Diffuse = []()
+{
+	static Shared< Shader > Diffuse = Shader::Create( "API: ConsoleGL VERTEX: Vertex_Instanced_Diffuse FRAGMENT: Fragment_Instanced_Diffuse" );
+	Diffuse->m_Instanced = true;
+	return Diffuse.get();
+}();
+
+// Instanced diffuse. The model matrix comes in per instance, one row per attribute from
+// Rendering::InstanceModelLocation, and u_PV is set once for the whole draw.
+DefineShader( Vertex_Instanced_Diffuse )
+{
+	Uniform( Matrix4, u_PV );
+	Attribute( 0, Vector3, a_Position );
+	Attribute( 1, Vector2, a_Texel );
+	Attribute( Rendering::InstanceModelLocation,     Vector4, a_Model0 );
+	Attribute( Rendering::InstanceModelLocation + 1, Vector4, a_Model1 );
+	Attribute( Rendering::InstanceModelLocation + 2, Vector4, a_Model2 );
+	Attribute( Rendering::InstanceModelLocation + 3, Vector4, a_Model3 );
+	Varying_Out( Vector2, Texel );
+
+	Matrix4 Model;
+	Model.GetRow( 0 ) = a_Model0;
+	Model.GetRow( 1 ) = a_Model1;
+	Model.GetRow( 2 ) = a_Model2;
+	Model.GetRow( 3 ) = a_Model3;
+
+	Texel = a_Texel;
+	ConsoleGL::Position = Math::Multiply( u_PV, Math::Multiply( Model, Vector4( a_Position, 1.0f ) ) );
+}
+
+DefineShader( Fragment_Instanced_Diffuse )
+{
+	Uniform( ConsoleGL::Sampler2D, texture_diffuse );
+	Uniform( float, u_LODFade );
+	Varying_In( Vector2, Texel );
+
+	ConsoleGL::FragColour = ConsoleGL::Sample( texture_diffuse, Texel ) * u_LODFade;
+}
+
 void Shader::AddShaderInput( const Name& a_Name ) const
 {
 	const_cast< Shader* >( this )->m_Inputs.emplace_back( *this, m_Inputs.size(), a_Name );
@@ -225,9 +266,11 @@ void Shader::AddShaderInput( const Name& a_Name ) const
 //	Attribute( 0, Vector3, a_Position );
 //	Attribute( 1, Vector2, a_Texel );
 //	Attribute( 3, Vector3, a_Normal );
+//	Varying_Out( Vector3, Pos );
 //	Varying_Out( Vector3, Normal );
 //	Varying_Out( Vector2, Texel );
 //	
+//	Pos = Math::Multiply( u_Model, Vector4( a_Position, 1.0f ) );
 //	Texel = a_Texel;
 //	Normal = Math::Multiply( u_Model, Vector4( a_Normal ) );
 //	ConsoleGL::Position = Math::Multiply( u_PVM, Vector4( a_Position, 1.0f ) );
@@ -254,12 +297,15 @@ void Shader::AddShaderInput( const Name& a_Name ) const
 //	Uniform( Vector3, u_SunDirection0 );
 //	Uniform( Vector3, u_SunAmbient0 );
 //	Uniform( ConsoleGL::Sampler2D, texture_diffuse );
+//	Varying_In( Vector3, Pos );
 //	Varying_In( Vector3, Normal );
 //	Varying_In( Vector2, Texel );
 //
 //	Vector4 diffuse_colour = ConsoleGL::Sample( texture_diffuse, Texel );
 //
-//	float Intensity = Math::Clamp( Math::Dot( -u_SunDirection0, Normal ), 0.5f, 1.0f );
+//	// Shadowed fragments keep the ambient floor.
+//	float Shadow = RenderingPipeline::GetShadowMap().Sample( Pos );
+//	float Intensity = Math::Max( Math::Clamp( Math::Dot( -u_SunDirection0, Normal ), 0.5f, 1.0f ) * Shadow, 0.5f );
 //	ConsoleGL::FragColour.x = Intensity * diffuse_colour.x * u_SunAmbient0.x;
 //	ConsoleGL::FragColour.y = Intensity * diffuse_colour.y * u_SunAmbient0.y;
 //	ConsoleGL::FragColour.z = Intensity * diffuse_colour.z * u_SunAmbient0.z;
@@ -85,6 +85,9 @@ public:
 
 	static Shared< Shader > Create( const std::string& a_Source );
 
+	// Textured, unlit and drawn instanced.
+	static const Shader* Diffuse;
+
 	Shader() = delete;
 	const std::string& GetSource() const { return m_Source; }
 	void SetSource( const std::string& a_Source ) { m_Source = a_Source; }
@@ -95,6 +98,10 @@ public:
 	ShaderIterator Begin() const { return ShaderIterator( GetInput( 0 ) ); }
 	ShaderIterator End() const { return ShaderIterator( GetInput( GetInputCount() ) ); }
 	bool SetPVM( const Matrix4& a_P, const Matrix4& a_V, const Matrix4& a_M ) const;
+
+	// Instanced shaders read the model matrix per instance from Rendering::InstanceModelLocation and
+	// u_PV in place of u_Model and u_PVM.
+	bool IsInstanced() const { return m_Instanced; }
 	bool Compile();
 	bool Decompile();
 	virtual RenderingAPI GetAPI() const = 0;
@@ -115,6 +122,7 @@ private:
 
 	std::string                m_Source;
 	std::vector< ShaderInput > m_Inputs;
+	bool                       m_Instanced = false;
 
 	const ShaderInput* m_P;
 	const ShaderInput* m_V;
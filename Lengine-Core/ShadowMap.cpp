@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cstring>
+
+#include "ShadowMap.hpp"
+
+ShadowMap::ShadowMap()
+	: m_Depth( nullptr )
+	, m_ViewPosition( Vector3::Zero )
+	, m_ViewForward( Vector3::Forward )
+	, m_Resolution( 256 )
+	, m_CascadeCount( 3 )
+	, m_Distance( 50.0f )
+	, m_SplitBlend( 0.75f )
+	, m_CasterDistance( 50.0f )
+	, m_DepthBias( 0.05f )
+	, m_StaticCaching( true )
+{
+	for ( Cascade& Target : m_Cascades )
+	{
+		Target.Matrix = Matrix4::Identity;
+		Target.StaticMatrix = Matrix4::Identity;
+		DepthRasterizer::LoadRows( Target.Matrix, Target.Rows );
+		Target.End = 0.0f;
+		Target.DepthScale = 1.0f;
+		Target.StaticValid = false;
+	}
+}
+
+void ShadowMap::SetResolution( uint32_t a_Resolution )
+{
+	a_Resolution = Math::Max( ( a_Resolution + 3u ) & ~3u, 4u );
+
+	if ( a_Resolution != m_Resolution )
+	{
+		m_Resolution = a_Resolution;
+		InvalidateStatic();
+	}
+}
+
+void ShadowMap::SetCascadeCount( uint32_t a_Count )
+{
+	m_CascadeCount = Math::Clamp( a_Count, 1u, MaxCascades );
+}
+
+void ShadowMap::SetStaticCaching( bool a_Enabled )
+{
+	m_StaticCaching = a_Enabled;
+
+	// Layers go stale while nothing is drawn into them.
+	if ( !a_Enabled )
+	{
+		InvalidateStatic();
+	}
+}
+
+void ShadowMap::InvalidateStatic()
+{
+	for ( Cascade& Target : m_Cascades )
+	{
+		Target.StaticValid = false;
+	}
+}
+
+void ShadowMap::Fit( const Vector3& a_LightDirection, const Vector3& a_ViewPosition, const Vector3& a_ViewForward, float a_FOV, float a_Aspect, float a_NearZ )
+{
+	m_ViewPosition = a_ViewPosition;
+	m_ViewForward = a_ViewForward;
+
+	// Light space axes. The helper axis is swapped when the sun points almost straight up or down.
+	Vector3 Forward = Math::Normalize( a_LightDirection );
+	Vector3 Helper = Math::Abs( Forward.y ) > 0.99f ? Vector3( 0.0f, 0.0f, 1.0f ) : Vector3( 0.0f, 1.0f, 0.0f );
+	Vector3 Right = Math::Normalize( Math::Cross( Helper, Forward ) );
+	Vector3 Up = Math::Cross( Forward, Right );
+
+	// A slice's corners lie Corner times its depth away from the view axis.
+	float TanY = Math::Tan( a_FOV * 0.5f );
+	float TanX = TanY * a_Aspect;
+	float Corner = TanX * TanX + TanY * TanY;
+	float Near = Math::Max( a_NearZ, 1e-3f );
+	float Far = Math::Max( m_Distance, Near * 2.0f );
+	float Start = Near;
+
+	for ( uint32_t i = 0; i < m_CascadeCount; ++i )
+	{
+		float Split = ( i + 1.0f ) / m_CascadeCount;
+		float End = Math::Lerp( m_SplitBlend, Near + ( Far - Near ) * Split, Near * Math::Pow( Far / Near, Split ) );
+
+		// Bounding sphere of the slice, so its size doesn't change as the view turns.
+		float Centre = Math::Min( End, ( Start + End ) * 0.5f * ( 1.0f + Corner ) );
+		float Radius = Math::Sqrt( Math::Max(
+			End * End * Corner + ( End - Centre ) * ( End - Centre ),
+			Start * Start * Corner + ( Start - Centre ) * ( Start - Centre ) ) );
+		Vector3 Position = a_ViewPosition + a_ViewForward * Centre;
+
+		// Snapped to texels on every axis. Depth is snapped as well, otherwise the static layer would
+		// go stale whenever the camera moves along the light.
+		float Texel = 2.0f * Radius / m_Resolution;
+		float X = Math::Floor( Math::Dot( Right, Position ) / Texel ) * Texel;
+		float Y = Math::Floor( Math::Dot( Up, Position ) / Texel ) * Texel;
+		float Z = Math::Floor( Math::Dot( Forward, Position ) / Texel ) * Texel;
+		float NearZ = Z - Radius - m_CasterDistance;
+		float DepthScale = 2.0f / ( Z + Radius - NearZ );
+		float InverseRadius = 1.0f / Radius;
+
+		Cascade& Target = m_Cascades[ i ];
+		Target.Matrix = Matrix4(
+			Right.x * InverseRadius, Up.x * InverseRadius, Forward.x * DepthScale, 0.0f,
+			Right.y * InverseRadius, Up.y * InverseRadius, Forward.y * DepthScale, 0.0f,
+			Right.z * InverseRadius, Up.z * InverseRadius, Forward.z * DepthScale, 0.0f,
+			-X * InverseRadius, -Y * InverseRadius, -NearZ * DepthScale - 1.0f, 1.0f );
+		Target.End = End;
+		Target.DepthScale = DepthScale;
+		DepthRasterizer::LoadRows( Target.Matrix, Target.Rows );
+		Start = End;
+	}
+}
+
+bool ShadowMap::IsStaticCached( uint32_t a_Cascade ) const
+{
+	const Cascade& Target = m_Cascades[ a_Cascade ];
+	return m_StaticCaching && Target.StaticValid && std::memcmp( &Target.StaticMatrix, &Target.Matrix, sizeof( Matrix4 ) ) == 0;
+}
+
+uint32_t ShadowMap::RenderCascade( uint32_t a_Cascade, float* a_Depth, const std::vector< ShadowCaster >& a_Static, const std::vector< ShadowCaster >& a_Dynamic )
+{
+	Cascade& Target = m_Cascades[ a_Cascade ];
+	size_t Texels = static_cast< size_t >( m_Resolution ) * m_Resolution;
+	uint32_t Triangles = 0;
+
+	if ( m_StaticCaching )
+	{
+		if ( !IsStaticCached( a_Cascade ) )
+		{
+			Target.Static.resize( Texels );
+			Target.Rasterizer.Begin( Target.Matrix, Target.Static.data(), m_Resolution, m_Resolution );
+
+			for ( const ShadowCaster& Caster : a_Static )
+			{
+				Triangles += Target.Rasterizer.Rasterize( *Caster.Mesh, Caster.Model );
+			}
+
+			Target.StaticMatrix = Target.Matrix;
+			Target.StaticValid = true;
+		}
+
+		std::copy( Target.Static.begin(), Target.Static.end(), a_Depth );
+		Target.Rasterizer.Begin( Target.Matrix, a_Depth, m_Resolution, m_Resolution, false );
+	}
+	else
+	{
+		Target.Rasterizer.Begin( Target.Matrix, a_Depth, m_Resolution, m_Resolution );
+
+		for ( const ShadowCaster& Caster : a_Static )
+		{
+			Triangles += Target.Rasterizer.Rasterize( *Caster.Mesh, Caster.Model );
+		}
+	}
+
+	for ( const ShadowCaster& Caster : a_Dynamic )
+	{
+		Triangles += Target.Rasterizer.Rasterize( *Caster.Mesh, Caster.Model );
+	}
+
+	return Triangles;
+}
+
+float ShadowMap::Sample( const Vector3& a_Position ) const
+{
+	if ( !m_Depth )
+	{
+		return 1.0f;
+	}
+
+	float ViewDepth = Math::Dot( a_Position - m_ViewPosition, m_ViewForward );
+	uint32_t Index = 0;
+
+	while ( Index < m_CascadeCount && ViewDepth > m_Cascades[ Index ].End )
+	{
+		++Index;
+	}
+
+	if ( Index == m_CascadeCount )
+	{
+		return 1.0f;
+	}
+
+	// Cascades are orthographic, w is always 1.
+	const Cascade& Target = m_Cascades[ Index ];
+	const float* Depth = m_Depth + static_cast< size_t >( m_Resolution ) * m_Resolution * Index;
+	float X = ( DepthRasterizer::TransformRow( Target.Rows, 0, a_Position ) * 0.5f + 0.5f ) * m_Resolution;
+	float Y = ( DepthRasterizer::TransformRow( Target.Rows, 1, a_Position ) * 0.5f + 0.5f ) * m_Resolution;
+	float Z = DepthRasterizer::TransformRow( Target.Rows, 2, a_Position ) - m_DepthBias * Target.DepthScale;
+	int32_t CentreX = static_cast< int32_t >( Math::Floor( X ) );
+	int32_t CentreY = static_cast< int32_t >( Math::Floor( Y ) );
+	int32_t Last = static_cast< int32_t >( m_Resolution ) - 1;
+	uint32_t Lit = 0;
+
+	for ( int32_t y = CentreY - 1; y <= CentreY + 1; ++y )
+	{
+		const float* Row = Depth + Math::Clamp( y, 0, Last ) * m_Resolution;
+
+		for ( int32_t x = CentreX - 1; x <= CentreX + 1; ++x )
+		{
+			Lit += Z <= Row[ Math::Clamp( x, 0, Last ) ];
+		}
+	}
+
+	return Lit / 9.0f;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.hpp"
+#include "DepthRasterizer.hpp"
+
+struct ShadowStats
+{
+	uint32_t Casters        = 0;
+	uint32_t StaticCasters  = 0;
+	uint32_t Triangles      = 0;
+	uint32_t CachedCascades = 0;
+	float    RasterizeTime  = 0.0f;
+};
+
+struct ShadowCaster
+{
+	const Mesh* Mesh;
+	Matrix4     Model;
+};
+
+// Cascaded depth maps for the sun. The camera's view is split into slices, each covered by one square
+// orthographic map along the light. Maps are drawn depth only by a DepthRasterizer, stacked one after
+// another in memory. Static casters are drawn into a layer per cascade that is kept across frames and
+// copied in before the dynamic casters, and is only redrawn once the cascade moves or is invalidated.
+class ShadowMap
+{
+public:
+
+	static constexpr uint32_t MaxCascades = 4;
+
+	ShadowMap();
+
+	// Rounded up to a multiple of four.
+	void SetResolution( uint32_t a_Resolution );
+
+	inline uint32_t GetResolution() const
+	{
+		return m_Resolution;
+	}
+
+	void SetCascadeCount( uint32_t a_Count );
+
+	inline uint32_t GetCascadeCount() const
+	{
+		return m_CascadeCount;
+	}
+
+	// View distance covered by the cascades.
+	inline void SetDistance( float a_Distance )
+	{
+		m_Distance = a_Distance;
+	}
+
+	inline float GetDistance() const
+	{
+		return m_Distance;
+	}
+
+	// Blends split distances from uniform at 0 to logarithmic at 1.
+	inline void SetSplitBlend( float a_Blend )
+	{
+		m_SplitBlend = a_Blend;
+	}
+
+	inline float GetSplitBlend() const
+	{
+		return m_SplitBlend;
+	}
+
+	// How far towards the sun past a cascade casters are still drawn.
+	inline void SetCasterDistance( float a_Distance )
+	{
+		m_CasterDistance = a_Distance;
+	}
+
+	inline float GetCasterDistance() const
+	{
+		return m_CasterDistance;
+	}
+
+	// Offset towards the sun in world units, to keep surfaces from shadowing themselves.
+	inline void SetDepthBias( float a_Bias )
+	{
+		m_DepthBias = a_Bias;
+	}
+
+	inline float GetDepthBias() const
+	{
+		return m_DepthBias;
+	}
+
+	// With caching off static casters are drawn every frame like any other.
+	void SetStaticCaching( bool a_Enabled );
+
+	inline bool GetStaticCaching() const
+	{
+		return m_StaticCaching;
+	}
+
+	// Floats taken by all cascades together.
+	inline size_t GetSize() const
+	{
+		return static_cast< size_t >( m_Resolution ) * m_Resolution * m_CascadeCount;
+	}
+
+	// Redraws the static layers of every cascade next frame.
+	void InvalidateStatic();
+
+	// Fits the cascades around slices of the view. Cascades are snapped to whole texels, so they don't
+	// shimmer and their static layers stay valid while the camera moves within a texel.
+	void Fit( const Vector3& a_LightDirection, const Vector3& a_ViewPosition, const Vector3& a_ViewForward, float a_FOV, float a_Aspect, float a_NearZ );
+
+	// Light space matrix of a cascade, with depth in [-1, 1] so a Frustum can be built from it.
+	inline const Matrix4& GetCascadeMatrix( uint32_t a_Cascade ) const
+	{
+		return m_Cascades[ a_Cascade ].Matrix;
+	}
+
+	// Whether a cascade can reuse its static layer this frame, so its static casters aren't needed.
+	bool IsStaticCached( uint32_t a_Cascade ) const;
+
+	// Draws a cascade into a_Depth, which holds GetResolution() squared floats. a_Static is only read
+	// when the cascade isn't cached. Separate cascades can be drawn from separate threads.
+	uint32_t RenderCascade( uint32_t a_Cascade, float* a_Depth, const std::vector< ShadowCaster >& a_Static, const std::vector< ShadowCaster >& a_Dynamic );
+
+	// Samples read from a_Depth, which holds every cascade drawn this frame. Null turns shadows off.
+	inline void SetDepth( const float* a_Depth )
+	{
+		m_Depth = a_Depth;
+	}
+
+	// Fraction of sunlight reaching a_Position, filtered over 3x3 texels. Positions past the last
+	// cascade are lit.
+	float Sample( const Vector3& a_Position ) const;
+
+private:
+
+	struct Cascade
+	{
+		Matrix4              Matrix;
+		Matrix4              StaticMatrix;
+		float                Rows[ 4 ][ 4 ];
+		float                End;
+		float                DepthScale;
+		bool                 StaticValid;
+		std::vector< float > Static;
+		DepthRasterizer      Rasterizer;
+	};
+
+	Cascade      m_Cascades[ MaxCascades ];
+	const float* m_Depth;
+	Vector3      m_ViewPosition;
+	Vector3      m_ViewForward;
+	uint32_t     m_Resolution;
+	uint32_t     m_CascadeCount;
+	float        m_Distance;
+	float        m_SplitBlend;
+	float        m_CasterDistance;
+	float        m_DepthBias;
+	bool         m_StaticCaching;
+};
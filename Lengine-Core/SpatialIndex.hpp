@@ -0,0 +1,457 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+// Dynamic AABB tree. Each leaf holds a proxy with a user value and bounds that are enlarged by a
+// margin, so small movements don't have to touch the tree. Inserts pick the sibling with the least
+// surface area cost, and the tree is kept balanced with rotations on the way back up. Nodes live in a
+// single array and are recycled through a free list, proxy ids are node indices.
+class SpatialIndex
+{
+public:
+
+	static constexpr uint32_t Null = uint32_t( -1 );
+
+	// Fat bounds are grown by this fraction of their size on every side.
+	static constexpr float Margin = 0.1f;
+
+	// A node still to be tested in a query, with the frustum planes its bounds may cross.
+	struct QueryNode
+	{
+		uint32_t Index;
+		uint8_t  Mask;
+	};
+
+	SpatialIndex()
+		: m_Root( Null )
+		, m_FreeList( Null )
+		, m_Count( 0 )
+	{ }
+
+	uint32_t Insert( const AABB& a_Bounds, uint32_t a_UserData )
+	{
+		uint32_t Proxy = AllocateNode();
+		Node& Leaf = m_Nodes[ Proxy ];
+		Leaf.Bounds = Fatten( a_Bounds );
+		Leaf.UserData = a_UserData;
+		Leaf.Height = 0;
+		InsertLeaf( Proxy );
+		++m_Count;
+		return Proxy;
+	}
+
+	void Remove( uint32_t a_Proxy )
+	{
+		RemoveLeaf( a_Proxy );
+		FreeNode( a_Proxy );
+		--m_Count;
+	}
+
+	// Returns true if the proxy had to be reinserted, false if the new bounds still fit.
+	bool Move( uint32_t a_Proxy, const AABB& a_Bounds )
+	{
+		if ( m_Nodes[ a_Proxy ].Bounds.Contains( a_Bounds ) )
+		{
+			return false;
+		}
+
+		RemoveLeaf( a_Proxy );
+		m_Nodes[ a_Proxy ].Bounds = Fatten( a_Bounds );
+		InsertLeaf( a_Proxy );
+		return true;
+	}
+
+	// Invokes a_Callback with the user value of every proxy touching the frustum. Subtrees fully inside
+	// are emitted without testing their children.
+	template < typename _Callback >
+	void Query( const Frustum& a_Frustum, _Callback&& a_Callback ) const
+	{
+		if ( m_Root != Null )
+		{
+			Query( a_Frustum, { m_Root, Frustum::AllPlanes }, m_Stack, a_Callback );
+		}
+	}
+
+	// Same as above for the subtree under a_Node, using a_Stack for traversal. Queries that don't
+	// share a stack can run on separate threads.
+	template < typename _Callback >
+	void Query( const Frustum& a_Frustum, QueryNode a_Node, std::vector< QueryNode >& a_Stack, _Callback&& a_Callback ) const
+	{
+		a_Stack.clear();
+		a_Stack.push_back( a_Node );
+
+		while ( !a_Stack.empty() )
+		{
+			QueryNode Entry = a_Stack.back();
+			a_Stack.pop_back();
+
+			const Node& Current = m_Nodes[ Entry.Index ];
+			uint8_t Mask = Entry.Mask;
+
+			if ( Mask )
+			{
+				Frustum::Containment Result = a_Frustum.Classify( Current.Bounds, Mask );
+
+				if ( Result == Frustum::Containment::OUTSIDE )
+				{
+					continue;
+				}
+			}
+
+			if ( Current.IsLeaf() )
+			{
+				a_Callback( Current.UserData );
+			}
+			else
+			{
+				a_Stack.push_back( { Current.Left, Mask } );
+				a_Stack.push_back( { Current.Right, Mask } );
+			}
+		}
+	}
+
+	// Splits a frustum query into at least a_Count subtrees where the tree allows, by testing it level
+	// by level from the root. Leaves reached on the way are passed to a_Callback, the untested subtrees
+	// left over are written to o_Subtrees.
+	template < typename _Callback >
+	void Split( const Frustum& a_Frustum, size_t a_Count, std::vector< QueryNode >& o_Subtrees, _Callback&& a_Callback ) const
+	{
+		o_Subtrees.clear();
+
+		if ( m_Root == Null )
+		{
+			return;
+		}
+
+		o_Subtrees.push_back( { m_Root, Frustum::AllPlanes } );
+
+		while ( !o_Subtrees.empty() && o_Subtrees.size() < a_Count )
+		{
+			m_Stack.swap( o_Subtrees );
+			o_Subtrees.clear();
+
+			for ( QueryNode Entry : m_Stack )
+			{
+				const Node& Current = m_Nodes[ Entry.Index ];
+
+				if ( Entry.Mask && a_Frustum.Classify( Current.Bounds, Entry.Mask ) == Frustum::Containment::OUTSIDE )
+				{
+					continue;
+				}
+
+				if ( Current.IsLeaf() )
+				{
+					a_Callback( Current.UserData );
+				}
+				else
+				{
+					o_Subtrees.push_back( { Current.Left, Entry.Mask } );
+					o_Subtrees.push_back( { Current.Right, Entry.Mask } );
+				}
+			}
+		}
+	}
+
+	// Invokes a_Callback with the user value of every proxy.
+	template < typename _Callback >
+	void QueryAll( _Callback&& a_Callback ) const
+	{
+		for ( const Node& Current : m_Nodes )
+		{
+			if ( Current.IsLeaf() && Current.Height == 0 )
+			{
+				a_Callback( Current.UserData );
+			}
+		}
+	}
+
+	inline uint32_t GetUserData( uint32_t a_Proxy ) const
+	{
+		return m_Nodes[ a_Proxy ].UserData;
+	}
+
+	inline const AABB& GetFatBounds( uint32_t a_Proxy ) const
+	{
+		return m_Nodes[ a_Proxy ].Bounds;
+	}
+
+	inline size_t Size() const
+	{
+		return m_Count;
+	}
+
+	inline int32_t GetHeight() const
+	{
+		return m_Root == Null ? 0 : m_Nodes[ m_Root ].Height;
+	}
+
+	void Clear()
+	{
+		m_Nodes.clear();
+		m_Root = Null;
+		m_FreeList = Null;
+		m_Count = 0;
+	}
+
+private:
+
+	struct Node
+	{
+		inline bool IsLeaf() const
+		{
+			return Left == Null;
+		}
+
+		AABB     Bounds;
+		uint32_t Parent;
+		uint32_t Left;
+		uint32_t Right;
+		uint32_t UserData;
+
+		// Leaves are 0, free nodes are -1.
+		int32_t  Height;
+	};
+
+	inline static AABB Fatten( const AABB& a_Bounds )
+	{
+		return a_Bounds.Expanded( ( a_Bounds.Max - a_Bounds.Min ) * Margin );
+	}
+
+	uint32_t AllocateNode()
+	{
+		uint32_t Index;
+
+		if ( m_FreeList != Null )
+		{
+			Index = m_FreeList;
+			m_FreeList = m_Nodes[ Index ].Parent;
+		}
+		else
+		{
+			Index = static_cast< uint32_t >( m_Nodes.size() );
+			m_Nodes.emplace_back();
+		}
+
+		Node& NewNode = m_Nodes[ Index ];
+		NewNode.Parent = Null;
+		NewNode.Left = Null;
+		NewNode.Right = Null;
+		NewNode.UserData = Null;
+		NewNode.Height = 0;
+		return Index;
+	}
+
+	void FreeNode( uint32_t a_Index )
+	{
+		Node& Freed = m_Nodes[ a_Index ];
+		Freed.Parent = m_FreeList;
+		Freed.Left = Null;
+		Freed.Height = -1;
+		m_FreeList = a_Index;
+	}
+
+	void InsertLeaf( uint32_t a_Leaf )
+	{
+		if ( m_Root == Null )
+		{
+			m_Root = a_Leaf;
+			m_Nodes[ a_Leaf ].Parent = Null;
+			return;
+		}
+
+		// Descend towards the cheapest sibling.
+		AABB LeafBounds = m_Nodes[ a_Leaf ].Bounds;
+		uint32_t Sibling = m_Root;
+
+		while ( !m_Nodes[ Sibling ].IsLeaf() )
+		{
+			const Node& Current = m_Nodes[ Sibling ];
+			float Area = Current.Bounds.GetSurfaceArea();
+			float CombinedArea = AABB::Merge( Current.Bounds, LeafBounds ).GetSurfaceArea();
+
+			// Cost of making a new parent for this node and the leaf, and the minimum cost pushed down
+			// to the children.
+			float Cost = 2.0f * CombinedArea;
+			float InheritanceCost = 2.0f * ( CombinedArea - Area );
+			float LeftCost = DescentCost( Current.Left, LeafBounds ) + InheritanceCost;
+			float RightCost = DescentCost( Current.Right, LeafBounds ) + InheritanceCost;
+
+			if ( Cost < LeftCost && Cost < RightCost )
+			{
+				break;
+			}
+
+			Sibling = LeftCost < RightCost ? Current.Left : Current.Right;
+		}
+
+		// Create a new parent for the sibling and the leaf.
+		uint32_t OldParent = m_Nodes[ Sibling ].Parent;
+		uint32_t NewParent = AllocateNode();
+		Node& Parent = m_Nodes[ NewParent ];
+		Parent.Parent = OldParent;
+		Parent.Bounds = AABB::Merge( LeafBounds, m_Nodes[ Sibling ].Bounds );
+		Parent.Height = m_Nodes[ Sibling ].Height + 1;
+		Parent.Left = Sibling;
+		Parent.Right = a_Leaf;
+		m_Nodes[ Sibling ].Parent = NewParent;
+		m_Nodes[ a_Leaf ].Parent = NewParent;
+
+		if ( OldParent == Null )
+		{
+			m_Root = NewParent;
+		}
+		else if ( m_Nodes[ OldParent ].Left == Sibling )
+		{
+			m_Nodes[ OldParent ].Left = NewParent;
+		}
+		else
+		{
+			m_Nodes[ OldParent ].Right = NewParent;
+		}
+
+		Refit( NewParent );
+	}
+
+	void RemoveLeaf( uint32_t a_Leaf )
+	{
+		if ( a_Leaf == m_Root )
+		{
+			m_Root = Null;
+			return;
+		}
+
+		uint32_t Parent = m_Nodes[ a_Leaf ].Parent;
+		uint32_t GrandParent = m_Nodes[ Parent ].Parent;
+		uint32_t Sibling = m_Nodes[ Parent ].Left == a_Leaf ? m_Nodes[ Parent ].Right : m_Nodes[ Parent ].Left;
+
+		// The sibling takes the place of the parent.
+		if ( GrandParent == Null )
+		{
+			m_Root = Sibling;
+			m_Nodes[ Sibling ].Parent = Null;
+			FreeNode( Parent );
+			return;
+		}
+
+		if ( m_Nodes[ GrandParent ].Left == Parent )
+		{
+			m_Nodes[ GrandParent ].Left = Sibling;
+		}
+		else
+		{
+			m_Nodes[ GrandParent ].Right = Sibling;
+		}
+
+		m_Nodes[ Sibling ].Parent = GrandParent;
+		FreeNode( Parent );
+		Refit( GrandParent );
+	}
+
+	float DescentCost( uint32_t a_Child, const AABB& a_LeafBounds ) const
+	{
+		const Node& Child = m_Nodes[ a_Child ];
+		float CombinedArea = AABB::Merge( Child.Bounds, a_LeafBounds ).GetSurfaceArea();
+		return Child.IsLeaf() ? CombinedArea : CombinedArea - Child.Bounds.GetSurfaceArea();
+	}
+
+	// Rebalances and refits bounds and heights from a_Index up to the root.
+	void Refit( uint32_t a_Index )
+	{
+		while ( a_Index != Null )
+		{
+			a_Index = Balance( a_Index );
+
+			Node& Current = m_Nodes[ a_Index ];
+			const Node& Left = m_Nodes[ Current.Left ];
+			const Node& Right = m_Nodes[ Current.Right ];
+			Current.Bounds = AABB::Merge( Left.Bounds, Right.Bounds );
+			Current.Height = 1 + Math::Max( Left.Height, Right.Height );
+			a_Index = Current.Parent;
+		}
+	}
+
+	// Rotates the taller child up if the node is out of balance. Returns the index of the node that
+	// now sits where a_Index was.
+	uint32_t Balance( uint32_t a_Index )
+	{
+		Node& A = m_Nodes[ a_Index ];
+
+		if ( A.IsLeaf() || A.Height < 2 )
+		{
+			return a_Index;
+		}
+
+		int32_t Difference = m_Nodes[ A.Right ].Height - m_Nodes[ A.Left ].Height;
+
+		if ( Difference > 1 )
+		{
+			return Rotate( a_Index, A.Right, A.Left, false );
+		}
+
+		if ( Difference < -1 )
+		{
+			return Rotate( a_Index, A.Left, A.Right, true );
+		}
+
+		return a_Index;
+	}
+
+	// Moves a_Up into the place of a_Index. The shorter grandchild of a_Up is handed down to a_Index.
+	uint32_t Rotate( uint32_t a_Index, uint32_t a_Up, uint32_t a_Stay, bool a_UpIsLeft )
+	{
+		Node& A = m_Nodes[ a_Index ];
+		Node& C = m_Nodes[ a_Up ];
+		uint32_t F = C.Left;
+		uint32_t G = C.Right;
+
+		C.Left = a_Index;
+		C.Parent = A.Parent;
+		A.Parent = a_Up;
+
+		if ( C.Parent == Null )
+		{
+			m_Root = a_Up;
+		}
+		else if ( m_Nodes[ C.Parent ].Left == a_Index )
+		{
+			m_Nodes[ C.Parent ].Left = a_Up;
+		}
+		else
+		{
+			m_Nodes[ C.Parent ].Right = a_Up;
+		}
+
+		// The taller grandchild stays with a_Up, the shorter one replaces a_Up under a_Index.
+		uint32_t Keep = m_Nodes[ F ].Height > m_Nodes[ G ].Height ? F : G;
+		uint32_t Give = Keep == F ? G : F;
+
+		C.Right = Keep;
+
+		if ( a_UpIsLeft )
+		{
+			A.Left = Give;
+		}
+		else
+		{
+			A.Right = Give;
+		}
+
+		m_Nodes[ Give ].Parent = a_Index;
+
+		const Node& Stay = m_Nodes[ a_Stay ];
+		A.Bounds = AABB::Merge( Stay.Bounds, m_Nodes[ Give ].Bounds );
+		A.Height = 1 + Math::Max( Stay.Height, m_Nodes[ Give ].Height );
+		C.Bounds = AABB::Merge( A.Bounds, m_Nodes[ Keep ].Bounds );
+		C.Height = 1 + Math::Max( A.Height, m_Nodes[ Keep ].Height );
+		return a_Up;
+	}
+
+	std::vector< Node >               m_Nodes;
+	uint32_t                          m_Root;
+	uint32_t                          m_FreeList;
+	size_t                            m_Count;
+	mutable std::vector< QueryNode >  m_Stack;
+};
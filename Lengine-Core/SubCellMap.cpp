@@ -0,0 +1,3 @@
+#include "SubCellMap.hpp"
+
+SubCellMap SubCellMap::s_Active;
\ No newline at end of file
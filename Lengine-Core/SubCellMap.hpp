@@ -0,0 +1,178 @@
+#pragma once
+#include <climits>
+#include "Colour.hpp"
+#include "Pixel.hpp"
+#include "PixelColourMap.hpp"
+
+// Resolves a block of colour samples into a single console cell. Every sample is first reduced to
+// one of the 16 console colours through a palette table, and the resulting combination of palette
+// indices is then looked up to get the glyph and foreground/background pair that reproduces it best.
+// Quadrant glyphs require a console font with block elements, the half block glyph is also present
+// in the raster Terminal font.
+class SubCellMap
+{
+public:
+
+	SubCellMap()
+		: m_PaletteMap( new uint8_t[ 32768 ] )
+		, m_QuadrantMap( new Pixel[ 65536 ] )
+		, m_Built( false )
+	{ }
+
+	~SubCellMap()
+	{
+		delete[] m_PaletteMap;
+		delete[] m_QuadrantMap;
+	}
+
+	static void Init()
+	{
+		if ( !s_Active.m_Built )
+		{
+			s_Active.Build();
+		}
+	}
+
+	void Build()
+	{
+		// Distance between all console colours.
+		int Distances[ 16 ][ 16 ];
+
+		for ( int i = 0; i < 16; ++i )
+		{
+			for ( int j = 0; j < 16; ++j )
+			{
+				Colour A = PixelColourMap::SeedColours[ i ];
+				Colour B = PixelColourMap::SeedColours[ j ];
+				Distances[ i ][ j ] = Math::LengthSqrd( Vector3Int( A.R - B.R, A.G - B.G, A.B - B.B ) );
+			}
+		}
+
+		// Nearest console colour for every 15 bit colour.
+		for ( int Index = 0; Index < 32768; ++Index )
+		{
+			Colour Sample(
+				static_cast< Colour::Channel >( ( ( Index       ) & 31 ) * 8 + 4 ),
+				static_cast< Colour::Channel >( ( ( Index >> 5  ) & 31 ) * 8 + 4 ),
+				static_cast< Colour::Channel >( ( ( Index >> 10 ) & 31 ) * 8 + 4 ) );
+
+			int MinDistSqrd = INT_MAX;
+
+			for ( int i = 0; i < 16; ++i )
+			{
+				Colour Seed = PixelColourMap::SeedColours[ i ];
+				int DistSqrd = Math::LengthSqrd( Vector3Int( Sample.R - Seed.R, Sample.G - Seed.G, Sample.B - Seed.B ) );
+
+				if ( DistSqrd < MinDistSqrd )
+				{
+					MinDistSqrd = DistSqrd;
+					m_PaletteMap[ Index ] = static_cast< uint8_t >( i );
+				}
+			}
+		}
+
+		// Best two colour split for every combination of four quadrant colours.
+		for ( int Key = 0; Key < 65536; ++Key )
+		{
+			uint8_t Samples[ 4 ] = {
+				static_cast< uint8_t >( ( Key       ) & 0xF ),
+				static_cast< uint8_t >( ( Key >> 4  ) & 0xF ),
+				static_cast< uint8_t >( ( Key >> 8  ) & 0xF ),
+				static_cast< uint8_t >( ( Key >> 12 ) & 0xF ) };
+
+			int MinError = INT_MAX;
+			uint8_t BestMask = 0, BestForeground = 0, BestBackground = 0;
+
+			for ( int f = 0; f < 4; ++f )
+			{
+				for ( int b = f; b < 4; ++b )
+				{
+					uint8_t Foreground = Samples[ f ], Background = Samples[ b ];
+					uint8_t Mask = 0;
+					int Error = 0;
+
+					for ( int s = 0; s < 4; ++s )
+					{
+						int ToForeground = Distances[ Samples[ s ] ][ Foreground ];
+						int ToBackground = Distances[ Samples[ s ] ][ Background ];
+
+						if ( ToForeground < ToBackground )
+						{
+							Mask |= 1u << s;
+							Error += ToForeground;
+						}
+						else
+						{
+							Error += ToBackground;
+						}
+					}
+
+					if ( Error < MinError )
+					{
+						MinError = Error;
+						BestMask = Mask;
+						BestForeground = Foreground;
+						BestBackground = Background;
+					}
+				}
+			}
+
+			Pixel& Cell = m_QuadrantMap[ Key ];
+			Cell.Unicode() = s_QuadrantGlyphs[ BestMask ];
+			Cell.SetForegroundColour( ConsoleColours[ BestForeground ] );
+			Cell.SetBackgroundColour( ConsoleColours[ BestBackground ] );
+		}
+
+		m_Built = true;
+	}
+
+	// One cell from a top and bottom sample.
+	inline Pixel ResolveHalf( Colour a_Top, Colour a_Bottom ) const
+	{
+		Pixel Cell;
+		Cell.Unicode() = L'\x2580'; // Upper half block
+		Cell.SetForegroundColour( ConsoleColours[ GetPaletteIndex( a_Top ) ] );
+		Cell.SetBackgroundColour( ConsoleColours[ GetPaletteIndex( a_Bottom ) ] );
+		return Cell;
+	}
+
+	// One cell from two samples of the top row and two samples of the bottom row.
+	inline Pixel ResolveQuadrant( const Colour* a_Top, const Colour* a_Bottom ) const
+	{
+		return m_QuadrantMap[
+			GetPaletteIndex( a_Top[ 0 ] ) |
+			GetPaletteIndex( a_Top[ 1 ] ) << 4 |
+			GetPaletteIndex( a_Bottom[ 0 ] ) << 8 |
+			GetPaletteIndex( a_Bottom[ 1 ] ) << 12 ];
+	}
+
+	inline uint8_t GetPaletteIndex( Colour a_Colour ) const
+	{
+		return m_PaletteMap[
+			( a_Colour.R >> 3 ) |
+			( a_Colour.G >> 3 ) << 5 |
+			( a_Colour.B >> 3 ) << 10 ];
+	}
+
+	static const SubCellMap& Get()
+	{
+		return s_Active;
+	}
+
+private:
+
+	// Indexed by a mask of the quadrants drawn in the foreground colour.
+	// Top left = 1, top right = 2, bottom left = 4, bottom right = 8.
+	static constexpr wchar_t s_QuadrantGlyphs[ 16 ] =
+	{
+		L' ',      L'\x2598', L'\x259D', L'\x2580',
+		L'\x2596', L'\x258C', L'\x259E', L'\x259B',
+		L'\x2597', L'\x259A', L'\x2590', L'\x259C',
+		L'\x2584', L'\x2599', L'\x259F', L'\x2588'
+	};
+
+	uint8_t*          m_PaletteMap;
+	Pixel*            m_QuadrantMap;
+	bool              m_Built;
+	static SubCellMap s_Active;
+};
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <chrono>
+
+#include "SystemScheduler.hpp"
+#include "TimingTable.hpp"
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::Exclusive()
+{
+	s_Systems[ m_System ].Exclusive = true;
+	s_Dirty = true;
+	return *this;
+}
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::MainThread()
+{
+	s_Systems[ m_System ].MainThread = true;
+	s_Dirty = true;
+	return *this;
+}
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::Read( const std::vector< size_t >& a_Types )
+{
+	for ( size_t Type : a_Types )
+	{
+		SystemScheduler::AddAccess( m_System, Type, false );
+	}
+
+	return *this;
+}
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::Write( const std::vector< size_t >& a_Types )
+{
+	for ( size_t Type : a_Types )
+	{
+		SystemScheduler::AddAccess( m_System, Type, true );
+	}
+
+	return *this;
+}
+
+SystemScheduler::SystemBuilder SystemScheduler::AddSystem( const std::string& a_Name, const SystemFunction& a_Function )
+{
+	s_Systems.push_back( { a_Name, a_Function, {}, {}, {}, true, false, false, 0.0f, 0 } );
+	s_Dirty = true;
+	return SystemBuilder( static_cast< SystemID >( s_Systems.size() - 1 ) );
+}
+
+SystemScheduler::SystemID SystemScheduler::FindSystem( const std::string& a_Name )
+{
+	for ( SystemID i = 0; i < s_Systems.size(); ++i )
+	{
+		if ( s_Systems[ i ].Name == a_Name )
+		{
+			return i;
+		}
+	}
+
+	return Null;
+}
+
+void SystemScheduler::SetSystemEnabled( SystemID a_System, bool a_Enabled )
+{
+	if ( s_Systems[ a_System ].Enabled != a_Enabled )
+	{
+		s_Systems[ a_System ].Enabled = a_Enabled;
+		s_Dirty = true;
+	}
+}
+
+void SystemScheduler::AddAccess( SystemID a_System, size_t a_Type, bool a_Write )
+{
+	std::vector< size_t >& Types = a_Write ? s_Systems[ a_System ].Writes : s_Systems[ a_System ].Reads;
+
+	if ( std::find( Types.begin(), Types.end(), a_Type ) == Types.end() )
+	{
+		Types.push_back( a_Type );
+	}
+
+	s_Dirty = true;
+}
+
+bool SystemScheduler::Conflicts( const SystemNode& a_First, const SystemNode& a_Second )
+{
+	if ( a_First.Exclusive || a_Second.Exclusive )
+	{
+		return true;
+	}
+
+	auto Uses = []( const SystemNode& a_System, size_t a_Type )
+	{
+		return std::find( a_System.Reads.begin(), a_System.Reads.end(), a_Type ) != a_System.Reads.end()
+			|| std::find( a_System.Writes.begin(), a_System.Writes.end(), a_Type ) != a_System.Writes.end();
+	};
+
+	for ( size_t Type : a_First.Writes )
+	{
+		if ( Uses( a_Second, Type ) )
+		{
+			return true;
+		}
+	}
+
+	for ( size_t Type : a_Second.Writes )
+	{
+		if ( Uses( a_First, Type ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SystemScheduler::Compile()
+{
+	s_Order.clear();
+
+	for ( SystemID i = 0; i < s_Systems.size(); ++i )
+	{
+		SystemNode& System = s_Systems[ i ];
+		System.Dependencies.clear();
+
+		if ( !System.Enabled )
+		{
+			continue;
+		}
+
+		// Every earlier conflict is waited on rather than only the latest in each chain, systems are few.
+		for ( SystemID Earlier : s_Order )
+		{
+			if ( Conflicts( s_Systems[ Earlier ], System ) )
+			{
+				System.Dependencies.push_back( Earlier );
+			}
+		}
+
+		s_Order.push_back( i );
+	}
+
+	s_Handles.resize( s_Systems.size() );
+	s_IsDeferred.resize( s_Systems.size() );
+	s_Dirty = false;
+}
+
+void SystemScheduler::Tick()
+{
+	if ( s_Dirty )
+	{
+		Compile();
+	}
+
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	// Main thread systems have no handle to wait on until they have run, so they and everything
+	// waiting on them, directly or not, are held back. The rest are scheduled up front.
+	s_Deferred.clear();
+
+	for ( SystemID System : s_Order )
+	{
+		const SystemNode& Node = s_Systems[ System ];
+		bool Deferred = Node.MainThread;
+
+		for ( SystemID Dependency : Node.Dependencies )
+		{
+			Deferred = Deferred || s_IsDeferred[ Dependency ];
+		}
+
+		s_IsDeferred[ System ] = Deferred;
+
+		if ( Deferred )
+		{
+			s_Deferred.push_back( System );
+		}
+		else
+		{
+			Schedule( System );
+		}
+	}
+
+	// In the order they were added, so every dependency has a handle by the time it is needed.
+	for ( SystemID System : s_Deferred )
+	{
+		if ( !s_Systems[ System ].MainThread )
+		{
+			Schedule( System );
+			continue;
+		}
+
+		for ( SystemID Dependency : s_Systems[ System ].Dependencies )
+		{
+			WorkerPool::Wait( s_Handles[ Dependency ] );
+		}
+
+		Run( System, WorkerPool::GetThreadIndex() );
+		s_Handles[ System ] = JobHandle();
+	}
+
+	for ( SystemID System : s_Order )
+	{
+		WorkerPool::Wait( s_Handles[ System ] );
+	}
+
+	s_FrameTime = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+}
+
+void SystemScheduler::Schedule( SystemID a_System )
+{
+	s_Waits.clear();
+
+	for ( SystemID Dependency : s_Systems[ a_System ].Dependencies )
+	{
+		s_Waits.push_back( s_Handles[ Dependency ] );
+	}
+
+	s_Handles[ a_System ] = WorkerPool::Schedule( [ a_System ]( uint32_t a_Thread ){ Run( a_System, a_Thread ); }, s_Waits );
+}
+
+void SystemScheduler::Run( SystemID a_System, uint32_t a_Thread )
+{
+	SystemNode& System = s_Systems[ a_System ];
+	auto Start = std::chrono::high_resolution_clock::now();
+	System.Function();
+	System.Time = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+	System.Thread = a_Thread;
+}
+
+void SystemScheduler::Describe( std::ostream& a_Stream )
+{
+	TimingTable Systems( a_Stream, "Systems" );
+
+	for ( SystemID s : s_Order )
+	{
+		const SystemNode& System = s_Systems[ s ];
+		Systems.Time( System.Name, System.Time ) << ", thread " << System.Thread;
+
+		for ( size_t i = 0; i < System.Dependencies.size(); ++i )
+		{
+			a_Stream << ( i == 0 ? ", after " : ", " ) << s_Systems[ System.Dependencies[ i ] ].Name;
+		}
+
+		a_Stream << std::endl;
+	}
+
+	Systems.Total();
+	Systems.Row( "Frame", s_FrameTime, "ms" ) << std::endl;
+
+	for ( const SystemNode& System : s_Systems )
+	{
+		if ( !System.Enabled )
+		{
+			a_Stream << "  " << System.Name << " (disabled)" << std::endl;
+		}
+	}
+}
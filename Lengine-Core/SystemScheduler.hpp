@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+#include "Component.hpp"
+#include "Invoker.hpp"
+#include "WorkerPool.hpp"
+
+// Systems declare the component types they read and write, and the scheduler runs them each frame on
+// the WorkerPool. Two systems conflict if either writes a type the other uses. Conflicting systems run
+// in the order they were added, the rest run at the same time. Conflicts are the only ordering, main
+// thread systems included.
+//
+// Declaring a component covers the types it derives from as well, apart from Component itself, so a
+// system reading Renderer waits on systems writing MeshRenderer. Types that aren't components, like
+// Time, can be declared as well and are matched as they are.
+class SystemScheduler
+{
+public:
+
+	typedef uint32_t SystemID;
+	typedef Action<> SystemFunction;
+
+	static constexpr uint32_t Null = uint32_t( -1 );
+
+	class SystemBuilder
+	{
+	public:
+
+		template < typename... _Types >
+		SystemBuilder& Read()
+		{
+			( AddAccess< _Types >( false ), ... );
+			return *this;
+		}
+
+		template < typename... _Types >
+		SystemBuilder& Write()
+		{
+			( AddAccess< _Types >( true ), ... );
+			return *this;
+		}
+
+		// Types by their typeid hash, for sets only known at runtime, like ComponentBase::GetComponentTypes.
+		SystemBuilder& Read( const std::vector< size_t >& a_Types );
+		SystemBuilder& Write( const std::vector< size_t >& a_Types );
+
+		// Exclusive systems conflict with every other, for systems that add or destroy components.
+		SystemBuilder& Exclusive();
+
+		// Runs the system on the thread calling Tick rather than on the WorkerPool. Systems that conflict
+		// with it wait on it as usual, the others are scheduled on the WorkerPool before it runs and
+		// overlap it.
+		SystemBuilder& MainThread();
+
+		inline operator SystemID() const
+		{
+			return m_System;
+		}
+
+	private:
+
+		friend class SystemScheduler;
+
+		SystemBuilder( SystemID a_System )
+			: m_System( a_System )
+		{ }
+
+		template < typename _Type >
+		void AddAccess( bool a_Write )
+		{
+			if constexpr ( std::is_base_of_v< ComponentBase, _Type > )
+			{
+				SystemScheduler::AddComponentAccess( m_System, static_cast< typename SystemScheduler::Trace< _Type >* >( nullptr ), a_Write );
+			}
+			else
+			{
+				SystemScheduler::AddAccess( m_System, typeid( _Type ).hash_code(), a_Write );
+			}
+		}
+
+		SystemID m_System;
+	};
+
+	static SystemBuilder AddSystem( const std::string& a_Name, const SystemFunction& a_Function );
+	static SystemID FindSystem( const std::string& a_Name );
+
+	// Disabled systems are left out as if they had never been added.
+	static void SetSystemEnabled( SystemID a_System, bool a_Enabled );
+
+	inline static bool IsSystemEnabled( SystemID a_System )
+	{
+		return s_Systems[ a_System ].Enabled;
+	}
+
+	// Rebuilds the dependencies if systems changed, then runs every enabled system and returns once
+	// they are all done.
+	static void Tick();
+
+	// Milliseconds a system took in the last Tick.
+	inline static float GetSystemTime( SystemID a_System )
+	{
+		return s_Systems[ a_System ].Time;
+	}
+
+	// Thread the system ran on in the last Tick.
+	inline static uint32_t GetSystemThread( SystemID a_System )
+	{
+		return s_Systems[ a_System ].Thread;
+	}
+
+	// Milliseconds the last Tick took from start to end.
+	inline static float GetFrameTime()
+	{
+		return s_FrameTime;
+	}
+
+	// Writes each system with the time it took in the last Tick, the thread it ran on and the systems
+	// it waited on.
+	static void Describe( std::ostream& a_Stream );
+
+private:
+
+	template < typename _Component >
+	using Trace = typename _Component::InheritanceTrace;
+
+	struct SystemNode
+	{
+		std::string             Name;
+		SystemFunction          Function;
+		std::vector< size_t >   Reads;
+		std::vector< size_t >   Writes;
+		std::vector< SystemID > Dependencies;
+		bool                    Enabled;
+		bool                    Exclusive;
+		bool                    MainThread;
+		float                   Time;
+		uint32_t                Thread;
+	};
+
+	// Every component derives from the root, counting it would make every pair of systems conflict.
+	template < typename _Root, typename... _Types >
+	static void AddComponentAccess( SystemID a_System, std::tuple< _Root, _Types... >*, bool a_Write )
+	{
+		if constexpr ( sizeof...( _Types ) == 0 )
+		{
+			AddAccess( a_System, typeid( _Root ).hash_code(), a_Write );
+		}
+		else
+		{
+			( AddAccess( a_System, typeid( _Types ).hash_code(), a_Write ), ... );
+		}
+	}
+
+	static void AddAccess( SystemID a_System, size_t a_Type, bool a_Write );
+	static bool Conflicts( const SystemNode& a_First, const SystemNode& a_Second );
+	static void Compile();
+	static void Schedule( SystemID a_System );
+	static void Run( SystemID a_System, uint32_t a_Thread );
+
+	inline static std::vector< SystemNode > s_Systems;
+	inline static std::vector< SystemID >   s_Order;
+	inline static std::vector< JobHandle >  s_Handles;
+	inline static std::vector< JobHandle >  s_Waits;
+	inline static std::vector< SystemID >   s_Deferred;
+	inline static std::vector< uint8_t >    s_IsDeferred;
+	inline static float                     s_FrameTime = 0.0f;
+	inline static bool                      s_Dirty = true;
+};
@@ -65,8 +65,10 @@ public:
 		return m_Size.y;
 	}
 
+	// Handing out the pixels counts as modifying them, so the texture is uploaded again.
 	inline Colour* GetData()
 	{
+		MarkModified();
 		return m_Data;
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 #include "Math.hpp"
 
 class Time
@@ -26,11 +27,48 @@ public:
 		return s_DeltaTime;
 	}
 
+	// Length of a fixed step in seconds. FixedUpdate should step by this rather than GetDeltaTime.
 	inline static float GetFixedTime()
 	{
 		return s_FixedTime;
 	}
 
+	inline static void SetFixedTime( float a_FixedTime )
+	{
+		s_FixedTime = Math::Max( a_FixedTime, 0.0001f );
+	}
+
+	// Most fixed steps taken in one frame. Frames needing more fall behind, and whatever is left over
+	// after another frame's worth of steps is dropped, so slow frames can't snowball into slower ones.
+	inline static uint32_t GetMaxFixedSteps()
+	{
+		return s_MaxFixedSteps;
+	}
+
+	inline static void SetMaxFixedSteps( uint32_t a_MaxFixedSteps )
+	{
+		s_MaxFixedSteps = Math::Max( a_MaxFixedSteps, 1u );
+	}
+
+	// Fixed steps taken this frame.
+	inline static uint32_t GetFixedSteps()
+	{
+		return s_FixedSteps;
+	}
+
+	// How far between the last fixed step and the next one this frame lies, from 0 to 1. Rendering can
+	// blend the previous and current simulated state by this.
+	inline static float GetFixedAlpha()
+	{
+		return s_FixedAlpha;
+	}
+
+	// Whether this frame needed more fixed steps than it was allowed.
+	inline static bool IsFallingBehind()
+	{
+		return s_FallingBehind;
+	}
+
 	inline static float GetFPS()
 	{
 		return 1.0f / s_AverageDeltaTime;
@@ -55,9 +93,26 @@ private:
 		s_AverageDeltaTime += s_DeltaTime * 0.01f;
 		DeltaTimeIndex = ++DeltaTimeIndex >= 100 ? 0 : DeltaTimeIndex;
 	}
+
+	// Adds the last frame's scaled time and returns how many fixed steps to take for it.
+	static uint32_t BeginFixedSteps()
+	{
+		s_FixedAccumulator += GetDeltaTime();
+		uint32_t Steps = static_cast< uint32_t >( s_FixedAccumulator / s_FixedTime );
+		s_FallingBehind = Steps > s_MaxFixedSteps;
+		s_FixedSteps = s_FallingBehind ? s_MaxFixedSteps : Steps;
+		s_FixedAccumulator = Math::Min( s_FixedAccumulator - s_FixedSteps * s_FixedTime, s_MaxFixedSteps * s_FixedTime );
+		s_FixedAlpha = Math::Min( s_FixedAccumulator / s_FixedTime, 1.0f );
+		return s_FixedSteps;
+	}
 	
-	inline static float s_TimeDilation     = 1.0f;
-	inline static float s_DeltaTime        = 0.0f;
-	inline static float s_FixedTime        = 0.01f;
-	inline static float s_AverageDeltaTime = 0.0f;
+	inline static float    s_TimeDilation     = 1.0f;
+	inline static float    s_DeltaTime        = 0.0f;
+	inline static float    s_FixedTime        = 0.01f;
+	inline static float    s_AverageDeltaTime = 0.0f;
+	inline static float    s_FixedAccumulator = 0.0f;
+	inline static float    s_FixedAlpha       = 0.0f;
+	inline static uint32_t s_MaxFixedSteps    = 5;
+	inline static uint32_t s_FixedSteps       = 0;
+	inline static bool     s_FallingBehind    = false;
 };
\ No newline at end of file
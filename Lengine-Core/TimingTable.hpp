@@ -0,0 +1,40 @@
+#pragma once
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+// Writes the aligned name and value rows that Describe functions print their timings in. Rows are left
+// open, so callers can append details before ending the line.
+class TimingTable
+{
+public:
+
+	TimingTable( std::ostream& a_Stream, const std::string& a_Title )
+		: m_Stream( a_Stream )
+	{
+		m_Stream << a_Title << std::endl;
+		m_Stream << std::fixed << std::setprecision( 3 );
+	}
+
+	std::ostream& Row( const std::string& a_Name, float a_Value, const char* a_Unit )
+	{
+		return m_Stream << "  " << std::left << std::setw( 24 ) << a_Name << std::right << std::setw( 10 ) << a_Value << " " << a_Unit;
+	}
+
+	// Rows written through Time are summed up by Total.
+	std::ostream& Time( const std::string& a_Name, float a_Milliseconds )
+	{
+		m_Total += a_Milliseconds;
+		return Row( a_Name, a_Milliseconds, "ms" );
+	}
+
+	void Total()
+	{
+		Row( "Total", m_Total, "ms" ) << std::endl;
+	}
+
+private:
+
+	std::ostream& m_Stream;
+	float         m_Total = 0.0f;
+};
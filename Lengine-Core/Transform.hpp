@@ -1,22 +1,21 @@
 #pragma once
 #include "Component.hpp"
 #include "Math.hpp"
-
-typedef uint32_t GameObjectID;
+#include "TransformStorage.hpp"
 
 DefineComponent( Transform, Component )
 {
 public:
 
 	ITransform()
-		: m_GlobalMatrix( Matrix4::Identity )
-		, m_LocalMatrix( Matrix4::Identity )
-		, m_LocalPosition( Vector3::Zero )
-		, m_LocalScale( Vector3::One )
-		, m_IsDirty( true )
-		, m_Parent( GameObjectID( -1 ) )
+		: m_Parent( GameObjectID( -1 ) )
 	{ }
 
+	void OnCreate()
+	{
+		TransformStorage::SetOwner( m_Slot, this->GetOwnerID() );
+	}
+
 	void OnDestroy()
 	{
 		if ( m_Parent != GameObjectID( -1 ) )
@@ -24,16 +23,20 @@ public:
 			DetachFromParent( false );
 		}
 
+		// Children are destroyed in the same flush, see CollectDescendants.
 		for ( Transform& ChildTransform : *this )
 		{
 			ChildTransform.m_Parent = GameObjectID( -1 );
-			Component::Destroy< Transform >( ChildTransform.GetOwnerID() );
+			TransformStorage::SetParent( ChildTransform.m_Slot, TransformStorage::Null );
 		}
+
+		// Handed back straight away, the component itself may be moved around before it is destroyed.
+		m_Slot.Release();
 	}
 
 	inline void SetDirty()
 	{
-		m_IsDirty = true;
+		TransformStorage::SetDirty( m_Slot );
 	}
 
 	inline Transform* GetParent()
@@ -101,386 +104,359 @@ public:
 
 	inline Vector3 GetLocalPosition() const
 	{
-		return m_LocalPosition;
+		return LocalPosition();
 	}
 
 	inline float GetLocalPositionX() const
 	{
-		return m_LocalPosition.x;
+		return LocalPosition().x;
 	}
 
 	inline float GetLocalPositionY() const
 	{
-		return m_LocalPosition.y;
+		return LocalPosition().y;
 	}
 
 	inline float GetLocalPositionZ() const
 	{
-		return m_LocalPosition.x;
+		return LocalPosition().z;
 	}
 
 	inline Quaternion GetLocalRotation() const
 	{
-		return m_LocalRotation;
+		return LocalRotation();
 	}
 
 	inline Vector3 GetLocalScale() const
 	{
-		return m_LocalScale;
+		return LocalScale();
 	}
 
 	inline float GetLocalScaleX() const
 	{
-		return m_LocalScale.x;
+		return LocalScale().x;
 	}
 
 	inline float GetLocalScaleY() const
 	{
-		return m_LocalScale.y;
+		return LocalScale().y;
 	}
 
 	inline float GetLocalScaleZ() const
 	{
-		return m_LocalScale.z;
+		return LocalScale().z;
 	}
 
 	inline void SetLocalPosition( const Vector3& a_Position )
 	{
-		m_LocalPosition = a_Position;
-		m_IsDirty = true;
+		LocalPosition() = a_Position;
+		SetDirty();
 	}
 
 	inline void SetLocalPositionX( float a_X )
 	{
-		m_LocalPosition.x = a_X;
-		m_IsDirty = true;
+		LocalPosition().x = a_X;
+		SetDirty();
 	}
 
 	inline void SetLocalPositionY( float a_Y )
 	{
-		m_LocalPosition.y = a_Y;
-		m_IsDirty = true;
+		LocalPosition().y = a_Y;
+		SetDirty();
 	}
 
 	inline void SetLocalPositionZ( float a_Z )
 	{
-		m_LocalPosition.z = a_Z;
-		m_IsDirty = true;
+		LocalPosition().z = a_Z;
+		SetDirty();
 	}
 
 	inline void SetLocalRotation( const Quaternion& a_Rotation )
 	{
-		m_LocalRotation = a_Rotation;
-		m_IsDirty = true;
+		LocalRotation() = a_Rotation;
+		SetDirty();
 	}
 
 	inline void SetLocalScale( const Vector3& a_Scale )
 	{
-		m_LocalScale = a_Scale;
-		m_IsDirty = true;
+		LocalScale() = a_Scale;
+		SetDirty();
 	}
 
 	inline void SetLocalScaleX( float a_X )
 	{
-		m_LocalScale.x = a_X;
-		m_IsDirty = true;
+		LocalScale().x = a_X;
+		SetDirty();
 	}
 
 	inline void SetLocalScaleY( float a_Y )
 	{
-		m_LocalScale.y = a_Y;
-		m_IsDirty = true;
+		LocalScale().y = a_Y;
+		SetDirty();
 	}
 
 	inline void SetLocalScaleZ( float a_Z )
 	{
-		m_LocalScale.z = a_Z;
-		m_IsDirty = true;
+		LocalScale().z = a_Z;
+		SetDirty();
 	}
 
 	inline Vector3 GetGlobalPosition() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslation( m_GlobalMatrix ) : m_LocalPosition;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslation( GlobalMatrix() ) : LocalPosition();
 	}
 
 	inline float GetGlobalPositionX() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationX( m_GlobalMatrix ) : m_LocalPosition.x;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationX( GlobalMatrix() ) : LocalPosition().x;
 	}
 
 	inline float GetGlobalPositionY() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationY( m_GlobalMatrix ) : m_LocalPosition.y;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationY( GlobalMatrix() ) : LocalPosition().y;
 	}
 
 	inline float GetGlobalPositionZ() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationZ( m_GlobalMatrix ) : m_LocalPosition.z;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractTranslationZ( GlobalMatrix() ) : LocalPosition().z;
 	}
 
 	inline Quaternion GetGlobalRotation() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractRotation( m_GlobalMatrix ) : m_LocalRotation;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractRotation( GlobalMatrix() ) : LocalRotation();
 	}
 
 	inline Vector3 GetGlobalScale() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScale( m_GlobalMatrix ) : m_LocalScale;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScale( GlobalMatrix() ) : LocalScale();
 	}
 
 	inline float GetGlobalScaleX() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleX( m_GlobalMatrix ) : m_LocalScale.x;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleX( GlobalMatrix() ) : LocalScale().x;
 	}
 
 	inline float GetGlobalScaleY() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleY( m_GlobalMatrix ) : m_LocalScale.y;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleY( GlobalMatrix() ) : LocalScale().y;
 	}
 
 	inline float GetGlobalScaleZ() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleZ( m_GlobalMatrix ) : m_LocalScale.z;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? Matrix4::ExtractScaleZ( GlobalMatrix() ) : LocalScale().z;
 	}
 
 	inline void SetGlobalPosition( const Vector3& a_Position )
 	{
-		Matrix4::SetTranslation( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Position );
+		Matrix4::SetTranslation( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Position );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalPosition = a_Position;
+			LocalPosition() = a_Position;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( Component::GetComponent< Transform >( m_Parent )->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalPosition = Matrix4::ExtractTranslation( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( Component::GetComponent< Transform >( m_Parent )->GlobalMatrix() ), GlobalMatrix() );
+			LocalPosition() = Matrix4::ExtractTranslation( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalPositionX( float a_X )
 	{
-		Matrix4::SetTranslationX( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_X );
+		Matrix4::SetTranslationX( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_X );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalPosition.x = a_X;
+			LocalPosition().x = a_X;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalPosition = Matrix4::ExtractTranslation( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalPosition() = Matrix4::ExtractTranslation( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalPositionY( float a_Y )
 	{
-		Matrix4::SetTranslationY( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Y );
+		Matrix4::SetTranslationY( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Y );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalPosition.y = a_Y;
+			LocalPosition().y = a_Y;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalPosition = Matrix4::ExtractTranslation( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalPosition() = Matrix4::ExtractTranslation( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalPositionZ( float a_Z )
 	{
-		Matrix4::SetTranslationZ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Z );
+		Matrix4::SetTranslationZ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Z );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalPosition.z = a_Z;
+			LocalPosition().z = a_Z;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalPosition = Matrix4::ExtractTranslation( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalPosition() = Matrix4::ExtractTranslation( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalRotation( const Quaternion& a_Rotation )
 	{
-		Matrix4::SetRotation( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Rotation );
+		Matrix4::SetRotation( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Rotation );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalRotation = a_Rotation;
+			LocalRotation() = a_Rotation;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalRotation = Matrix4::ExtractRotation( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalRotation() = Matrix4::ExtractRotation( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalScale( const Vector3& a_Scale )
 	{
-		Matrix4::SetScale( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Scale );
+		Matrix4::SetScale( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Scale );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalScale = a_Scale;
+			LocalScale() = a_Scale;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalScale = Matrix4::ExtractScale( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalScale() = Matrix4::ExtractScale( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalScaleX( float a_X )
 	{
-		Matrix4::SetScaleX( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_X );
+		Matrix4::SetScaleX( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_X );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalScale.x = a_X;
+			LocalScale().x = a_X;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalScale = Matrix4::ExtractScale( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalScale() = Matrix4::ExtractScale( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalScaleY( float a_Y )
 	{
-		Matrix4::SetScaleY( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Y );
+		Matrix4::SetScaleY( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Y );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalScale.y = a_Y;
+			LocalScale().y = a_Y;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalScale = Matrix4::ExtractScale( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalScale() = Matrix4::ExtractScale( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline void SetGlobalScaleZ( float a_Z )
 	{
-		Matrix4::SetScaleZ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix, a_Z );
+		Matrix4::SetScaleZ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix(), a_Z );
 		
 		if ( m_Parent == static_cast< GameObjectID >( -1 ) )
 		{
-			m_LocalScale.z = a_Z;
+			LocalScale().z = a_Z;
 		}
 		else
 		{
-			m_LocalMatrix = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->m_GlobalMatrix ), m_GlobalMatrix );
-			m_LocalScale = Matrix4::ExtractScale( m_LocalMatrix );
+			LocalMatrix() = Math::Multiply( Math::Inverse( GameObject::FindByID( m_Parent ).GetTransform()->GlobalMatrix() ), GlobalMatrix() );
+			LocalScale() = Matrix4::ExtractScale( LocalMatrix() );
 		}
 
-		for ( auto Child : m_Children )
-		{
-			GameObject::FindByID( Child ).GetTransform()->m_IsDirty = true;
-		}
+		SetDirty();
 	}
 
 	inline Vector3 GetLocalForward() const
 	{
-		return Math::Normalize( m_LocalMatrix.c2.ToVector3() );
+		return Math::Normalize( LocalMatrix().c2.ToVector3() );
 	}
 
 	inline Vector3 GetLocalBackward() const
 	{
-		return -Math::Normalize( m_LocalMatrix.c2.ToVector3() );
+		return -Math::Normalize( LocalMatrix().c2.ToVector3() );
 	}
 
 	inline Vector3 GetLocalRight() const
 	{
-		return Math::Normalize( m_LocalMatrix.c0.ToVector3() );
+		return Math::Normalize( LocalMatrix().c0.ToVector3() );
 	}
 
 	inline Vector3 GetLocalLeft() const
 	{
-		return -Math::Normalize( m_LocalMatrix.c0.ToVector3() );
+		return -Math::Normalize( LocalMatrix().c0.ToVector3() );
 	}
 
 	inline Vector3 GetLocalUp() const
 	{
-		return Math::Normalize( m_LocalMatrix.c1.ToVector3() );
+		return Math::Normalize( LocalMatrix().c1.ToVector3() );
 	}
 
 	inline Vector3 GetLocalDown() const
 	{
-		return -Math::Normalize( m_LocalMatrix.c1.ToVector3() );
+		return -Math::Normalize( LocalMatrix().c1.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalForward() const
 	{
-		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c2.ToVector3() );
+		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c2.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalBackward() const
 	{
-		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c2.ToVector3() );
+		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c2.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalRight() const
 	{
-		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c0.ToVector3() );
+		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c0.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalLeft() const
 	{
-		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c0.ToVector3() );
+		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c0.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalUp() const
 	{
-		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c1.ToVector3() );
+		return Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c1.ToVector3() );
 	}
 
 	inline Vector3 GetGlobalDown() const
 	{
-		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ).c1.ToVector3() );
+		return -Math::Normalize( ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ).c1.ToVector3() );
 	}
 
 	void SetLocalForward( const Vector3& a_Forward )
@@ -489,8 +465,8 @@ public:
 		Rotation.c0 = Math::Normalize( Math::Cross( Vector3::Up, a_Forward ) );
 		Rotation.c1 = Math::Normalize( Math::Cross( a_Forward, Rotation.c0.ToVector() ) );
 		Rotation.c2 = a_Forward;
-		m_LocalRotation = Quaternion::ToQuaternion( Rotation );
-		m_IsDirty = true;
+		LocalRotation() = Quaternion::ToQuaternion( Rotation );
+		SetDirty();
 	}
 
 	void SetLocalBackward( const Vector3& a_Backward )
@@ -499,8 +475,8 @@ public:
 		Rotation.c0 = Math::Normalize( Math::Cross( a_Backward, Vector3::Up ) );
 		Rotation.c1 = Math::Normalize( Math::Cross( Rotation.c0.ToVector(), a_Backward ) );
 		Rotation.c2 = -a_Backward;
-		m_LocalRotation = Quaternion::ToQuaternion( Rotation );
-		m_IsDirty = true;
+		LocalRotation() = Quaternion::ToQuaternion( Rotation );
+		SetDirty();
 	}
 
 	void SetLocalRight( const Vector3& a_Right )
@@ -509,8 +485,8 @@ public:
 		Rotation.c2 = Math::Normalize( Math::Cross( a_Right, Vector3::Up ) );
 		Rotation.c1 = Math::Normalize( Math::Cross( Rotation.c2.ToVector(), a_Right ) );
 		Rotation.c0 = a_Right;
-		m_LocalRotation = Quaternion::ToQuaternion( Rotation );
-		m_IsDirty = true;
+		LocalRotation() = Quaternion::ToQuaternion( Rotation );
+		SetDirty();
 	}
 
 	void SetLocalLeft( const Vector3& a_Left )
@@ -519,8 +495,8 @@ public:
 		Rotation.c2 = Math::Normalize( Math::Cross( Vector3::Up, a_Left ) );
 		Rotation.c1 = Math::Normalize( Math::Cross( a_Left, Rotation.c2.ToVector() ) );
 		Rotation.c0 = -a_Left;
-		m_LocalRotation = Quaternion::ToQuaternion( Rotation );
-		m_IsDirty = true;
+		LocalRotation() = Quaternion::ToQuaternion( Rotation );
+		SetDirty();
 	}
 
 	void SetGlobalForward( const Vector3& a_Forward )
@@ -562,52 +538,52 @@ public:
 
 	void TranslateLocal( const Vector3& a_Translation )
 	{
-		m_LocalPosition += a_Translation;
-		m_IsDirty = true;
+		LocalPosition() += a_Translation;
+		SetDirty();
 	}
 
 	void TranslateLocalX( float a_X )
 	{
-		m_LocalPosition.x += a_X;
-		m_IsDirty = true;
+		LocalPosition().x += a_X;
+		SetDirty();
 	}
 
 	void TranslateLocalY( float a_Y )
 	{
-		m_LocalPosition.y = a_Y;
-		m_IsDirty = true;
+		LocalPosition().y = a_Y;
+		SetDirty();
 	}
 
 	void TranslateLocalZ( float a_Z )
 	{
-		m_LocalPosition.z = a_Z;
-		m_IsDirty = true;
+		LocalPosition().z = a_Z;
+		SetDirty();
 	}
 
 	inline void TranslateGlobal( const Vector3& a_Translation )
 	{
-		SetGlobalPosition( a_Translation + Matrix4::ExtractTranslation( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ) );
+		SetGlobalPosition( a_Translation + Matrix4::ExtractTranslation( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ) );
 	}
 
 	inline void TranslateGlobalX( float a_X )
 	{
-		SetGlobalPositionX( a_X + Matrix4::ExtractTranslationX( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ) );
+		SetGlobalPositionX( a_X + Matrix4::ExtractTranslationX( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ) );
 	}
 
 	inline void TranslateGlobalY( float a_Y )
 	{
-		SetGlobalPositionY( a_Y + Matrix4::ExtractTranslationY( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ) );
+		SetGlobalPositionY( a_Y + Matrix4::ExtractTranslationY( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ) );
 	}
 
 	inline void TranslateGlobalZ( float a_Z )
 	{
-		SetGlobalPositionZ( a_Z + Matrix4::ExtractTranslationZ( m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix ) );
+		SetGlobalPositionZ( a_Z + Matrix4::ExtractTranslationZ( m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix() ) );
 	}
 
 	void RotateLocal( const Quaternion& a_Rotation )
 	{
-		m_LocalRotation = Quaternion::Concatenate( a_Rotation, m_LocalRotation );
-		m_IsDirty = true;
+		LocalRotation() = Quaternion::Concatenate( a_Rotation, LocalRotation() );
+		SetDirty();
 	}
 
 	inline void RotateGlobal( const Quaternion& a_Rotation )
@@ -655,14 +631,28 @@ public:
 		SetGlobalScaleZ( GetGlobalScaleZ() * a_Z );
 	}
 
+	// Interpolated Transforms are drawn between their state before and after the last fixed step, so
+	// movement done in FixedTick looks smooth at any frame rate. Their matrices, and those of their
+	// children, hold the blended state, while the position, rotation and scale getters return the
+	// latest simulated values.
+	inline void SetInterpolated( bool a_Interpolated )
+	{
+		TransformStorage::SetInterpolated( m_Slot, a_Interpolated );
+	}
+
+	inline bool IsInterpolated() const
+	{
+		return TransformStorage::IsInterpolated( m_Slot );
+	}
+
 	inline const Matrix4& GetGlobalMatrix() const
 	{
-		return m_Parent != static_cast< GameObjectID >( -1 ) ? m_GlobalMatrix : m_LocalMatrix;
+		return m_Parent != static_cast< GameObjectID >( -1 ) ? GlobalMatrix() : LocalMatrix();
 	}
 
 	inline const Matrix4& GetLocalMatrix() const
 	{
-		return m_LocalMatrix;
+		return LocalMatrix();
 	}
 
 private:
@@ -836,27 +826,84 @@ public:
 		return rend();
 	}
 
-	void UpdateTransform()
+	// Recomputes this transform and everything below it straight away, rather than in the next
+	// UpdateTransforms. They are still reported as moved then.
+	inline void UpdateTransform()
 	{
-		if ( m_IsDirty )
-		{
-			m_LocalMatrix = Matrix4::CreateTransform( m_LocalPosition, m_LocalRotation, m_LocalScale );
-			m_IsDirty = false;
-		}
+		TransformStorage::UpdateImmediate( m_Slot );
+	}
 
-		if ( m_Parent != GameObjectID( -1 ) )
-		{
-			m_GlobalMatrix = Math::Multiply( GetParent()->GetGlobalMatrix(), m_LocalMatrix );
-		}
+	// Recomputes the transforms changed since the last call and everything below them, a level of the
+	// hierarchy at a time. Transforms that haven't changed aren't visited at all.
+	inline static void UpdateTransforms()
+	{
+		TransformStorage::Update();
+	}
 
-		for ( auto Begin = m_Children.begin(), End = m_Children.end(); Begin != End; ++Begin )
-		{
-			Component::GetComponent< Transform >( *Begin )->UpdateTransform();
-		}
+	// Objects whose global matrix changed during the last Scene::Tick.
+	inline static const std::vector< GameObjectID >& GetMoved()
+	{
+		return TransformStorage::GetMoved();
+	}
+
+	// Number of parents above this transform.
+	inline uint32_t GetDepth() const
+	{
+		return TransformStorage::s_Depths[ m_Slot ];
 	}
 	
 private:
 
+	inline Matrix4& GlobalMatrix()
+	{
+		return TransformStorage::s_GlobalMatrices[ m_Slot ];
+	}
+
+	inline const Matrix4& GlobalMatrix() const
+	{
+		return TransformStorage::s_GlobalMatrices[ m_Slot ];
+	}
+
+	inline Matrix4& LocalMatrix()
+	{
+		return TransformStorage::s_LocalMatrices[ m_Slot ];
+	}
+
+	inline const Matrix4& LocalMatrix() const
+	{
+		return TransformStorage::s_LocalMatrices[ m_Slot ];
+	}
+
+	inline Vector3& LocalPosition()
+	{
+		return TransformStorage::s_LocalPositions[ m_Slot ];
+	}
+
+	inline const Vector3& LocalPosition() const
+	{
+		return TransformStorage::s_LocalPositions[ m_Slot ];
+	}
+
+	inline Quaternion& LocalRotation()
+	{
+		return TransformStorage::s_LocalRotations[ m_Slot ];
+	}
+
+	inline const Quaternion& LocalRotation() const
+	{
+		return TransformStorage::s_LocalRotations[ m_Slot ];
+	}
+
+	inline Vector3& LocalScale()
+	{
+		return TransformStorage::s_LocalScales[ m_Slot ];
+	}
+
+	inline const Vector3& LocalScale() const
+	{
+		return TransformStorage::s_LocalScales[ m_Slot ];
+	}
+
 	inline void SetParentImpl( Transform* a_Transform, bool a_RetainGlobalTransform, size_t a_ChildIndex = -1 )
 	{
 		GameObjectID ThisID = this->GetOwnerID();
@@ -868,8 +915,8 @@ private:
 
 			if ( a_RetainGlobalTransform )
 			{
-				m_LocalMatrix = m_GlobalMatrix;
-				Matrix4::Decompose( m_LocalMatrix, m_LocalPosition, m_LocalRotation, m_LocalScale );
+				LocalMatrix() = GlobalMatrix();
+				Matrix4::Decompose( LocalMatrix(), LocalPosition(), LocalRotation(), LocalScale() );
 			}
 
 			auto Where = a_ChildIndex == -1 ? std::find( ParentTransform->m_Children.begin(), ParentTransform->m_Children.end(), ThisID ) : ParentTransform->m_Children.begin() + a_ChildIndex;
@@ -881,8 +928,8 @@ private:
 		{
 			if ( a_RetainGlobalTransform )
 			{ 
-				m_LocalMatrix = Math::Multiply( Math::Inverse( a_Transform->GetGlobalMatrix() ), m_LocalMatrix );
-				Matrix4::Decompose( m_LocalMatrix, m_LocalPosition, m_LocalRotation, m_LocalScale );
+				LocalMatrix() = Math::Multiply( Math::Inverse( a_Transform->GetGlobalMatrix() ), LocalMatrix() );
+				Matrix4::Decompose( LocalMatrix(), LocalPosition(), LocalRotation(), LocalScale() );
 			}
 
 			a_Transform->m_Children.push_back( ThisID );
@@ -892,38 +939,51 @@ private:
 		{
 			m_Parent = static_cast< GameObjectID >( -1 );
 		}
+
+		TransformStorage::SetParent( m_Slot, a_Transform ? uint32_t( a_Transform->m_Slot ) : TransformStorage::Null );
+		SetDirty();
 	}
 
 	friend class ResourcePackager;
 	friend class Serialization;
 	friend class Prefab;
 	friend class Scene;
+	template < typename > friend class IComponent;
+
+	// Appends every descendant of the transforms in o_Transforms, walking the vector as it grows.
+	static void CollectDescendants( std::vector< entt::entity >& o_Transforms )
+	{
+		for ( size_t i = 0; i < o_Transforms.size(); ++i )
+		{
+			const Transform* Found = Component::GetExactComponent< Transform >( GameObjectID( o_Transforms[ i ] ) );
+
+			for ( GameObjectID Child : Found->m_Children )
+			{
+				o_Transforms.push_back( entt::entity( Child ) );
+			}
+		}
+	}
 
 	template < typename _Serializer >
 	void Serialize( _Serializer& a_Serializer ) const
 	{
-		a_Serializer << m_LocalPosition << m_LocalRotation << m_LocalScale;
+		a_Serializer << LocalPosition() << LocalRotation() << LocalScale();
 	}
 
 	template < typename _Deserializer >
 	void Deserialize( _Deserializer& a_Deserializer )
 	{
-		a_Deserializer >> m_LocalPosition >> m_LocalRotation >> m_LocalScale;
-		m_IsDirty = true;
+		a_Deserializer >> LocalPosition() >> LocalRotation() >> LocalScale();
+		TransformStorage::s_Dirty[ m_Slot ] = true;
 	}
 
 	template < typename _Sizer >
 	void SizeOf( _Sizer& a_Sizer ) const
 	{
-		a_Sizer & m_LocalPosition & m_LocalRotation & m_LocalScale;
+		a_Sizer & LocalPosition() & LocalRotation() & LocalScale();
 	}
 
-	Matrix4                     m_GlobalMatrix;
-	Matrix4                     m_LocalMatrix;
-	Vector3                     m_LocalPosition;
-	Quaternion                  m_LocalRotation;
-	Vector3                     m_LocalScale;
-	bool                        m_IsDirty;
+	TransformSlot               m_Slot;
 	GameObjectID                m_Parent;
 	std::vector< GameObjectID > m_Children;
 };
\ No newline at end of file
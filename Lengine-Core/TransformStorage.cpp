@@ -0,0 +1,383 @@
+#include <emmintrin.h>
+
+#include "TransformStorage.hpp"
+#include "WorkerPool.hpp"
+
+// Matrices are read and written as four rows of four floats.
+static_assert( sizeof( Matrix4 ) == 16 * sizeof( float ), "Matrix4 must be tightly packed" );
+
+uint32_t TransformStorage::Allocate()
+{
+	uint32_t Slot;
+
+	if ( !s_Free.empty() )
+	{
+		Slot = s_Free.back();
+		s_Free.pop_back();
+	}
+	else
+	{
+		Slot = static_cast< uint32_t >( s_Owners.size() );
+		s_LocalPositions.emplace_back();
+		s_LocalRotations.emplace_back();
+		s_LocalScales.emplace_back();
+		s_LocalMatrices.emplace_back();
+		s_GlobalMatrices.emplace_back();
+		s_Parents.emplace_back();
+		s_FirstChildren.emplace_back();
+		s_NextSiblings.emplace_back();
+		s_PreviousSiblings.emplace_back();
+		s_Depths.emplace_back();
+		s_Owners.emplace_back();
+		s_Dirty.emplace_back();
+		s_States.emplace_back();
+		s_Interpolated.emplace_back();
+		s_PreviousPositions.emplace_back();
+		s_PreviousRotations.emplace_back();
+		s_PreviousScales.emplace_back();
+	}
+
+	s_LocalPositions[ Slot ] = Vector3::Zero;
+	s_LocalRotations[ Slot ] = Quaternion();
+	s_LocalScales[ Slot ] = Vector3::One;
+	s_LocalMatrices[ Slot ] = Matrix4::Identity;
+	s_GlobalMatrices[ Slot ] = Matrix4::Identity;
+	s_Parents[ Slot ] = Null;
+	s_FirstChildren[ Slot ] = Null;
+	s_NextSiblings[ Slot ] = Null;
+	s_PreviousSiblings[ Slot ] = Null;
+	s_Depths[ Slot ] = 0;
+	s_Owners[ Slot ] = GameObjectID( -1 );
+	s_Dirty[ Slot ] = true;
+	s_States[ Slot ] = Idle;
+	s_Interpolated[ Slot ] = Null;
+	return Slot;
+}
+
+void TransformStorage::Free( uint32_t a_Slot )
+{
+	Unlink( a_Slot );
+	SetInterpolated( a_Slot, false );
+
+	while ( s_FirstChildren[ a_Slot ] != Null )
+	{
+		SetParent( s_FirstChildren[ a_Slot ], Null );
+	}
+
+	// Left in the queue, it is skipped once it is no longer marked as queued.
+	s_Owners[ a_Slot ] = GameObjectID( -1 );
+	s_States[ a_Slot ] = Idle;
+	s_Free.push_back( a_Slot );
+}
+
+void TransformStorage::Copy( uint32_t a_Source, uint32_t a_Destination )
+{
+	s_LocalPositions[ a_Destination ] = s_LocalPositions[ a_Source ];
+	s_LocalRotations[ a_Destination ] = s_LocalRotations[ a_Source ];
+	s_LocalScales[ a_Destination ] = s_LocalScales[ a_Source ];
+	s_LocalMatrices[ a_Destination ] = s_LocalMatrices[ a_Source ];
+	SetInterpolated( a_Destination, IsInterpolated( a_Source ) );
+	SetDirty( a_Destination );
+}
+
+void TransformStorage::SetOwner( uint32_t a_Slot, GameObjectID a_Owner )
+{
+	s_Owners[ a_Slot ] = a_Owner;
+	Queue( a_Slot );
+}
+
+void TransformStorage::SetParent( uint32_t a_Slot, uint32_t a_Parent )
+{
+	Unlink( a_Slot );
+
+	if ( a_Parent == Null )
+	{
+		SetDepth( a_Slot, 0 );
+		return;
+	}
+
+	uint32_t First = s_FirstChildren[ a_Parent ];
+	s_Parents[ a_Slot ] = a_Parent;
+	s_NextSiblings[ a_Slot ] = First;
+
+	if ( First != Null )
+	{
+		s_PreviousSiblings[ First ] = a_Slot;
+	}
+
+	s_FirstChildren[ a_Parent ] = a_Slot;
+	SetDepth( a_Slot, s_Depths[ a_Parent ] + 1 );
+}
+
+// s_Interpolated holds where the slot sits in s_InterpolatedSlots, or Null, so slots can be taken out
+// of the list by swapping the last one into their place.
+void TransformStorage::SetInterpolated( uint32_t a_Slot, bool a_Interpolated )
+{
+	if ( IsInterpolated( a_Slot ) == a_Interpolated )
+	{
+		return;
+	}
+
+	if ( a_Interpolated )
+	{
+		s_Interpolated[ a_Slot ] = static_cast< uint32_t >( s_InterpolatedSlots.size() );
+		s_InterpolatedSlots.push_back( a_Slot );
+		s_PreviousPositions[ a_Slot ] = s_LocalPositions[ a_Slot ];
+		s_PreviousRotations[ a_Slot ] = s_LocalRotations[ a_Slot ];
+		s_PreviousScales[ a_Slot ] = s_LocalScales[ a_Slot ];
+	}
+	else
+	{
+		uint32_t Last = s_InterpolatedSlots.back();
+		s_InterpolatedSlots[ s_Interpolated[ a_Slot ] ] = Last;
+		s_Interpolated[ Last ] = s_Interpolated[ a_Slot ];
+		s_InterpolatedSlots.pop_back();
+		s_Interpolated[ a_Slot ] = Null;
+	}
+
+	SetDirty( a_Slot );
+}
+
+void TransformStorage::BeginFixedStep()
+{
+	for ( uint32_t Slot : s_InterpolatedSlots )
+	{
+		s_PreviousPositions[ Slot ] = s_LocalPositions[ Slot ];
+		s_PreviousRotations[ Slot ] = s_LocalRotations[ Slot ];
+		s_PreviousScales[ Slot ] = s_LocalScales[ Slot ];
+	}
+}
+
+void TransformStorage::SetInterpolationAlpha( float a_Alpha )
+{
+	s_InterpolationAlpha = a_Alpha;
+
+	for ( uint32_t Slot : s_InterpolatedSlots )
+	{
+		SetDirty( Slot );
+	}
+}
+
+void TransformStorage::Update()
+{
+	s_Moved.clear();
+	s_Updates.clear();
+
+	// Children are queued behind their parents, so the queue grows to cover every subtree that moved
+	// as it is walked.
+	for ( size_t i = 0; i < s_Queue.size(); ++i )
+	{
+		uint32_t Slot = s_Queue[ i ];
+
+		// Freed, or queued twice after being freed and reused.
+		if ( s_States[ Slot ] != Queued )
+		{
+			continue;
+		}
+
+		s_States[ Slot ] = Collected;
+		s_Updates.push_back( Slot );
+
+		for ( uint32_t Child = s_FirstChildren[ Slot ]; Child != Null; Child = s_NextSiblings[ Child ] )
+		{
+			if ( s_States[ Child ] == Idle )
+			{
+				s_States[ Child ] = Queued;
+				s_Queue.push_back( Child );
+			}
+		}
+	}
+
+	s_Queue.clear();
+
+	// Counting sort into levels by depth. Once sorted s_Levels[ i ] is where level i ends.
+	uint32_t MaxDepth = 0;
+
+	for ( uint32_t Slot : s_Updates )
+	{
+		MaxDepth = Math::Max( MaxDepth, s_Depths[ Slot ] );
+	}
+
+	s_Levels.assign( MaxDepth + 2, 0 );
+
+	for ( uint32_t Slot : s_Updates )
+	{
+		++s_Levels[ s_Depths[ Slot ] + 1 ];
+	}
+
+	for ( size_t i = 1; i < s_Levels.size(); ++i )
+	{
+		s_Levels[ i ] += s_Levels[ i - 1 ];
+	}
+
+	s_Sorted.resize( s_Updates.size() );
+
+	for ( uint32_t Slot : s_Updates )
+	{
+		s_Sorted[ s_Levels[ s_Depths[ Slot ] ]++ ] = Slot;
+	}
+
+	// A level only reads the level above, which is done by the time it starts.
+	size_t Begin = 0;
+
+	for ( uint32_t Level = 0; Level <= MaxDepth; ++Level )
+	{
+		const uint32_t* Slots = s_Sorted.data() + Begin;
+		size_t Count = s_Levels[ Level ] - Begin;
+		Begin = s_Levels[ Level ];
+
+		if ( Count < s_ParallelThreshold )
+		{
+			UpdateRange( Slots, Count );
+			continue;
+		}
+
+		WorkerPool::ParallelFor( Count, BatchSize, [ Slots ]( size_t a_Begin, size_t a_End, uint32_t )
+		{
+			UpdateRange( Slots + a_Begin, a_End - a_Begin );
+		} );
+	}
+
+	for ( uint32_t Slot : s_Sorted )
+	{
+		s_States[ Slot ] = Idle;
+		s_Moved.push_back( s_Owners[ Slot ] );
+	}
+}
+
+void TransformStorage::UpdateImmediate( uint32_t a_Slot )
+{
+	UpdateRange( &a_Slot, 1 );
+
+	for ( uint32_t Child = s_FirstChildren[ a_Slot ]; Child != Null; Child = s_NextSiblings[ Child ] )
+	{
+		UpdateImmediate( Child );
+	}
+}
+
+void TransformStorage::UpdateRange( const uint32_t* a_Slots, size_t a_Count )
+{
+	for ( size_t i = 0; i < a_Count; ++i )
+	{
+		uint32_t Slot = a_Slots[ i ];
+
+		if ( s_Dirty[ Slot ] )
+		{
+			ComposeLocal( Slot );
+			s_Dirty[ Slot ] = false;
+		}
+
+		if ( s_Parents[ Slot ] == Null )
+		{
+			s_GlobalMatrices[ Slot ] = s_LocalMatrices[ Slot ];
+		}
+		else
+		{
+			MultiplyGlobal( Slot );
+		}
+	}
+}
+
+// Same result as Matrix4::CreateTransform, rotation columns scaled and translation in the last column.
+// Interpolated slots are composed from their previous state blended towards the current one, rotations
+// are blended linearly and normalized, which is close enough over a single fixed step.
+void TransformStorage::ComposeLocal( uint32_t a_Slot )
+{
+	Vector3 Position = s_LocalPositions[ a_Slot ];
+	Quaternion Rotation = s_LocalRotations[ a_Slot ];
+	Vector3 Scale = s_LocalScales[ a_Slot ];
+
+	if ( s_Interpolated[ a_Slot ] != Null )
+	{
+		const Quaternion& Previous = s_PreviousRotations[ a_Slot ];
+		float Alpha = s_InterpolationAlpha;
+		float Sign = Previous.w * Rotation.w + Previous.x * Rotation.x + Previous.y * Rotation.y + Previous.z * Rotation.z < 0.0f ? -1.0f : 1.0f;
+
+		Rotation = Quaternion(
+			Previous.w + ( Rotation.w * Sign - Previous.w ) * Alpha,
+			Previous.x + ( Rotation.x * Sign - Previous.x ) * Alpha,
+			Previous.y + ( Rotation.y * Sign - Previous.y ) * Alpha,
+			Previous.z + ( Rotation.z * Sign - Previous.z ) * Alpha );
+
+		float Length = Math::Sqrt( Rotation.w * Rotation.w + Rotation.x * Rotation.x + Rotation.y * Rotation.y + Rotation.z * Rotation.z );
+		Rotation = Quaternion( Rotation.w / Length, Rotation.x / Length, Rotation.y / Length, Rotation.z / Length );
+		Position = Math::Lerp( Alpha, s_PreviousPositions[ a_Slot ], Position );
+		Scale = Math::Lerp( Alpha, s_PreviousScales[ a_Slot ], Scale );
+	}
+
+	float XX = Rotation.x * Rotation.x, YY = Rotation.y * Rotation.y, ZZ = Rotation.z * Rotation.z;
+	float XY = Rotation.x * Rotation.y, XZ = Rotation.x * Rotation.z, YZ = Rotation.y * Rotation.z;
+	float XW = Rotation.x * Rotation.w, YW = Rotation.y * Rotation.w, ZW = Rotation.z * Rotation.w;
+
+	__m128 Scales = _mm_setr_ps( Scale.x, Scale.y, Scale.z, 1.0f );
+	float* Result = s_LocalMatrices[ a_Slot ].Data;
+
+	_mm_store_ps( Result,      _mm_mul_ps( _mm_setr_ps( 1.0f - 2.0f * ( YY + ZZ ), 2.0f * ( XY + ZW ), 2.0f * ( XZ - YW ), Position.x ), Scales ) );
+	_mm_store_ps( Result + 4,  _mm_mul_ps( _mm_setr_ps( 2.0f * ( XY - ZW ), 1.0f - 2.0f * ( XX + ZZ ), 2.0f * ( YZ + XW ), Position.y ), Scales ) );
+	_mm_store_ps( Result + 8,  _mm_mul_ps( _mm_setr_ps( 2.0f * ( XZ + YW ), 2.0f * ( YZ - XW ), 1.0f - 2.0f * ( XX + YY ), Position.z ), Scales ) );
+	_mm_store_ps( Result + 12, _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f ) );
+}
+
+// Parent times local, one row of the result at a time as a sum of the local matrix's rows.
+void TransformStorage::MultiplyGlobal( uint32_t a_Slot )
+{
+	const float* Parent = s_GlobalMatrices[ s_Parents[ a_Slot ] ].Data;
+	const float* Local = s_LocalMatrices[ a_Slot ].Data;
+	float* Result = s_GlobalMatrices[ a_Slot ].Data;
+
+	__m128 Row0 = _mm_load_ps( Local );
+	__m128 Row1 = _mm_load_ps( Local + 4 );
+	__m128 Row2 = _mm_load_ps( Local + 8 );
+	__m128 Row3 = _mm_load_ps( Local + 12 );
+
+	for ( uint32_t r = 0; r < 4; ++r )
+	{
+		const float* Row = Parent + r * 4;
+		__m128 Sum = _mm_mul_ps( _mm_set1_ps( Row[ 0 ] ), Row0 );
+		Sum = _mm_add_ps( Sum, _mm_mul_ps( _mm_set1_ps( Row[ 1 ] ), Row1 ) );
+		Sum = _mm_add_ps( Sum, _mm_mul_ps( _mm_set1_ps( Row[ 2 ] ), Row2 ) );
+		Sum = _mm_add_ps( Sum, _mm_mul_ps( _mm_set1_ps( Row[ 3 ] ), Row3 ) );
+		_mm_store_ps( Result + r * 4, Sum );
+	}
+}
+
+void TransformStorage::Unlink( uint32_t a_Slot )
+{
+	uint32_t Parent = s_Parents[ a_Slot ];
+
+	if ( Parent == Null )
+	{
+		return;
+	}
+
+	uint32_t Previous = s_PreviousSiblings[ a_Slot ];
+	uint32_t Next = s_NextSiblings[ a_Slot ];
+
+	if ( Previous != Null )
+	{
+		s_NextSiblings[ Previous ] = Next;
+	}
+	else
+	{
+		s_FirstChildren[ Parent ] = Next;
+	}
+
+	if ( Next != Null )
+	{
+		s_PreviousSiblings[ Next ] = Previous;
+	}
+
+	s_Parents[ a_Slot ] = Null;
+	s_NextSiblings[ a_Slot ] = Null;
+	s_PreviousSiblings[ a_Slot ] = Null;
+}
+
+void TransformStorage::SetDepth( uint32_t a_Slot, uint32_t a_Depth )
+{
+	s_Depths[ a_Slot ] = a_Depth;
+
+	for ( uint32_t Child = s_FirstChildren[ a_Slot ]; Child != Null; Child = s_NextSiblings[ Child ] )
+	{
+		SetDepth( Child, a_Depth + 1 );
+	}
+}
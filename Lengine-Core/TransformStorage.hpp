@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "Math.hpp"
+
+typedef uint32_t GameObjectID;
+
+// Hands out memory on a 16 byte boundary, so arrays can be walked with aligned SSE loads.
+template < typename T >
+struct AlignedAllocator
+{
+	using value_type = T;
+
+	static constexpr size_t Alignment = 16;
+
+	AlignedAllocator() = default;
+
+	template < typename U >
+	AlignedAllocator( const AlignedAllocator< U >& ) { }
+
+	T* allocate( size_t a_Count )
+	{
+		return static_cast< T* >( ::operator new( a_Count * sizeof( T ), std::align_val_t( Alignment ) ) );
+	}
+
+	void deallocate( T* a_Pointer, size_t )
+	{
+		::operator delete( a_Pointer, std::align_val_t( Alignment ) );
+	}
+
+	template < typename U >
+	bool operator==( const AlignedAllocator< U >& ) const
+	{
+		return true;
+	}
+
+	template < typename U >
+	bool operator!=( const AlignedAllocator< U >& ) const
+	{
+		return false;
+	}
+};
+
+// Transform data laid out by field rather than by object, one slot per Transform. Transform components
+// are a facade over their slot, so a slot stays put while the registry moves components around, and
+// slots freed are reused. The hierarchy is mirrored by slot, and updates go one level of it at a time,
+// with each level split across the WorkerPool and matrices composed with SSE.
+//
+// References into the arrays are only valid until the next slot is allocated.
+class TransformStorage
+{
+public:
+
+	static constexpr uint32_t Null = uint32_t( -1 );
+
+	template < typename T >
+	using Array = std::vector< T, AlignedAllocator< T > >;
+
+	// Slots start out at the origin, dirty, without an owner and without a parent.
+	static uint32_t Allocate();
+	static void Free( uint32_t a_Slot );
+
+	// Copies the local transform of a_Source and whether it is interpolated, but not its place in the
+	// hierarchy.
+	static void Copy( uint32_t a_Source, uint32_t a_Destination );
+
+	// Slots are only queued for updates once they have an owner.
+	static void SetOwner( uint32_t a_Slot, GameObjectID a_Owner );
+
+	// Moves a_Slot under a_Parent, or to the root for Null, along with the depth of everything below it.
+	static void SetParent( uint32_t a_Slot, uint32_t a_Parent );
+
+	inline static void SetDirty( uint32_t a_Slot )
+	{
+		s_Dirty[ a_Slot ] = true;
+		Queue( a_Slot );
+	}
+
+	inline static void Queue( uint32_t a_Slot )
+	{
+		if ( s_States[ a_Slot ] == Idle && s_Owners[ a_Slot ] != GameObjectID( -1 ) )
+		{
+			s_States[ a_Slot ] = Queued;
+			s_Queue.push_back( a_Slot );
+		}
+	}
+
+	// Interpolated slots are drawn between the state they had before the last fixed step and the state
+	// after it, blended by the interpolation alpha. Their global matrices, and those of the slots below
+	// them, hold the blended state.
+	static void SetInterpolated( uint32_t a_Slot, bool a_Interpolated );
+
+	inline static bool IsInterpolated( uint32_t a_Slot )
+	{
+		return s_Interpolated[ a_Slot ] != Null;
+	}
+
+	// Keeps the current local transform of every interpolated slot as the state to blend from. Called
+	// before each fixed step.
+	static void BeginFixedStep();
+
+	// Sets how far to blend towards the current state, and queues every interpolated slot so the next
+	// Update recomputes it.
+	static void SetInterpolationAlpha( float a_Alpha );
+
+	// Recomputes the slots queued since the last call and everything below them, parents before their
+	// children. Slots that haven't changed aren't visited at all.
+	static void Update();
+
+	// Recomputes a slot and everything below it straight away. They are still updated by the next
+	// Update if they were queued.
+	static void UpdateImmediate( uint32_t a_Slot );
+
+	// Owners of the slots recomputed by the last Update.
+	inline static const std::vector< GameObjectID >& GetMoved()
+	{
+		return s_Moved;
+	}
+
+	// Levels with fewer slots than this are updated on the calling thread. Size_t( -1 ) keeps every
+	// level there.
+	inline static void SetParallelThreshold( size_t a_Threshold )
+	{
+		s_ParallelThreshold = a_Threshold;
+	}
+
+	inline static size_t GetParallelThreshold()
+	{
+		return s_ParallelThreshold;
+	}
+
+	inline static size_t GetSlotCount()
+	{
+		return s_Owners.size() - s_Free.size();
+	}
+
+	static constexpr size_t BatchSize = 256;
+
+private:
+
+	template < typename > friend class ITransform;
+
+	enum : uint8_t
+	{
+		Idle,
+		Queued,
+		Collected
+	};
+
+	// Local matrices are recomputed if dirty. Roots copy theirs into the global matrix, so children can
+	// read their parent's the same way whether it is a root or not.
+	static void UpdateRange( const uint32_t* a_Slots, size_t a_Count );
+	static void ComposeLocal( uint32_t a_Slot );
+	static void MultiplyGlobal( uint32_t a_Slot );
+	static void Unlink( uint32_t a_Slot );
+	static void SetDepth( uint32_t a_Slot, uint32_t a_Depth );
+
+	inline static Array< Vector3 >      s_LocalPositions;
+	inline static Array< Quaternion >   s_LocalRotations;
+	inline static Array< Vector3 >      s_LocalScales;
+	inline static Array< Matrix4 >      s_LocalMatrices;
+	inline static Array< Matrix4 >      s_GlobalMatrices;
+	inline static Array< uint32_t >     s_Parents;
+	inline static Array< uint32_t >     s_FirstChildren;
+	inline static Array< uint32_t >     s_NextSiblings;
+	inline static Array< uint32_t >     s_PreviousSiblings;
+	inline static Array< uint32_t >     s_Depths;
+	inline static Array< GameObjectID > s_Owners;
+	inline static Array< uint8_t >      s_Dirty;
+	inline static Array< uint8_t >      s_States;
+	inline static Array< uint32_t >     s_Interpolated;
+	inline static Array< Vector3 >      s_PreviousPositions;
+	inline static Array< Quaternion >   s_PreviousRotations;
+	inline static Array< Vector3 >      s_PreviousScales;
+
+	inline static std::vector< uint32_t >     s_Free;
+	inline static std::vector< uint32_t >     s_Queue;
+	inline static std::vector< uint32_t >     s_Updates;
+	inline static std::vector< uint32_t >     s_Sorted;
+	inline static std::vector< size_t >       s_Levels;
+	inline static std::vector< GameObjectID > s_Moved;
+	inline static std::vector< uint32_t >     s_InterpolatedSlots;
+	inline static float                       s_InterpolationAlpha = 1.0f;
+	inline static size_t                      s_ParallelThreshold = 1024;
+};
+
+// Owns a slot in TransformStorage for as long as it lives. Moving hands the slot over, copying takes a
+// new slot with the same local transform.
+class TransformSlot
+{
+public:
+
+	TransformSlot()
+		: m_Slot( TransformStorage::Allocate() )
+	{ }
+
+	TransformSlot( const TransformSlot& a_Other )
+		: m_Slot( TransformStorage::Allocate() )
+	{
+		TransformStorage::Copy( a_Other.m_Slot, m_Slot );
+	}
+
+	TransformSlot( TransformSlot&& a_Other ) noexcept
+		: m_Slot( a_Other.m_Slot )
+	{
+		a_Other.m_Slot = TransformStorage::Null;
+	}
+
+	~TransformSlot()
+	{
+		Release();
+	}
+
+	TransformSlot& operator=( const TransformSlot& a_Other )
+	{
+		if ( this != &a_Other )
+		{
+			if ( m_Slot == TransformStorage::Null )
+			{
+				m_Slot = TransformStorage::Allocate();
+			}
+
+			TransformStorage::Copy( a_Other.m_Slot, m_Slot );
+		}
+
+		return *this;
+	}
+
+	TransformSlot& operator=( TransformSlot&& a_Other ) noexcept
+	{
+		if ( this != &a_Other )
+		{
+			Release();
+			m_Slot = a_Other.m_Slot;
+			a_Other.m_Slot = TransformStorage::Null;
+		}
+
+		return *this;
+	}
+
+	inline void Release()
+	{
+		if ( m_Slot != TransformStorage::Null )
+		{
+			TransformStorage::Free( m_Slot );
+			m_Slot = TransformStorage::Null;
+		}
+	}
+
+	inline operator uint32_t() const
+	{
+		return m_Slot;
+	}
+
+private:
+
+	uint32_t m_Slot;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer triple buffer. The producer always owns the back slot and the
+// consumer always owns the front slot, so neither side ever waits on the other. The middle slot is
+// handed between them through a single atomic that packs the slot index with a "fresh" bit.
+template < typename T >
+class TripleBuffer
+{
+public:
+
+	TripleBuffer()
+		: m_Back( 0 )
+		, m_Middle( 1 )
+		, m_Front( 2 )
+	{ }
+
+	inline T& Back()
+	{
+		return m_Slots[ m_Back ];
+	}
+
+	inline T& Front()
+	{
+		return m_Slots[ m_Front ];
+	}
+
+	inline T& operator[]( uint8_t a_Index )
+	{
+		return m_Slots[ a_Index ];
+	}
+
+	// Producer side. Hands the back slot to the consumer, replacing any frame that has not been
+	// consumed yet. Returns true if an unconsumed frame was replaced.
+	bool PublishLatest()
+	{
+		uint8_t Previous = m_Middle.exchange( m_Back | s_Fresh, std::memory_order_acq_rel );
+		m_Back = Previous & s_IndexMask;
+		return Previous & s_Fresh;
+	}
+
+	// Producer side. Hands the back slot to the consumer only if the last published frame has been
+	// consumed, so frames are always presented in submission order. Returns false if the back slot
+	// was kept because the consumer is still behind.
+	bool PublishQueued()
+	{
+		uint8_t Expected = m_Middle.load( std::memory_order_acquire );
+
+		while ( !( Expected & s_Fresh ) )
+		{
+			if ( m_Middle.compare_exchange_weak( Expected, m_Back | s_Fresh, std::memory_order_acq_rel ) )
+			{
+				m_Back = Expected & s_IndexMask;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Consumer side. Swaps in the most recently published slot if there is one.
+	bool Acquire()
+	{
+		if ( !( m_Middle.load( std::memory_order_acquire ) & s_Fresh ) )
+		{
+			return false;
+		}
+
+		uint8_t Previous = m_Middle.exchange( m_Front, std::memory_order_acq_rel );
+		m_Front = Previous & s_IndexMask;
+		return true;
+	}
+
+	inline bool HasPending() const
+	{
+		return m_Middle.load( std::memory_order_acquire ) & s_Fresh;
+	}
+
+private:
+
+	static constexpr uint8_t s_IndexMask = 0b011;
+	static constexpr uint8_t s_Fresh     = 0b100;
+
+	T                      m_Slots[ 3 ];
+	uint8_t                m_Back;
+	std::atomic< uint8_t > m_Middle;
+	uint8_t                m_Front;
+};
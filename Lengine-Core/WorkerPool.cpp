@@ -0,0 +1,326 @@
+#include "WorkerPool.hpp"
+
+void WorkerPool::Init( uint32_t a_Threads )
+{
+	if ( !s_Queues.empty() )
+	{
+		return;
+	}
+
+	if ( a_Threads == uint32_t( -1 ) )
+	{
+		uint32_t Hardware = std::thread::hardware_concurrency();
+		a_Threads = Hardware > 1 ? Hardware - 1 : 0;
+	}
+
+	s_Stopping = false;
+	t_Thread = 0;
+
+	for ( uint32_t i = 0; i <= a_Threads; ++i )
+	{
+		s_Queues.emplace_back( std::make_unique< Queue >() );
+	}
+
+	for ( uint32_t i = 0; i < a_Threads; ++i )
+	{
+		s_Threads.emplace_back( WorkerLoop, i + 1 );
+	}
+}
+
+void WorkerPool::Deinitialize()
+{
+	{
+		std::lock_guard< std::mutex > Lock( s_Mutex );
+		s_Stopping = true;
+	}
+
+	s_Wake.notify_all();
+
+	for ( std::thread& Thread : s_Threads )
+	{
+		Thread.join();
+	}
+
+	s_Threads.clear();
+	s_Queues.clear();
+	s_Queued = 0;
+	t_Thread = uint32_t( -1 );
+}
+
+void WorkerPool::Wait( const JobHandle& a_Handle )
+{
+	for ( uint32_t Spins = 0; !a_Handle.IsDone(); )
+	{
+		if ( CanRunJobs() && RunOne( t_Thread ) )
+		{
+			Spins = 0;
+			continue;
+		}
+
+		if ( ++Spins < WaitSpins )
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Nothing to run, sleep until a job finishes or one is queued that this thread could run.
+		std::unique_lock< std::mutex > Lock( s_Mutex );
+		++s_Waiting;
+		s_Finished.wait( Lock, [ &a_Handle ]{ return a_Handle.IsDone() || ( CanRunJobs() && s_Queued > 0 ); } );
+		--s_Waiting;
+		Spins = 0;
+	}
+}
+
+WorkerJob* WorkerPool::AllocateJob()
+{
+	std::lock_guard< std::mutex > Lock( s_JobMutex );
+
+	if ( s_FreeJobs.empty() )
+	{
+		return &s_Jobs.emplace_back();
+	}
+
+	WorkerJob* Job = s_FreeJobs.back();
+	s_FreeJobs.pop_back();
+	return Job;
+}
+
+void WorkerPool::FreeJob( WorkerJob* a_Job )
+{
+	std::lock_guard< std::mutex > Lock( s_JobMutex );
+	s_FreeJobs.push_back( a_Job );
+}
+
+JobHandle WorkerPool::Submit( WorkerJob* a_Job, const JobHandle* a_Dependencies, size_t a_Count )
+{
+	JobHandle Handle( a_Job, a_Job->Generation );
+
+	// One extra dependency is held while the others are added, so the job can't start half way.
+	a_Job->Dependencies = static_cast< uint32_t >( a_Count ) + 1;
+
+	for ( size_t i = 0; i < a_Count; ++i )
+	{
+		WorkerJob* Dependency = a_Dependencies[ i ].m_Job;
+		bool Added = false;
+
+		if ( Dependency )
+		{
+			std::lock_guard< std::mutex > Lock( Dependency->Mutex );
+
+			if ( Dependency->Generation == a_Dependencies[ i ].m_Generation )
+			{
+				Dependency->Dependents.push_back( a_Job );
+				Added = true;
+			}
+		}
+
+		if ( !Added )
+		{
+			--a_Job->Dependencies;
+		}
+	}
+
+	if ( --a_Job->Dependencies == 0 )
+	{
+		Push( a_Job );
+	}
+
+	return Handle;
+}
+
+void WorkerPool::Push( WorkerJob* a_Job )
+{
+	// Threads outside of the pool hand their jobs to the main thread's deque, to be stolen from there.
+	Queue& Target = *s_Queues[ t_Thread < s_Queues.size() ? t_Thread : 0 ];
+
+	{
+		std::lock_guard< std::mutex > Lock( Target.Mutex );
+		Target.Jobs.push_back( a_Job );
+	}
+
+	++s_Queued;
+
+	// Sleepers count themselves before checking s_Queued, so either they see this job or it sees them.
+	if ( s_Sleeping > 0 || s_Waiting > 0 )
+	{
+		{
+			std::lock_guard< std::mutex > Lock( s_Mutex );
+		}
+
+		s_Wake.notify_one();
+		s_Finished.notify_all();
+	}
+}
+
+bool WorkerPool::RunOne( uint32_t a_Thread )
+{
+	WorkerJob* Job = nullptr;
+	size_t Count = s_Queues.size();
+
+	for ( size_t i = 0; i < Count && !Job; ++i )
+	{
+		Queue& Source = *s_Queues[ ( a_Thread + i ) % Count ];
+		std::lock_guard< std::mutex > Lock( Source.Mutex );
+
+		if ( Source.Jobs.empty() )
+		{
+			continue;
+		}
+
+		if ( i == 0 )
+		{
+			Job = Source.Jobs.back();
+			Source.Jobs.pop_back();
+		}
+		else
+		{
+			Job = Source.Jobs.front();
+			Source.Jobs.pop_front();
+		}
+	}
+
+	if ( !Job )
+	{
+		return false;
+	}
+
+	--s_Queued;
+	Execute( Job, a_Thread );
+	return true;
+}
+
+void WorkerPool::Execute( WorkerJob* a_Job, uint32_t a_Thread )
+{
+	a_Job->Function( a_Job->Storage, a_Thread );
+
+	// Nothing is added to the dependents once the generation has moved on.
+	{
+		std::lock_guard< std::mutex > Lock( a_Job->Mutex );
+		++a_Job->Generation;
+	}
+
+	for ( WorkerJob* Dependent : a_Job->Dependents )
+	{
+		if ( --Dependent->Dependencies == 0 )
+		{
+			Push( Dependent );
+		}
+	}
+
+	a_Job->Dependents.clear();
+	FreeJob( a_Job );
+
+	if ( s_Waiting > 0 )
+	{
+		{
+			std::lock_guard< std::mutex > Lock( s_Mutex );
+		}
+
+		s_Finished.notify_all();
+	}
+}
+
+// Without workers the main thread runs jobs regardless, nothing else would.
+bool WorkerPool::CanRunJobs()
+{
+	return t_Thread < s_Queues.size() && ( t_Thread != 0 || s_MainParticipates || s_Threads.empty() );
+}
+
+void WorkerPool::Dispatch( size_t a_Count, size_t a_BatchSize, BatchFunction a_Function, void* a_Context )
+{
+	struct Loop
+	{
+		BatchFunction           Function;
+		void*                   Context;
+		size_t                  Count;
+		size_t                  BatchSize;
+		std::atomic< size_t >   Next;
+		std::atomic< size_t >   Remaining;
+		std::mutex              Mutex;
+		std::condition_variable Done;
+
+		void Run( uint32_t a_Thread )
+		{
+			for ( ;; )
+			{
+				size_t Begin = Next.fetch_add( BatchSize );
+
+				if ( Begin >= Count )
+				{
+					return;
+				}
+
+				Function( Context, Begin, Begin + BatchSize < Count ? Begin + BatchSize : Count, a_Thread );
+
+				if ( --Remaining == 0 )
+				{
+					{
+						std::lock_guard< std::mutex > Lock( Mutex );
+					}
+
+					Done.notify_one();
+				}
+			}
+		}
+	};
+
+	// Threads outside of the pool don't take batches, their thread index would clash with thread 0.
+	bool Participate = t_Thread < s_Queues.size();
+	size_t Batches = ( a_Count + a_BatchSize - 1 ) / a_BatchSize;
+	size_t Helpers = Batches - ( Participate ? 1 : 0 );
+	Helpers = Helpers < s_Threads.size() ? Helpers : s_Threads.size();
+
+	// Helpers share ownership of the loop, so those that only start once every batch is taken return
+	// straight away and nobody has to wait for them.
+	auto Shared = std::make_shared< Loop >();
+	Shared->Function = a_Function;
+	Shared->Context = a_Context;
+	Shared->Count = a_Count;
+	Shared->BatchSize = a_BatchSize;
+	Shared->Next = 0;
+	Shared->Remaining = Batches;
+
+	for ( size_t i = 0; i < Helpers; ++i )
+	{
+		Schedule( [ Shared ]( uint32_t a_Thread ){ Shared->Run( a_Thread ); } );
+	}
+
+	if ( Participate )
+	{
+		Shared->Run( t_Thread );
+	}
+
+	// Only batches already running on other threads are left. No other jobs are run in the meantime,
+	// one could be another batch of a loop this thread is inside of and share its thread index.
+	for ( uint32_t Spins = 0; Shared->Remaining > 0 && Spins < WaitSpins; ++Spins )
+	{
+		std::this_thread::yield();
+	}
+
+	std::unique_lock< std::mutex > Lock( Shared->Mutex );
+	Shared->Done.wait( Lock, [ &Shared ]{ return Shared->Remaining == 0; } );
+}
+
+void WorkerPool::WorkerLoop( uint32_t a_Thread )
+{
+	t_Thread = a_Thread;
+
+	for ( ;; )
+	{
+		if ( RunOne( a_Thread ) )
+		{
+			continue;
+		}
+
+		std::unique_lock< std::mutex > Lock( s_Mutex );
+		++s_Sleeping;
+		s_Wake.wait( Lock, []{ return s_Stopping || s_Queued > 0; } );
+		--s_Sleeping;
+
+		if ( s_Stopping )
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A job scheduled on the WorkerPool. Jobs are recycled, only ever refer to them through a JobHandle.
+struct WorkerJob
+{
+	static constexpr size_t StorageSize = 64;
+
+	alignas( std::max_align_t ) unsigned char Storage[ StorageSize ];
+	void( *Function )( void*, uint32_t ) = nullptr;
+	std::atomic< uint32_t >   Dependencies = 0;
+	std::atomic< uint32_t >   Generation = 0;
+	std::mutex                Mutex;
+	std::vector< WorkerJob* > Dependents;
+};
+
+// Refers to a scheduled job. Handles are cheap to copy and stay valid after the job is done, a default
+// constructed handle counts as done.
+class JobHandle
+{
+public:
+
+	JobHandle() = default;
+
+	inline bool IsDone() const
+	{
+		return !m_Job || m_Job->Generation != m_Generation;
+	}
+
+private:
+
+	friend class WorkerPool;
+
+	JobHandle( WorkerJob* a_Job, uint32_t a_Generation )
+		: m_Job( a_Job )
+		, m_Generation( a_Generation )
+	{ }
+
+	WorkerJob* m_Job = nullptr;
+	uint32_t   m_Generation = 0;
+};
+
+// Fixed set of threads running jobs. Every thread, the calling one included, has its own deque of jobs.
+// Threads take their newest job first and steal the oldest from the others once they run out. Jobs
+// can wait on other jobs, and threads waiting on a job run other jobs in the meantime.
+//
+// The thread that called Init is thread 0 and takes part in loops and waits, unless told otherwise.
+// Other threads outside of the pool can schedule and wait, but never run jobs themselves.
+class WorkerPool
+{
+public:
+
+	// a_Threads is the number of threads besides the calling one, by default one less than the number
+	// of hardware threads.
+	static void Init( uint32_t a_Threads = uint32_t( -1 ) );
+	static void Deinitialize();
+
+	// Number of threads loops are split across, including the calling thread.
+	inline static uint32_t GetThreadCount()
+	{
+		return static_cast< uint32_t >( s_Threads.size() ) + 1;
+	}
+
+	// Index of the calling thread, or uint32_t( -1 ) for threads outside of the pool.
+	inline static uint32_t GetThreadIndex()
+	{
+		return t_Thread;
+	}
+
+	// With this off, the main thread only waits on jobs without running them, unless there are no
+	// workers to run them. Loops it calls still run some of their batches on it.
+	inline static void SetMainThreadParticipation( bool a_Participate )
+	{
+		s_MainParticipates = a_Participate;
+	}
+
+	inline static bool GetMainThreadParticipation()
+	{
+		return s_MainParticipates;
+	}
+
+	// Runs a_Function once every job in a_Dependencies is done, as a_Function( Thread ) or
+	// a_Function(). Captures are stored inside the job, so they must be small, capture larger state by
+	// reference or pointer and keep it alive until the job is done.
+	template < typename _Function >
+	static JobHandle Schedule( _Function&& a_Function, std::initializer_list< JobHandle > a_Dependencies = {} )
+	{
+		return Submit( CreateJob( std::forward< _Function >( a_Function ) ), a_Dependencies.begin(), a_Dependencies.size() );
+	}
+
+	template < typename _Function >
+	static JobHandle Schedule( _Function&& a_Function, const std::vector< JobHandle >& a_Dependencies )
+	{
+		return Submit( CreateJob( std::forward< _Function >( a_Function ) ), a_Dependencies.data(), a_Dependencies.size() );
+	}
+
+	// Returns once the job is done, running other jobs on the calling thread in the meantime and
+	// sleeping once there are none. As those jobs run with the calling thread's index, don't wait from
+	// a loop batch that keeps per thread storage in use across the wait.
+	static void Wait( const JobHandle& a_Handle );
+
+	// Invokes a_Function( Begin, End, Thread ) for consecutive ranges of at most a_BatchSize covering
+	// [ 0, a_Count ), and returns once every batch is done. A batch size of 0 picks one that gives each
+	// thread a few batches. Thread is below GetThreadCount() and no two batches running at the same
+	// time share it, so it can index per thread storage. Loops can be nested, a batch running an inner
+	// loop takes part in its batches and then sleeps until the rest are done, without running any
+	// other jobs in the meantime.
+	template < typename _Function >
+	static void ParallelFor( size_t a_Count, size_t a_BatchSize, _Function&& a_Function )
+	{
+		if ( a_BatchSize == 0 )
+		{
+			a_BatchSize = a_Count / ( GetThreadCount() * BatchesPerThread );
+			a_BatchSize = a_BatchSize > 0 ? a_BatchSize : 1;
+		}
+
+		if ( s_Threads.empty() || a_Count <= a_BatchSize )
+		{
+			if ( a_Count > 0 )
+			{
+				a_Function( size_t( 0 ), a_Count, t_Thread < GetThreadCount() ? t_Thread : 0u );
+			}
+
+			return;
+		}
+
+		Dispatch( a_Count, a_BatchSize, []( void* a_Context, size_t a_Begin, size_t a_End, uint32_t a_Thread )
+		{
+			( *static_cast< _Function* >( a_Context ) )( a_Begin, a_End, a_Thread );
+		}, &a_Function );
+	}
+
+	// Batches handed to each thread by a ParallelFor with a batch size of 0.
+	static constexpr size_t BatchesPerThread = 4;
+
+	// Times a waiting thread yields before going to sleep.
+	static constexpr uint32_t WaitSpins = 64;
+
+private:
+
+	typedef void( *BatchFunction )( void*, size_t, size_t, uint32_t );
+
+	// Jobs are pushed and taken by their owner at the back, and stolen by others from the front.
+	struct Queue
+	{
+		std::mutex              Mutex;
+		std::deque< WorkerJob* > Jobs;
+	};
+
+	template < typename _Function >
+	static WorkerJob* CreateJob( _Function&& a_Function )
+	{
+		using Functor = std::decay_t< _Function >;
+		static_assert( sizeof( Functor ) <= WorkerJob::StorageSize && alignof( Functor ) <= alignof( std::max_align_t ), "Job captures too much, capture by reference or pointer instead." );
+
+		WorkerJob* Job = AllocateJob();
+		new ( Job->Storage ) Functor( std::forward< _Function >( a_Function ) );
+		Job->Function = []( void* a_Storage, uint32_t a_Thread )
+		{
+			Functor& Function = *static_cast< Functor* >( a_Storage );
+
+			if constexpr ( std::is_invocable_v< Functor&, uint32_t > )
+			{
+				Function( a_Thread );
+			}
+			else
+			{
+				Function();
+			}
+
+			Function.~Functor();
+		};
+
+		return Job;
+	}
+
+	static WorkerJob* AllocateJob();
+	static void FreeJob( WorkerJob* a_Job );
+	static JobHandle Submit( WorkerJob* a_Job, const JobHandle* a_Dependencies, size_t a_Count );
+	static void Push( WorkerJob* a_Job );
+	static bool RunOne( uint32_t a_Thread );
+	static void Execute( WorkerJob* a_Job, uint32_t a_Thread );
+	static bool CanRunJobs();
+	static void Dispatch( size_t a_Count, size_t a_BatchSize, BatchFunction a_Function, void* a_Context );
+	static void WorkerLoop( uint32_t a_Thread );
+
+	inline static std::vector< std::thread >              s_Threads;
+	inline static std::vector< std::unique_ptr< Queue > > s_Queues;
+	inline static std::mutex                              s_Mutex;
+	inline static std::condition_variable                 s_Wake;
+	inline static std::condition_variable                 s_Finished;
+	inline static std::atomic< size_t >                   s_Queued = 0;
+	inline static std::atomic< uint32_t >                 s_Sleeping = 0;
+	inline static std::atomic< uint32_t >                 s_Waiting = 0;
+	inline static bool                                    s_Stopping = false;
+	inline static std::atomic< bool >                     s_MainParticipates = true;
+	inline static std::mutex                              s_JobMutex;
+	inline static std::deque< WorkerJob >                 s_Jobs;
+	inline static std::vector< WorkerJob* >               s_FreeJobs;
+	inline static thread_local uint32_t                   t_Thread = uint32_t( -1 );
+};
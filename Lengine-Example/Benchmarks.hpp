@@ -0,0 +1,718 @@
+#pragma once
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CGE.hpp"
+#include "ConsoleGL.hpp"
+#include "RenderQueue.hpp"
+#include "SpatialIndex.hpp"
+#include "MeshRenderer.hpp"
+#include "OcclusionBuffer.hpp"
+#include "Prefab.hpp"
+#include "ShadowMap.hpp"
+#include "SystemScheduler.hpp"
+#include "TransformStorage.hpp"
+#include "WorkerPool.hpp"
+
+// Benchmarks render the currently loaded scene for a fixed number of frames and append their
+// results to Benchmarks.txt, as the console itself is being drawn over.
+
+// Opens Benchmarks.txt for appending and writes the heading of a benchmark.
+inline std::ofstream BeginBenchmark( const std::string& a_Heading )
+{
+	std::ofstream Output( "Benchmarks.txt", std::ios::app );
+	Output << a_Heading << "\n";
+	return Output;
+}
+
+// One frame of the scene, as CGE::Run would draw it.
+inline void RenderSceneFrame()
+{
+	Scene::Tick();
+	RenderingPipeline::Tick();
+	ConsoleWindow::SwapBuffers( ConsoleWindow::GetCurrentContext() );
+}
+
+inline float TimeFrames( uint32_t a_Frames, const Action<>& a_Frame )
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	for ( uint32_t i = 0; i < a_Frames; ++i )
+	{
+		a_Frame.Invoke();
+	}
+
+	auto Elapsed = std::chrono::high_resolution_clock::now() - Start;
+	return std::chrono::duration< float, std::milli >( Elapsed ).count() / a_Frames;
+}
+
+inline void RunRenderScaleBenchmark( uint32_t a_Frames = 200 )
+{
+	std::ofstream Output = BeginBenchmark( "Render scale, " + std::to_string( a_Frames ) + " frames" );
+
+	for ( float Scale : { 1.0f, 0.75f, 0.5f } )
+	{
+		for ( bool Temporal : { false, true } )
+		{
+			ConsoleGL::RenderScale( Scale );
+
+			if ( Temporal )
+			{
+				ConsoleGL::Enable( ConsoleGL::RenderSetting::TEMPORAL_ACCUMULATION );
+			}
+			else
+			{
+				ConsoleGL::Disable( ConsoleGL::RenderSetting::TEMPORAL_ACCUMULATION );
+			}
+
+			ConsoleGL::ResetShadedFragments();
+			float FrameTime = TimeFrames( a_Frames, RenderSceneFrame );
+
+			Output
+				<< "  scale " << Scale << ( Temporal ? " + temporal" : "           " )
+				<< "  fragments/frame " << ConsoleGL::GetShadedFragments() / a_Frames
+				<< "  ms/frame " << FrameTime << "\n";
+		}
+	}
+
+	ConsoleGL::RenderScale( 1.0f );
+	ConsoleGL::Disable( ConsoleGL::RenderSetting::TEMPORAL_ACCUMULATION );
+}
+
+// Builds and sorts a queue of synthetic draws spread over a handful of meshes, materials and shaders.
+// Only the queue is measured, nothing is submitted to the backend.
+inline void RunRenderQueueBenchmark( uint32_t a_Frames = 200, uint32_t a_Draws = 10000 )
+{
+	std::ofstream Output = BeginBenchmark( "Render queue, " + std::to_string( a_Draws ) + " draws, " + std::to_string( a_Frames ) + " frames" );
+
+	std::mt19937 Generator( 1234 );
+	std::uniform_real_distribution< float > Spread( -50.0f, 50.0f );
+	std::vector< Matrix4 > Models( a_Draws );
+
+	for ( uint32_t i = 0; i < a_Draws; ++i )
+	{
+		Models[ i ] = Matrix4::CreateTranslation( Vector3( Spread( Generator ), Spread( Generator ), Spread( Generator ) + 50.0f ) );
+	}
+
+	// Only the addresses are used to build keys.
+	alignas( 64 ) static char Resources[ 3 ][ 16 ][ 64 ];
+	RenderQueue Queue;
+	size_t Checksum = 0;
+
+	Action<> Frame = [&]()
+	{
+		Queue.Begin( Vector3::Zero, Vector3::Forward, 100.0f );
+
+		for ( uint32_t i = 0; i < a_Draws; ++i )
+		{
+			Queue.Submit(
+				reinterpret_cast< const Mesh*     >( Resources[ 0 ][ i % 16 ] ),
+				reinterpret_cast< const Material* >( Resources[ 1 ][ ( i / 7 ) % 16 ] ),
+				reinterpret_cast< const Shader*   >( Resources[ 2 ][ ( i / 3 ) % 4 ] ),
+				Models[ i ], 0, ( i % 10 ) == 0 );
+		}
+
+		Queue.Sort();
+
+		// Count state changes so the sort can't be optimized away.
+		const Mesh* ActiveMesh = nullptr;
+
+		for ( const DrawItem& Item : Queue )
+		{
+			Checksum += Item.Mesh != ActiveMesh;
+			ActiveMesh = Item.Mesh;
+		}
+	};
+
+	// First frame grows the queue to its final capacity.
+	Frame.Invoke();
+	Checksum = 0;
+	float FrameTime = TimeFrames( a_Frames, Frame );
+
+	Output
+		<< "  build + sort ms/frame " << FrameTime
+		<< "  mesh changes/frame " << Checksum / a_Frames << "\n";
+}
+
+// Builds the same kind of queue on the calling thread alone and then across the worker pool, where
+// every thread fills its own queue and the sorted queues are merged. PVMs are computed for every draw
+// in both cases.
+inline void RunParallelQueueBenchmark( uint32_t a_Frames = 200, uint32_t a_Draws = 100000 )
+{
+	std::ofstream Output = BeginBenchmark( "Parallel render queue, " + std::to_string( a_Draws ) + " draws, " + std::to_string( WorkerPool::GetThreadCount() ) + " threads, " + std::to_string( a_Frames ) + " frames" );
+
+	std::mt19937 Generator( 1234 );
+	std::uniform_real_distribution< float > Spread( -50.0f, 50.0f );
+	std::vector< Matrix4 > Models( a_Draws );
+
+	for ( uint32_t i = 0; i < a_Draws; ++i )
+	{
+		Models[ i ] = Matrix4::CreateTranslation( Vector3( Spread( Generator ), Spread( Generator ), Spread( Generator ) + 50.0f ) );
+	}
+
+	Matrix4 ProjectionView = Matrix4::CreateProjection( Math::Radians( 75.0f ), 16.0f / 9.0f, 0.1f, 100.0f );
+	alignas( 64 ) static char Resources[ 3 ][ 16 ][ 64 ];
+	std::vector< RenderQueue > Queues( WorkerPool::GetThreadCount() );
+	std::vector< Matrix4 > PVMs;
+	RenderQueue Merged;
+
+	auto Submit = [&]( RenderQueue& a_Queue, size_t a_Begin, size_t a_End )
+	{
+		for ( size_t i = a_Begin; i < a_End; ++i )
+		{
+			a_Queue.SetOrder( static_cast< uint32_t >( i ) );
+			a_Queue.Submit(
+				reinterpret_cast< const Mesh*     >( Resources[ 0 ][ i % 16 ] ),
+				reinterpret_cast< const Material* >( Resources[ 1 ][ ( i / 7 ) % 16 ] ),
+				reinterpret_cast< const Shader*   >( Resources[ 2 ][ ( i / 3 ) % 4 ] ),
+				Models[ i ], 0, ( i % 10 ) == 0 );
+		}
+	};
+
+	Action<> Serial = [&]()
+	{
+		RenderQueue& Queue = Queues[ 0 ];
+		Queue.Begin( Vector3::Zero, Vector3::Forward, 100.0f );
+		Submit( Queue, 0, a_Draws );
+		Queue.Sort();
+		PVMs.resize( Queue.Size() );
+
+		for ( size_t i = 0; i < Queue.Size(); ++i )
+		{
+			PVMs[ i ] = Math::Multiply( ProjectionView, Queue.begin()[ i ].Model );
+		}
+	};
+
+	Action<> Parallel = [&]()
+	{
+		for ( RenderQueue& Queue : Queues )
+		{
+			Queue.Begin( Vector3::Zero, Vector3::Forward, 100.0f );
+		}
+
+		WorkerPool::ParallelFor( a_Draws, 64, [&]( size_t a_Begin, size_t a_End, uint32_t a_Thread ){ Submit( Queues[ a_Thread ], a_Begin, a_End ); } );
+		WorkerPool::ParallelFor( Queues.size(), 1, [&]( size_t a_Begin, size_t a_End, uint32_t ){ for ( size_t i = a_Begin; i < a_End; ++i ) Queues[ i ].Sort(); } );
+		Merged.Merge( Queues.data(), Queues.size() );
+		PVMs.resize( Merged.Size() );
+
+		WorkerPool::ParallelFor( Merged.Size(), 256, [&]( size_t a_Begin, size_t a_End, uint32_t )
+		{
+			for ( size_t i = a_Begin; i < a_End; ++i )
+			{
+				PVMs[ i ] = Math::Multiply( ProjectionView, Merged.begin()[ i ].Model );
+			}
+		} );
+	};
+
+	// First frames grow the queues to their final capacity.
+	Serial.Invoke();
+	Parallel.Invoke();
+	float SerialTime = TimeFrames( a_Frames, Serial );
+	float ParallelTime = TimeFrames( a_Frames, Parallel );
+
+	Output
+		<< "  serial ms/frame " << SerialTime
+		<< "  parallel ms/frame " << ParallelTime << "\n";
+}
+
+// Renders a_Count copies of a prefab sharing its mesh and the built in instanced diffuse material, in
+// a grid in front of the camera. The run without instancing submits the same shader a draw at a time,
+// so only its submission cost is meaningful, not what ends up on screen.
+inline void RunInstancingBenchmark( const Prefab& a_Prefab, uint32_t a_Frames = 100, uint32_t a_Count = 1000 )
+{
+	std::ofstream Output = BeginBenchmark( "Instancing, " + std::to_string( a_Count ) + " instances, " + std::to_string( a_Frames ) + " frames" );
+
+	std::vector< GameObject > Roots;
+	Prefab::InstantiateMany( a_Prefab, a_Count, Roots );
+	uint32_t Side = static_cast< uint32_t >( Math::Sqrt( static_cast< float >( a_Count ) ) ) + 1;
+
+	for ( uint32_t i = 0; i < a_Count; ++i )
+	{
+		Roots[ i ].GetTransform()->SetLocalPosition( Vector3( static_cast< float >( i % Side ) - Side * 0.5f, 0.0f, static_cast< float >( i / Side ) + 5.0f ) );
+	}
+
+	Material* SharedMaterial = Roots[ 0 ].GetComponentInChild< MeshRenderer >()->GetMaterial();
+	SharedMaterial->SetShader( Shader::Diffuse );
+
+	for ( bool Instancing : { false, true } )
+	{
+		SharedMaterial->Instancing = Instancing;
+		RenderSceneFrame();
+		float FrameTime = TimeFrames( a_Frames, RenderSceneFrame );
+
+		Output
+			<< ( Instancing ? "  instanced" : "  per draw " )
+			<< "  visible " << RenderingPipeline::GetVisibleCount()
+			<< "  draw calls/frame " << RenderingPipeline::GetDrawCallCount()
+			<< "  ms/frame " << FrameTime << "\n";
+	}
+
+	for ( GameObject Root : Roots )
+	{
+		GameObject::Destroy( Root );
+	}
+
+	SystemScheduler::Tick();
+}
+
+// Fills a spatial index with boxes scattered over a wide area and queries it with a camera that only
+// sees a small part of it. Measures the frustum query alone.
+inline void RunCullingBenchmark( uint32_t a_Frames = 200, uint32_t a_Objects = 100000 )
+{
+	std::ofstream Output = BeginBenchmark( "Culling, " + std::to_string( a_Objects ) + " objects, " + std::to_string( a_Frames ) + " frames" );
+
+	std::mt19937 Generator( 1234 );
+	std::uniform_real_distribution< float > Spread( -2000.0f, 2000.0f );
+	SpatialIndex Index;
+
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	for ( uint32_t i = 0; i < a_Objects; ++i )
+	{
+		Vector3 Centre( Spread( Generator ), Spread( Generator ) * 0.05f, Spread( Generator ) );
+		Index.Insert( AABB( Centre - Vector3::One, Centre + Vector3::One ), i );
+	}
+
+	float BuildTime = std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count();
+
+	Matrix4 ProjectionView = Math::Multiply(
+		Matrix4::CreateProjection( Math::Radians( 75.0f ), 16.0f / 9.0f, 0.1f, 250.0f ),
+		Matrix4::CreateView( Vector3::Zero, Quaternion() ) );
+
+	Frustum ViewFrustum( ProjectionView );
+	size_t Visible = 0;
+
+	Action<> Frame = [&]()
+	{
+		Index.Query( ViewFrustum, [&]( uint32_t ){ ++Visible; } );
+	};
+
+	float FrameTime = TimeFrames( a_Frames, Frame );
+
+	Output
+		<< "  build ms " << BuildTime
+		<< "  tree height " << Index.GetHeight()
+		<< "  visible/frame " << Visible / a_Frames
+		<< "  query ms/frame " << FrameTime << "\n";
+}
+
+// Rasterizes a wall in front of the camera and tests a field of boxes behind and around it.
+inline void RunOcclusionBenchmark( uint32_t a_Frames = 200, uint32_t a_Objects = 10000 )
+{
+	std::ofstream Output = BeginBenchmark( "Occlusion, " + std::to_string( a_Objects ) + " objects, " + std::to_string( a_Frames ) + " frames" );
+
+	Mesh Wall;
+	Wall.m_Positions = { Vector3( -20.0f, -10.0f, 0.0f ), Vector3( 20.0f, -10.0f, 0.0f ), Vector3( 20.0f, 10.0f, 0.0f ), Vector3( -20.0f, 10.0f, 0.0f ) };
+	Wall.m_Indices = { 0, 1, 2, 0, 2, 3 };
+	Matrix4 WallModel = Matrix4::CreateTranslation( Vector3( 0.0f, 0.0f, 10.0f ) );
+
+	std::mt19937 Generator( 1234 );
+	std::uniform_real_distribution< float > Spread( -40.0f, 40.0f );
+	std::uniform_real_distribution< float > Depth( 12.0f, 90.0f );
+	std::vector< AABB > Boxes( a_Objects );
+
+	for ( AABB& Box : Boxes )
+	{
+		Vector3 Centre( Spread( Generator ), Spread( Generator ) * 0.25f, Depth( Generator ) );
+		Box = AABB( Centre - Vector3::One, Centre + Vector3::One );
+	}
+
+	Matrix4 ProjectionView = Math::Multiply(
+		Matrix4::CreateProjection( Math::Radians( 75.0f ), 16.0f / 9.0f, 0.1f, 100.0f ),
+		Matrix4::CreateView( Vector3::Zero, Quaternion() ) );
+
+	OcclusionBuffer Buffer;
+	size_t Culled = 0;
+
+	Action<> Frame = [&]()
+	{
+		Buffer.Begin( ProjectionView );
+		Buffer.RasterizeOccluder( Wall, WallModel );
+
+		for ( const AABB& Box : Boxes )
+		{
+			Culled += !Buffer.IsVisible( Box );
+		}
+	};
+
+	float FrameTime = TimeFrames( a_Frames, Frame );
+
+	Output
+		<< "  culled/frame " << Culled / a_Frames
+		<< "  ms/frame " << FrameTime << "\n";
+}
+
+// Renders the scene with and without occlusion culling, and writes out the render graph with the
+// time each pass took in the last frame and the memory shared between targets.
+inline void RunRenderGraphBenchmark( uint32_t a_Frames = 200 )
+{
+	std::ofstream Output = BeginBenchmark( "Render graph, " + std::to_string( a_Frames ) + " frames" );
+
+	bool Occlusion = RenderingPipeline::GetOcclusionCulling();
+
+	for ( bool Enabled : { true, false } )
+	{
+		RenderingPipeline::SetOcclusionCulling( Enabled );
+		float FrameTime = TimeFrames( a_Frames, RenderSceneFrame );
+
+		Output << "  occlusion " << ( Enabled ? "on " : "off" ) << "  ms/frame " << FrameTime << "\n";
+		RenderingPipeline::GetRenderGraph().Describe( Output );
+	}
+
+	RenderingPipeline::SetOcclusionCulling( Occlusion );
+}
+
+// Draws a field of boxes into the cascades depth only, redrawn every frame and with the boxes cached
+// as static casters. Then renders the scene without shadows and with them, cached and not.
+inline void RunShadowBenchmark( uint32_t a_Frames = 200, uint32_t a_Casters = 2000 )
+{
+	std::ofstream Output = BeginBenchmark( "Shadows, " + std::to_string( a_Casters ) + " casters, " + std::to_string( a_Frames ) + " frames" );
+
+	Mesh Box;
+	Box.m_Positions =
+	{
+		Vector3( -1.0f, 0.0f, -1.0f ), Vector3( 1.0f, 0.0f, -1.0f ), Vector3( 1.0f, 2.0f, -1.0f ), Vector3( -1.0f, 2.0f, -1.0f ),
+		Vector3( -1.0f, 0.0f,  1.0f ), Vector3( 1.0f, 0.0f,  1.0f ), Vector3( 1.0f, 2.0f,  1.0f ), Vector3( -1.0f, 2.0f,  1.0f )
+	};
+	Box.m_Indices = { 0, 1, 2, 0, 2, 3, 5, 4, 7, 5, 7, 6, 4, 0, 3, 4, 3, 7, 1, 5, 6, 1, 6, 2, 3, 2, 6, 3, 6, 7, 4, 5, 1, 4, 1, 0 };
+
+	std::mt19937 Generator( 1234 );
+	std::uniform_real_distribution< float > Spread( -60.0f, 60.0f );
+	std::vector< ShadowCaster > Casters;
+	std::vector< ShadowCaster > None;
+
+	for ( uint32_t i = 0; i < a_Casters; ++i )
+	{
+		Casters.push_back( { &Box, Matrix4::CreateTranslation( Vector3( Spread( Generator ), 0.0f, Spread( Generator ) + 60.0f ) ) } );
+	}
+
+	ShadowMap Map;
+	std::vector< float > Depth( Map.GetSize() );
+	Vector3 Sun = Math::Normalize( Vector3( 0.4f, -1.0f, 0.3f ) );
+	uint32_t Triangles = 0;
+
+	// Every caster is drawn into every cascade, there is no spatial index to narrow them down here.
+	Action<> Frame = [&]()
+	{
+		Map.Fit( Sun, Vector3( 0.0f, 2.0f, 0.0f ), Vector3::Forward, Math::Radians( 75.0f ), 16.0f / 9.0f, 0.1f );
+
+		for ( uint32_t i = 0; i < Map.GetCascadeCount(); ++i )
+		{
+			Triangles += Map.RenderCascade( i, Depth.data() + i * Map.GetResolution() * Map.GetResolution(), Casters, None );
+		}
+	};
+
+	for ( bool Caching : { false, true } )
+	{
+		Map.SetStaticCaching( Caching );
+		Triangles = 0;
+		float FrameTime = TimeFrames( a_Frames, Frame );
+
+		Output
+			<< "  depth only, " << ( Caching ? "cached  " : "uncached" )
+			<< "  triangles/frame " << Triangles / a_Frames
+			<< "  ms/frame " << FrameTime << "\n";
+	}
+
+	bool Shadows = RenderingPipeline::GetShadows();
+	bool Caching = RenderingPipeline::GetShadowMap().GetStaticCaching();
+
+	for ( uint32_t Mode = 0; Mode < 3; ++Mode )
+	{
+		RenderingPipeline::SetShadows( Mode > 0 );
+		RenderingPipeline::GetShadowMap().SetStaticCaching( Mode == 2 );
+		float FrameTime = TimeFrames( a_Frames, RenderSceneFrame );
+		const ShadowStats& Stats = RenderingPipeline::GetShadowStats();
+
+		Output
+			<< "  scene, " << ( Mode == 0 ? "no shadows" : Mode == 1 ? "uncached  " : "cached    " )
+			<< "  ms/frame " << FrameTime
+			<< "  casters " << Stats.Casters
+			<< "  triangles " << Stats.Triangles
+			<< "  cached cascades " << Stats.CachedCascades
+			<< "  shadow ms " << Stats.RasterizeTime << "\n";
+	}
+
+	RenderingPipeline::SetShadows( Shadows );
+	RenderingPipeline::GetShadowMap().SetStaticCaching( Caching );
+}
+
+// Builds chains of transforms a_Depth deep and moves a share of them every frame. Only moved
+// transforms and those below them are recomputed, so nothing moving should cost next to nothing.
+inline void RunTransformBenchmark( uint32_t a_Frames = 100, uint32_t a_Count = 100000 )
+{
+	std::ofstream Output = BeginBenchmark( "Transforms, " + std::to_string( a_Count ) + " objects, " + std::to_string( a_Frames ) + " frames" );
+
+	std::vector< GameObject > Objects( a_Count );
+	size_t Threshold = TransformStorage::GetParallelThreshold();
+
+	for ( uint32_t Depth : { 1u, 4u, 16u } )
+	{
+		for ( uint32_t i = 0; i < a_Count; ++i )
+		{
+			Objects[ i ] = i % Depth ? GameObject::Instantiate( Objects[ i - 1 ] ) : GameObject::Instantiate();
+		}
+
+		Transform::UpdateTransforms();
+
+		for ( float Ratio : { 0.0f, 0.01f, 0.1f, 1.0f } )
+		{
+			for ( bool Parallel : { false, true } )
+			{
+				uint32_t Stride = Ratio > 0.0f ? static_cast< uint32_t >( 1.0f / Ratio ) : 0;
+				size_t Moved = 0;
+				float Offset = 0.0f;
+				TransformStorage::SetParallelThreshold( Parallel ? Threshold : size_t( -1 ) );
+
+				Action<> Frame = [&]()
+				{
+					Offset += 0.01f;
+
+					for ( uint32_t i = 0; Stride && i < a_Count; i += Stride )
+					{
+						Objects[ i ].GetTransform()->SetLocalPositionY( Offset );
+					}
+
+					Transform::UpdateTransforms();
+					Moved += Transform::GetMoved().size();
+				};
+
+				float FrameTime = TimeFrames( a_Frames, Frame );
+
+				Output
+					<< "  depth " << Depth
+					<< "  dirty " << Ratio * 100.0f << "%"
+					<< ( Parallel ? "  parallel" : "  serial" )
+					<< "  moved/frame " << Moved / a_Frames
+					<< "  ms/frame " << FrameTime << "\n";
+			}
+		}
+
+		TransformStorage::SetParallelThreshold( Threshold );
+
+		// Children go with their roots, once the engine ticks components.
+		for ( uint32_t i = 0; i < a_Count; i += Depth )
+		{
+			GameObject::Destroy( Objects[ i ] );
+		}
+	}
+}
+
+// Adds systems that each spin for a_Work milliseconds. Half of them only read Transform and can run
+// together, the other half write it and run one after another. The breakdown shows where each ran.
+inline void RunSystemBenchmark( uint32_t a_Frames = 100, float a_Work = 1.0f )
+{
+	std::ofstream Output = BeginBenchmark( "Systems, " + std::to_string( a_Frames ) + " frames, " + std::to_string( WorkerPool::GetThreadCount() ) + " threads" );
+
+	static float Work;
+	Work = a_Work;
+
+	Action<> Spin = []()
+	{
+		auto Start = std::chrono::high_resolution_clock::now();
+		while ( std::chrono::duration< float, std::milli >( std::chrono::high_resolution_clock::now() - Start ).count() < Work );
+	};
+
+	std::vector< SystemScheduler::SystemID > Added;
+
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		Added.push_back( SystemScheduler::AddSystem( "Reader " + std::to_string( i ), Spin ).Read< Transform >() );
+	}
+
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		Added.push_back( SystemScheduler::AddSystem( "Writer " + std::to_string( i ), Spin ).Write< Transform >() );
+	}
+
+	float FrameTime = TimeFrames( a_Frames, SystemScheduler::Tick );
+
+	Output << "  ms/frame " << FrameTime << ", serial " << Added.size() * a_Work << " ms/frame\n";
+	SystemScheduler::Describe( Output );
+
+	for ( SystemScheduler::SystemID System : Added )
+	{
+		SystemScheduler::SetSystemEnabled( System, false );
+	}
+}
+
+// Creates a_Count objects in chains of a_Depth each frame and destroys them by their roots. Only the
+// tick that flushes them is timed, which includes the scheduler's other systems.
+inline void RunDestroyBenchmark( uint32_t a_Frames = 20, uint32_t a_Count = 50000 )
+{
+	std::ofstream Output = BeginBenchmark( "Destruction, " + std::to_string( a_Count ) + " objects, " + std::to_string( a_Frames ) + " frames" );
+
+	std::vector< GameObject > Objects( a_Count );
+
+	for ( uint32_t Depth : { 1u, 16u } )
+	{
+		float Total = 0.0f;
+
+		for ( uint32_t Frame = 0; Frame < a_Frames; ++Frame )
+		{
+			for ( uint32_t i = 0; i < a_Count; ++i )
+			{
+				Objects[ i ] = i % Depth ? GameObject::Instantiate( Objects[ i - 1 ] ) : GameObject::Instantiate();
+			}
+
+			SystemScheduler::Tick();
+
+			for ( uint32_t i = 0; i < a_Count; i += Depth )
+			{
+				GameObject::Destroy( Objects[ i ] );
+			}
+
+			Total += TimeFrames( 1, SystemScheduler::Tick );
+		}
+
+		Output << "  depth " << Depth << "  ms/flush " << Total / a_Frames << "\n";
+	}
+}
+
+// Instantiates a_Count copies of a prefab each frame, one at a time and then all at once, destroying
+// them again between frames.
+inline void RunPrefabBenchmark( const Prefab& a_Prefab, uint32_t a_Frames = 20, uint32_t a_Count = 10000 )
+{
+	std::ofstream Output = BeginBenchmark( "Prefabs, " + std::to_string( a_Count ) + " instances, " + std::to_string( a_Frames ) + " frames" );
+
+	std::vector< GameObject > Roots;
+	Roots.reserve( a_Count );
+
+	for ( bool Batched : { false, true } )
+	{
+		float Total = 0.0f;
+
+		for ( uint32_t Frame = 0; Frame < a_Frames; ++Frame )
+		{
+			Roots.clear();
+
+			Total += TimeFrames( 1, [&]()
+			{
+				if ( Batched )
+				{
+					Prefab::InstantiateMany( a_Prefab, a_Count, Roots );
+					return;
+				}
+
+				for ( uint32_t i = 0; i < a_Count; ++i )
+				{
+					Roots.push_back( Prefab::Instantiate( a_Prefab ) );
+				}
+			} );
+
+			for ( GameObject Root : Roots )
+			{
+				GameObject::Destroy( Root );
+			}
+
+			SystemScheduler::Tick();
+		}
+
+		Output << ( Batched ? "  batched" : "  one at a time" ) << "  ms/frame " << Total / a_Frames << "\n";
+	}
+}
+
+// Collects MeshRenderers without a mesh, so the collect pass does little more than reach each one
+// and its Transform. Renderers are added in a shuffled order, so they don't line up with their
+// GameObjects or TransformStorage slots. Looked up one at a time, each renderer and Transform is
+// found through the registry. Walking the group reads both packed side by side. Hardware counters
+// can't be read from here, so cache misses show up as the time per renderer above what it took
+// while everything fit in cache.
+inline void RunGroupBenchmark( uint32_t a_Frames = 100 )
+{
+	std::ofstream Output = BeginBenchmark( "Groups, " + std::to_string( a_Frames ) + " frames" );
+
+	RenderGraph& Graph = RenderingPipeline::GetRenderGraph();
+	RenderGraph::PassID Collect = Graph.FindPass( "Collect" );
+	float Threshold = RenderingPipeline::GetGroupThreshold();
+	float InCache[ 2 ] = {};
+
+	for ( uint32_t Count : { 1000u, 10000u, 100000u, 400000u } )
+	{
+		std::vector< GameObject > Objects( Count );
+
+		for ( GameObject& Object : Objects )
+		{
+			Object = GameObject::Instantiate();
+		}
+
+		std::shuffle( Objects.begin(), Objects.end(), std::mt19937( 1 ) );
+
+		for ( GameObject Object : Objects )
+		{
+			Object.AddComponent< MeshRenderer >();
+		}
+
+		for ( bool Grouped : { false, true } )
+		{
+			RenderingPipeline::SetGroupThreshold( Grouped ? 0.0f : 2.0f );
+			RenderSceneFrame();
+			float CollectTime = 0.0f;
+
+			for ( uint32_t i = 0; i < a_Frames; ++i )
+			{
+				RenderSceneFrame();
+				CollectTime += Graph.GetPassTime( Collect );
+			}
+
+			float PerRenderer = CollectTime * 1000000.0f / ( static_cast< float >( a_Frames ) * Count );
+
+			if ( Count == 1000u )
+			{
+				InCache[ Grouped ] = PerRenderer;
+			}
+
+			Output
+				<< ( Grouped ? "  grouped" : "  lookup " )
+				<< "  renderers " << Count
+				<< "  collect ns/renderer " << PerRenderer
+				<< "  over in cache " << PerRenderer - InCache[ Grouped ] << "\n";
+		}
+
+		for ( GameObject Object : Objects )
+		{
+			GameObject::Destroy( Object );
+		}
+
+		SystemScheduler::Tick();
+	}
+
+	RenderingPipeline::SetGroupThreshold( Threshold );
+}
+
+// Runs the benchmark with the given name, as passed on the command line. Returns false if there is
+// no benchmark by that name.
+inline bool RunBenchmark( const std::string& a_Name )
+{
+	static const std::pair< const char*, void( * )() > Benchmarks[] =
+	{
+		{ "RenderScale",   []() { RunRenderScaleBenchmark(); } },
+		{ "RenderQueue",   []() { RunRenderQueueBenchmark(); } },
+		{ "Instancing",    []() { RunInstancingBenchmark( *Resource::Load< Prefab >( "spear"_H ) ); } },
+		{ "ParallelQueue", []() { RunParallelQueueBenchmark(); } },
+		{ "Culling",       []() { RunCullingBenchmark(); } },
+		{ "Occlusion",     []() { RunOcclusionBenchmark(); } },
+		{ "RenderGraph",   []() { RunRenderGraphBenchmark(); } },
+		{ "Shadow",        []() { RunShadowBenchmark(); } },
+		{ "Transform",     []() { RunTransformBenchmark(); } },
+		{ "System",        []() { RunSystemBenchmark(); } },
+		{ "Destroy",       []() { RunDestroyBenchmark(); } },
+		{ "Prefab",        []() { RunPrefabBenchmark( *Resource::Load< Prefab >( "spear"_H ) ); } },
+		{ "Group",         []() { RunGroupBenchmark(); } },
+	};
+
+	for ( const auto& Benchmark : Benchmarks )
+	{
+		if ( a_Name == Benchmark.first )
+		{
+			Benchmark.second();
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -3,6 +3,7 @@
 #include "GameObject.hpp"
 #include "Prefab.hpp"
 #include "CameraController.hpp"
+#include "Benchmarks.hpp"
 
 void InitializeScene()
 {
@@ -280,7 +281,7 @@ int RunCubeTest()
 
 
 
-int main()
+int main( int a_Argc, char** a_Argv )
 {
 	//RunCubeTest();
 
@@ -296,6 +297,12 @@ int main()
 	CameraObject.GetTransform()->SetLocalPosition( Vector3( 0.0f, 2.0f, -3.0f ) );
 	CameraObject.AddComponent< CameraController >();
 
+	// Lengine-Example <Benchmark> runs one of the benchmarks before the scene, see RunBenchmark.
+	if ( a_Argc > 1 )
+	{
+		RunBenchmark( a_Argv[ 1 ] );
+	}
+
 	Action<> GameLoop = [&]()
 	{
 		CameraObject.GetComponent< CameraController >()->Update();
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshSimplifier.hpp"
+
+// Sum of squared distances to a set of planes, as the symmetric 4x4 matrix of the plane equations.
+struct Quadric
+{
+	Quadric()
+		: XX( 0 ), XY( 0 ), XZ( 0 ), XW( 0 ), YY( 0 ), YZ( 0 ), YW( 0 ), ZZ( 0 ), ZW( 0 ), WW( 0 )
+	{ }
+
+	Quadric( double a_A, double a_B, double a_C, double a_D, double a_Weight )
+		: XX( a_A * a_A * a_Weight ), XY( a_A * a_B * a_Weight ), XZ( a_A * a_C * a_Weight ), XW( a_A * a_D * a_Weight )
+		, YY( a_B * a_B * a_Weight ), YZ( a_B * a_C * a_Weight ), YW( a_B * a_D * a_Weight )
+		, ZZ( a_C * a_C * a_Weight ), ZW( a_C * a_D * a_Weight )
+		, WW( a_D * a_D * a_Weight )
+	{ }
+
+	Quadric& operator+=( const Quadric& a_Other )
+	{
+		XX += a_Other.XX; XY += a_Other.XY; XZ += a_Other.XZ; XW += a_Other.XW;
+		YY += a_Other.YY; YZ += a_Other.YZ; YW += a_Other.YW;
+		ZZ += a_Other.ZZ; ZW += a_Other.ZW;
+		WW += a_Other.WW;
+		return *this;
+	}
+
+	double Evaluate( const Vector3& a_Point ) const
+	{
+		double X = a_Point.x, Y = a_Point.y, Z = a_Point.z;
+
+		return
+			XX * X * X + 2.0 * XY * X * Y + 2.0 * XZ * X * Z + 2.0 * XW * X +
+			YY * Y * Y + 2.0 * YZ * Y * Z + 2.0 * YW * Y +
+			ZZ * Z * Z + 2.0 * ZW * Z +
+			WW;
+	}
+
+	double XX, XY, XZ, XW, YY, YZ, YW, ZZ, ZW, WW;
+};
+
+// Moves From onto To. Entries are dropped when either vertex has changed since they were queued.
+struct Collapse
+{
+	bool operator>( const Collapse& a_Other ) const
+	{
+		return Cost > a_Other.Cost;
+	}
+
+	double   Cost;
+	uint32_t From;
+	uint32_t To;
+	uint32_t FromVersion;
+	uint32_t ToVersion;
+};
+
+// Cosine of the largest turn a triangle may make in a single collapse.
+static constexpr float MaxTurn = 0.25f;
+
+inline static uint64_t EdgeKey( uint32_t a_A, uint32_t a_B )
+{
+	return a_A < a_B ? uint64_t( a_A ) << 32 | a_B : uint64_t( a_B ) << 32 | a_A;
+}
+
+Mesh MeshSimplifier::Simplify( const Mesh& a_Source, float a_Ratio )
+{
+	uint32_t VertexCount = a_Source.GetVertexCount();
+	uint32_t TriangleCount = a_Source.GetIndexCount() / 3;
+	size_t Target = static_cast< size_t >( TriangleCount * Math::Clamp( a_Ratio, 0.0f, 1.0f ) );
+
+	if ( !a_Source.HasPositions() || Target >= TriangleCount )
+	{
+		return a_Source;
+	}
+
+	const std::vector< Vector3 >& Positions = a_Source.m_Positions;
+	std::vector< uint32_t > Indices( a_Source.m_Indices.begin(), a_Source.m_Indices.begin() + TriangleCount * 3 );
+	std::vector< Quadric > Quadrics( VertexCount );
+	std::vector< std::vector< uint32_t > > VertexTriangles( VertexCount );
+	std::unordered_map< uint64_t, uint32_t > EdgeUses;
+
+	// Each triangle adds its plane to its corners, weighted by area so slivers count for little.
+	for ( uint32_t t = 0; t < TriangleCount; ++t )
+	{
+		const uint32_t* Triangle = &Indices[ t * 3 ];
+		Vector3 Normal = Math::Cross( Positions[ Triangle[ 1 ] ] - Positions[ Triangle[ 0 ] ], Positions[ Triangle[ 2 ] ] - Positions[ Triangle[ 0 ] ] );
+		float Area = Math::Length( Normal );
+
+		if ( Area > 0.0f )
+		{
+			Normal = Normal / Area;
+			Quadric Plane( Normal.x, Normal.y, Normal.z, -Math::Dot( Normal, Positions[ Triangle[ 0 ] ] ), Area );
+
+			for ( uint32_t i = 0; i < 3; ++i )
+			{
+				Quadrics[ Triangle[ i ] ] += Plane;
+			}
+		}
+
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			VertexTriangles[ Triangle[ i ] ].push_back( t );
+			++EdgeUses[ EdgeKey( Triangle[ i ], Triangle[ ( i + 1 ) % 3 ] ) ];
+		}
+	}
+
+	// Edges used by a single triangle are open, either the outline of the mesh or a seam where
+	// vertices were split for differing attributes.
+	std::vector< bool > Locked( VertexCount, false );
+
+	for ( auto& [ Key, Uses ] : EdgeUses )
+	{
+		if ( Uses == 1 )
+		{
+			Locked[ static_cast< uint32_t >( Key >> 32 ) ] = true;
+			Locked[ static_cast< uint32_t >( Key ) ] = true;
+		}
+	}
+
+	std::vector< uint32_t > Versions( VertexCount, 0 );
+	std::vector< bool > Removed( VertexCount, false );
+	std::vector< bool > Degenerate( TriangleCount, false );
+	std::priority_queue< Collapse, std::vector< Collapse >, std::greater< Collapse > > Queue;
+
+	auto Push = [&]( uint32_t a_From, uint32_t a_To )
+	{
+		if ( !Locked[ a_From ] )
+		{
+			Quadric Combined = Quadrics[ a_From ];
+			Combined += Quadrics[ a_To ];
+			Queue.push( { Combined.Evaluate( Positions[ a_To ] ), a_From, a_To, Versions[ a_From ], Versions[ a_To ] } );
+		}
+	};
+
+	for ( auto& [ Key, Uses ] : EdgeUses )
+	{
+		Push( static_cast< uint32_t >( Key >> 32 ), static_cast< uint32_t >( Key ) );
+		Push( static_cast< uint32_t >( Key ), static_cast< uint32_t >( Key >> 32 ) );
+	}
+
+	// A collapse is allowed if From and To still share a triangle, and none of the triangles that
+	// only move would turn too far. Small turns add up over many collapses, so the limit is well
+	// short of a flip.
+	auto IsValid = [&]( uint32_t a_From, uint32_t a_To )
+	{
+		bool Shared = false;
+
+		for ( uint32_t t : VertexTriangles[ a_From ] )
+		{
+			if ( Degenerate[ t ] )
+			{
+				continue;
+			}
+
+			const uint32_t* Triangle = &Indices[ t * 3 ];
+
+			if ( Triangle[ 0 ] == a_To || Triangle[ 1 ] == a_To || Triangle[ 2 ] == a_To )
+			{
+				Shared = true;
+				continue;
+			}
+
+			Vector3 Corners[ 3 ] = { Positions[ Triangle[ 0 ] ], Positions[ Triangle[ 1 ] ], Positions[ Triangle[ 2 ] ] };
+			Vector3 Before = Math::Cross( Corners[ 1 ] - Corners[ 0 ], Corners[ 2 ] - Corners[ 0 ] );
+
+			for ( uint32_t i = 0; i < 3; ++i )
+			{
+				if ( Triangle[ i ] == a_From )
+				{
+					Corners[ i ] = Positions[ a_To ];
+				}
+			}
+
+			Vector3 After = Math::Cross( Corners[ 1 ] - Corners[ 0 ], Corners[ 2 ] - Corners[ 0 ] );
+
+			if ( Math::Dot( Before, After ) <= MaxTurn * Math::Length( Before ) * Math::Length( After ) )
+			{
+				return false;
+			}
+		}
+
+		return Shared;
+	};
+
+	size_t Remaining = TriangleCount;
+
+	while ( Remaining > Target && !Queue.empty() )
+	{
+		Collapse Next = Queue.top();
+		Queue.pop();
+
+		if ( Removed[ Next.From ] || Removed[ Next.To ] || Versions[ Next.From ] != Next.FromVersion || Versions[ Next.To ] != Next.ToVersion || !IsValid( Next.From, Next.To ) )
+		{
+			continue;
+		}
+
+		// Triangles on the edge collapse to nothing, the rest are handed over to To.
+		for ( uint32_t t : VertexTriangles[ Next.From ] )
+		{
+			if ( Degenerate[ t ] )
+			{
+				continue;
+			}
+
+			uint32_t* Triangle = &Indices[ t * 3 ];
+
+			if ( Triangle[ 0 ] == Next.To || Triangle[ 1 ] == Next.To || Triangle[ 2 ] == Next.To )
+			{
+				Degenerate[ t ] = true;
+				--Remaining;
+				continue;
+			}
+
+			for ( uint32_t i = 0; i < 3; ++i )
+			{
+				if ( Triangle[ i ] == Next.From )
+				{
+					Triangle[ i ] = Next.To;
+				}
+			}
+
+			VertexTriangles[ Next.To ].push_back( t );
+		}
+
+		Removed[ Next.From ] = true;
+		VertexTriangles[ Next.From ].clear();
+		Quadrics[ Next.To ] += Quadrics[ Next.From ];
+		++Versions[ Next.To ];
+
+		// Drop dead triangles from To, and requeue its edges with the combined quadric.
+		std::vector< uint32_t >& Triangles = VertexTriangles[ Next.To ];
+		Triangles.erase( std::remove_if( Triangles.begin(), Triangles.end(), [&]( uint32_t t ){ return Degenerate[ t ]; } ), Triangles.end() );
+
+		for ( uint32_t t : Triangles )
+		{
+			for ( uint32_t i = 0; i < 3; ++i )
+			{
+				uint32_t Neighbour = Indices[ t * 3 + i ];
+
+				if ( Neighbour != Next.To )
+				{
+					Push( Next.To, Neighbour );
+					Push( Neighbour, Next.To );
+				}
+			}
+		}
+	}
+
+	// Rebuild the mesh from the vertices that are still referenced.
+	std::vector< uint32_t > Remap( VertexCount, uint32_t( -1 ) );
+	std::vector< uint32_t > Kept;
+	Mesh Result;
+	Result.m_Indices.reserve( Remaining * 3 );
+
+	for ( uint32_t t = 0; t < TriangleCount; ++t )
+	{
+		if ( Degenerate[ t ] )
+		{
+			continue;
+		}
+
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			uint32_t& Index = Remap[ Indices[ t * 3 + i ] ];
+
+			if ( Index == uint32_t( -1 ) )
+			{
+				Index = static_cast< uint32_t >( Kept.size() );
+				Kept.push_back( Indices[ t * 3 + i ] );
+			}
+
+			Result.m_Indices.push_back( Index );
+		}
+	}
+
+	auto Gather = [&]( const auto& a_Source, auto& o_Destination )
+	{
+		if ( a_Source.empty() )
+		{
+			return;
+		}
+
+		o_Destination.resize( Kept.size() );
+
+		for ( size_t i = 0; i < Kept.size(); ++i )
+		{
+			o_Destination[ i ] = a_Source[ Kept[ i ] ];
+		}
+	};
+
+	Gather( a_Source.m_Positions, Result.m_Positions );
+	Gather( a_Source.m_Normals, Result.m_Normals );
+	Gather( a_Source.m_Tangents, Result.m_Tangents );
+	Gather( a_Source.m_Bitangents, Result.m_Bitangents );
+
+	for ( uint32_t i = 0; i < 8; ++i )
+	{
+		Gather( a_Source.m_Texels[ i ], Result.m_Texels[ i ] );
+		Gather( a_Source.m_Colours[ i ], Result.m_Colours[ i ] );
+	}
+
+	return Result;
+}
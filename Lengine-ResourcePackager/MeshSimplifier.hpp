@@ -0,0 +1,14 @@
+#pragma once
+#include "Mesh.hpp"
+
+// Reduces meshes by collapsing edges in order of least quadric error. Every collapse moves a vertex
+// onto one of its neighbours, so the vertices that remain keep their original attributes. Vertices
+// on open edges are never moved, which keeps outlines and texture seams in place.
+class MeshSimplifier
+{
+public:
+
+	// a_Ratio is the fraction of triangles to keep. Simplification stops early if no collapse is left
+	// that wouldn't flip a triangle.
+	static Mesh Simplify( const Mesh& a_Source, float a_Ratio );
+};
@@ -21,6 +21,7 @@
 #include "Material.hpp"
 #include "AudioClip.hpp"
 #include "SfxrClip.hpp"
+#include "MeshSimplifier.hpp"
 
 // Component types
 #include "Transform.hpp"
@@ -120,6 +121,9 @@ struct ResourceEntry
 	std::string ResourceFilePath;
 	std::string ResourceName;
 	const void* ResourceSource;
+
+	// Simplification ratio and screen size of each level of detail generated for meshes.
+	std::vector< std::pair< float, float > > LODs;
 };
 
 void ValidateResources( Json& a_Resources )
@@ -145,6 +149,13 @@ void ValidateResources( Json& a_Resources )
 			*ThisIndex = 0;
 		}
 
+		auto ThisLODs = Begin->find( "LODs" );
+
+		if ( ThisLODs != Begin->end() && !ThisLODs->is_array() )
+		{
+			Begin->erase( ThisLODs );
+		}
+
 		*ThisPath = ConvertPath( ThisPath->get< std::string >().c_str() );
 		*ThisType = ConvertToType( ThisType->get< std::string >() );
 	}
@@ -193,6 +204,7 @@ File ProcessResourceEntry( ResourceEntry& a_Entry, Directory& a_TempDirectory )
 						NewMesh.ResourceName = a_Entry.ResourceName + "_mesh" + std::to_string( i );
 						NewMesh.ResourceType = 2; /*MESH*/
 						NewMesh.ResourceSource = a_Entry.ResourceSource;
+						NewMesh.LODs = a_Entry.LODs;
 						TempMeshes.push_back( ProcessResourceEntry( NewMesh, a_TempDirectory ) );
 					}
 
@@ -225,11 +237,17 @@ File ProcessResourceEntry( ResourceEntry& a_Entry, Directory& a_TempDirectory )
 							Comp.SetLocalScale( Scale );
 							a_Prefab.AddComponent( Comp );
 						};
-					static auto AttachMeshRenderer = [&]( Prefab& a_Prefab, Hash a_Mesh, Hash a_Material )
+					static auto AttachMeshRenderer = [&]( Prefab& a_Prefab, const std::string& a_Mesh, Hash a_Material, const std::vector< std::pair< float, float > >& a_LODs )
 						{
 							MeshRenderer Comp;
-							Comp.SetMesh( ResourceHandle< Mesh >( a_Mesh ) );
+							Comp.SetMesh( ResourceHandle< Mesh >( CRC32_RT( a_Mesh.c_str() ) ) );
 							Comp.SetMaterial( ResourceHandle< Material >( a_Material ) );
+
+							for ( size_t i = 0; i < a_LODs.size(); ++i )
+							{
+								Comp.AddLOD( ResourceHandle< Mesh >( CRC32_RT( ( a_Mesh + "_lod" + std::to_string( i + 1 ) ).c_str() ) ), a_LODs[ i ].second );
+							}
+
 							a_Prefab.AddComponent( Comp );
 						};
 					static auto AttachCamera = [&]( Prefab& a_Prefab, aiCamera* a_Camera )
@@ -262,9 +280,9 @@ File ProcessResourceEntry( ResourceEntry& a_Entry, Directory& a_TempDirectory )
 							AttachAlias( NewChild, NewChildName );
 							AttachTransform( NewChild, aiMatrix4x4() );
 							uint32_t MeshIndex = a_Node->mMeshes[ i ];
-							Hash MeshName = CRC32_RT( TempMeshes[ MeshIndex ].GetStem().c_str() );
+							std::string MeshName = TempMeshes[ MeshIndex ].GetStem();
 							Hash MaterialName = CRC32_RT( TempMaterials[ a_Scene->mMeshes[ MeshIndex ]->mMaterialIndex ].GetStem().c_str() );
-							AttachMeshRenderer( o_Prefab, MeshName, MaterialName );
+							AttachMeshRenderer( o_Prefab, MeshName, MaterialName, a_Entry.LODs );
 						}
 
 						for ( uint32_t i = 0; i < a_Node->mNumChildren; ++i )
@@ -415,6 +433,19 @@ File ProcessResourceEntry( ResourceEntry& a_Entry, Directory& a_TempDirectory )
 						}
 					}
 
+					// Levels of detail are simplified from the full mesh and stored beside it as <name>_lod<i>.
+					for ( size_t i = 0; i < a_Entry.LODs.size(); ++i )
+					{
+						std::string LODName = a_Entry.ResourceName + "_lod" + std::to_string( i + 1 );
+						Mesh ThisLOD = MeshSimplifier::Simplify( ThisMesh, a_Entry.LODs[ i ].first );
+						ThisLOD.SetName( LODName );
+						File LODTemp = a_TempDirectory.NewFile( ( LODName + ConvertToExtension( a_Entry.ResourceType ) ).c_str(), Serialization::GetSizeOf( ThisLOD ) );
+						LODTemp.Open();
+						FileSerializer LODSerializer( LODTemp );
+						LODSerializer << ThisLOD;
+						LODTemp.Close();
+					}
+
 					File ThisTemp = a_TempDirectory.NewFile( ( a_Entry.ResourceName + ConvertToExtension( a_Entry.ResourceType ) ).c_str(), Serialization::GetSizeOf( ThisMesh ) );
 					ThisTemp.Open();
 					FileSerializer Serializer( ThisTemp );
@@ -636,6 +667,14 @@ bool ResourcePackager::Build() const
 		Entry.ResourceName = Begin.key();
 		Entry.ResourceType = Begin->find( "Type" )->get< uint32_t >();
 		Entry.ResourceSource = nullptr;
+
+		if ( auto ThisLODs = Begin->find( "LODs" ); ThisLODs != Begin->end() )
+		{
+			for ( auto& LOD : *ThisLODs )
+			{
+				Entry.LODs.emplace_back( LOD.value( "Ratio", 1.0f ), LOD.value( "ScreenSize", 0.0f ) );
+			}
+		}
 		ProcessResourceEntry( Entry, TempDirectory );
 	}
 